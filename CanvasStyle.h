@@ -0,0 +1,25 @@
+#pragma once
+
+#include "imgui.h"
+
+// Look of nodes and edges on the graph canvas, shared by the editor and image export
+// (GraphExport) so an exported picture matches what is on screen. Sizes are graph units
+// scaled with the zoom; outline widths and labels are screen pixels.
+const float NODE_RADIUS = 30.0f;
+const ImU32 NODE_COLOR = IM_COL32(100, 150, 250, 255);
+const ImU32 NODE_SELECTED_COLOR = IM_COL32(250, 100, 100, 255);
+const ImU32 NODE_OUTLINE_COLOR = IM_COL32(255, 255, 255, 100);
+const float NODE_OUTLINE_THICKNESS = 2.0f;
+const float STATUS_OUTLINE_THICKNESS = 4.0f;    // unreachable and dead-end outlines
+const ImU32 UNREACHABLE_COLOR = IM_COL32(250, 200, 50, 255);
+const ImU32 DEAD_END_COLOR = IM_COL32(250, 60, 60, 255);
+const ImU32 EDGE_COLOR = IM_COL32(200, 200, 200, 255);
+const ImU32 EDGE_SELECTED_COLOR = IM_COL32(250, 150, 50, 255);
+const float EDGE_THICKNESS = 2.0f;
+const float ARROW_SIZE = 10.0f;
+const float ARROW_ANGLE = 0.5f;                 // radians between the shaft and each barb
+const float CURVE_BULGE = 50.0f;                // max offset of a bidirectional edge's curve
+const ImU32 LABEL_COLOR = IM_COL32(255, 255, 255, 255);
+const ImU32 LABEL_BG_COLOR = IM_COL32(30, 30, 30, 200);
+const float LABEL_PADDING = 2.0f;               // around edge weights
+const ImU32 CANVAS_BG_COLOR = IM_COL32(50, 50, 50, 255);
@@ -0,0 +1,644 @@
+#include "ConflictSimulator.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <queue>
+
+namespace {
+
+const double NEVER = std::numeric_limits<double>::infinity();
+const float UNREACHED = std::numeric_limits<float>::infinity();
+
+// Both directions of an edge are the same lane
+uint64_t laneKey(uint32_t a, uint32_t b) {
+    return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+}
+
+// A space held by an agent from start until end, with what the agent was doing there
+struct Occupancy {
+    uint32_t space;
+    uint32_t agent;
+    double start;
+    double end;
+    uint32_t from;
+    uint32_t to;
+};
+
+// Part of a route relative to its departure: an edge, or a node passed on the way (from == to)
+struct Leg {
+    uint32_t space;
+    double start;
+    double end;
+    uint32_t from;
+    uint32_t to;
+};
+
+// What each space is booked for from the current time on, for replanning. Planning times
+// only grow, so bookings that are over are dropped whenever a space is looked at.
+class ReservationTable {
+public:
+    void resize(size_t spaceCount) {
+        active.resize(spaceCount);
+        parked.resize(spaceCount);
+    }
+
+    void reserve(uint32_t space, double start, double end, uint32_t agent) {
+        active[space].push_back({ start, end, agent });
+    }
+
+    void park(uint32_t space, double since, uint32_t agent) {
+        parked[space].push_back({ since, NEVER, agent });
+    }
+
+    void unpark(uint32_t space, uint32_t agent) {
+        auto& list = parked[space];
+        list.erase(std::remove_if(list.begin(), list.end(),
+            [agent](const Booking& booking) { return booking.agent == agent; }), list.end());
+    }
+
+    // Latest end of the other agents' bookings that overlap [start, end): -infinity when the
+    // space is free, infinity when 'parkedAgent' is parked there by then
+    double blockedUntil(uint32_t space, double start, double end, uint32_t agent, double now, uint32_t& parkedAgent) {
+        for (const auto& booking : parked[space]) {
+            if (booking.agent != agent && end > booking.start) {
+                parkedAgent = booking.agent;
+                return NEVER;
+            }
+        }
+        double until = -NEVER;
+        auto& list = active[space];
+        for (size_t i = 0; i < list.size();) {
+            const Booking& booking = list[i];
+            if (booking.end <= now) {
+                list[i] = list.back();
+                list.pop_back();
+                continue;
+            }
+            if (booking.agent != agent && booking.start < end && booking.end > start) {
+                until = std::max(until, booking.end);
+            }
+            ++i;
+        }
+        return until;
+    }
+
+private:
+    struct Booking {
+        double start;
+        double end;
+        uint32_t agent;
+    };
+
+    std::vector<std::vector<Booking>> active;
+    std::vector<std::vector<Booking>> parked;
+};
+
+// Union-find over spaces, for shared zones
+uint32_t findSpace(std::vector<uint32_t>& parent, uint32_t space) {
+    while (parent[space] != space) {
+        parent[space] = parent[parent[space]];
+        space = parent[space];
+    }
+    return space;
+}
+
+} // namespace
+
+bool SimSchedule::load(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        return false;
+    }
+
+    try {
+        nlohmann::json data = nlohmann::json::parse(file);
+        agents.clear();
+        requests.clear();
+        sharedZones.clear();
+
+        std::unordered_map<std::string, size_t> agentIndex;
+        for (const auto& item : data.at("agents")) {
+            SimAgent agent;
+            agent.name = item.at("name").get<std::string>();
+            agent.graph = item.at("graph").get<std::string>();
+            agent.start = item.at("start").get<std::string>();
+            if (!agentIndex.emplace(agent.name, agents.size()).second) {
+                std::cerr << "Duplicate agent " << agent.name << " in " << filename << std::endl;
+                return false;
+            }
+            agents.push_back(std::move(agent));
+        }
+
+        if (data.contains("zones")) {
+            for (const auto& item : data["zones"]) {
+                std::vector<CrossGraphStep> zone;
+                for (const auto& member : item) {
+                    zone.push_back({ member.at("graph").get<std::string>(), member.at("node").get<std::string>() });
+                }
+                sharedZones.push_back(std::move(zone));
+            }
+        }
+
+        const auto& items = data.at("requests");
+        requests.reserve(items.size());
+        for (const auto& item : items) {
+            auto it = agentIndex.find(item.at("agent").get<std::string>());
+            if (it == agentIndex.end()) {
+                std::cerr << "Request for unknown agent " << item.at("agent").get<std::string>() << " in "
+                    << filename << std::endl;
+                return false;
+            }
+            SimRequest request;
+            request.agent = it->second;
+            request.time = item.value("time", 0.0);
+            request.target = item.at("to").get<std::string>();
+            requests.push_back(std::move(request));
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error loading schedule " << filename << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void SimulationResult::positionAt(size_t agent, double time, uint32_t& from, uint32_t& to, float& progress) const {
+    const auto& list = moves[agent];
+    auto it = std::upper_bound(list.begin(), list.end(), time,
+        [](double t, const SimMove& move) { return t < move.depart; });
+    progress = 0.0f;
+    if (it == list.begin()) {
+        from = to = startSlots[agent];
+        return;
+    }
+    const SimMove& move = *(it - 1);
+    if (time < move.arrive) {
+        from = move.from;
+        to = move.to;
+        progress = static_cast<float>((time - move.depart) / (move.arrive - move.depart));
+        return;
+    }
+    from = to = move.to;
+}
+
+ConflictSimulator::GraphState* ConflictSimulator::prepare(GraphModel& model, const std::string& name) {
+    auto graph = model.getGraph(name);
+    if (!graph) {
+        return nullptr;
+    }
+
+    // Distance trees stay valid for as long as the routing snapshot does
+    GraphState& state = graphs[name];
+    auto snapshot = routeCacheOf(*graph).snapshot(*graph);
+    if (state.graph != graph || state.snapshot != snapshot) {
+        state.graph = graph;
+        state.snapshot = snapshot;
+        state.trees.clear();
+    }
+    return &state;
+}
+
+const std::vector<float>& ConflictSimulator::treeTo(GraphState& state, uint32_t target) {
+    auto it = state.trees.find(target);
+    if (it == state.trees.end()) {
+        it = state.trees.emplace(target, std::vector<float>()).first;
+        computeDistances(*state.snapshot, target, true, std::vector<uint32_t>(), it->second);
+    }
+    return it->second;
+}
+
+bool ConflictSimulator::shortestPath(GraphState& state, uint32_t source, uint32_t target, std::vector<uint32_t>& path) {
+    const std::vector<float>& dist = treeTo(state, target);
+    const RoutingSnapshot& snapshot = *state.snapshot;
+    path.clear();
+    if (dist[source] == UNREACHED) {
+        return false;
+    }
+
+    // Each hop takes the out-edge that realizes the remaining distance; the length limit
+    // stops a walk around a cycle of zero-weight edges
+    path.push_back(source);
+    uint32_t v = source;
+    while (v != target && path.size() <= dist.size()) {
+        uint32_t next = UINT32_MAX;
+        float best = UNREACHED;
+        for (uint32_t e = snapshot.offsets[v]; e < snapshot.offsets[v + 1]; ++e) {
+            float cost = snapshot.weights[e] + dist[snapshot.targets[e]];
+            if (cost < best) {
+                best = cost;
+                next = snapshot.targets[e];
+            }
+        }
+        if (next == UINT32_MAX) {
+            return false;
+        }
+        v = next;
+        path.push_back(v);
+    }
+    return v == target;
+}
+
+bool ConflictSimulator::detour(GraphState& state, uint32_t source, uint32_t target, const std::vector<char>& avoid,
+    std::vector<uint32_t>& path) {
+    // A* with the distance tree to the target as heuristic: exact without the avoided nodes,
+    // and never too high with them, so the search mostly follows the way around them
+    const std::vector<float>& remaining = treeTo(state, target);
+    const RoutingSnapshot& snapshot = *state.snapshot;
+    std::vector<float>& dist = state.detourDist;
+    std::vector<uint32_t>& previous = state.detourPrevious;
+    dist.assign(avoid.size(), UNREACHED);
+    previous.assign(avoid.size(), UINT32_MAX);
+
+    using Entry = std::pair<float, uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    dist[source] = 0.0f;
+    queue.emplace(remaining[source], source);
+    while (!queue.empty()) {
+        Entry top = queue.top();
+        queue.pop();
+        uint32_t v = top.second;
+        if (v == target) {
+            break;
+        }
+        if (top.first > dist[v] + remaining[v]) {
+            continue;
+        }
+        for (uint32_t e = snapshot.offsets[v]; e < snapshot.offsets[v + 1]; ++e) {
+            uint32_t next = snapshot.targets[e];
+            float cost = dist[v] + snapshot.weights[e];
+            if ((!avoid[next] || next == target) && cost < dist[next] && remaining[next] != UNREACHED) {
+                dist[next] = cost;
+                previous[next] = v;
+                queue.emplace(cost + remaining[next], next);
+            }
+        }
+    }
+
+    path.clear();
+    if (dist[target] == UNREACHED) {
+        return false;
+    }
+    for (uint32_t v = target; v != UINT32_MAX; v = previous[v]) {
+        path.push_back(v);
+    }
+    std::reverse(path.begin(), path.end());
+    return true;
+}
+
+bool ConflictSimulator::run(GraphModel& model, const SimSchedule& schedule, const SimulationOptions& options,
+    SimulationResult& result) {
+    PROFILE_SCOPE("ConflictSimulator::run");
+    result = SimulationResult();
+    for (auto& pair : graphs) {
+        pair.second.nodeSpace.clear();
+        pair.second.edgeSpace.clear();
+    }
+
+    // Agents, and a space for every node of the graphs they move on
+    struct AgentState {
+        GraphState* state = nullptr;
+        uint32_t node = 0;
+        double parkedSince = 0.0;
+        std::vector<size_t> requests;
+        size_t next = 0;
+        double eligibleAt = 0.0;    // when the current request could first have started
+        double wakeAt = NEVER;      // when the agent next plans a route
+        bool retrying = false;
+    };
+    std::vector<AgentState> agents(schedule.agents.size());
+    uint32_t spaceCount = 0;
+    for (size_t a = 0; a < schedule.agents.size(); ++a) {
+        const SimAgent& agent = schedule.agents[a];
+        GraphState* state = prepare(model, agent.graph);
+        if (!state) {
+            std::cerr << "Agent " << agent.name << " is on unknown graph " << agent.graph << std::endl;
+            return false;
+        }
+        auto start = state->graph->nodeIndex.find(agent.start);
+        if (start == state->graph->nodeIndex.end()) {
+            std::cerr << "Agent " << agent.name << " starts at unknown node " << agent.start << std::endl;
+            return false;
+        }
+        if (state->nodeSpace.empty()) {
+            state->nodeSpace.resize(state->graph->nodes.size());
+            std::iota(state->nodeSpace.begin(), state->nodeSpace.end(), spaceCount);
+            spaceCount += static_cast<uint32_t>(state->graph->nodes.size());
+        }
+        agents[a].state = state;
+        agents[a].node = static_cast<uint32_t>(start->second);
+        result.agentNames.push_back(agent.name);
+        result.agentGraphs.push_back(agent.graph);
+        result.graphVersions.push_back(state->graph->topologyVersion);
+        result.startSlots.push_back(agents[a].node);
+    }
+    result.moves.resize(agents.size());
+
+    // Nodes of a shared zone become one space; members on graphs without agents are ignored
+    std::vector<uint32_t> parent(spaceCount);
+    std::iota(parent.begin(), parent.end(), 0);
+    for (const auto& zone : schedule.sharedZones) {
+        uint32_t first = UINT32_MAX;
+        for (const auto& member : zone) {
+            auto it = graphs.find(member.graph);
+            if (it == graphs.end() || it->second.nodeSpace.empty()) {
+                continue;
+            }
+            auto node = it->second.graph->nodeIndex.find(member.node);
+            if (node == it->second.graph->nodeIndex.end()) {
+                continue;
+            }
+            uint32_t space = findSpace(parent, it->second.nodeSpace[node->second]);
+            if (first == UINT32_MAX) {
+                first = space;
+            }
+            else {
+                parent[space] = first;
+            }
+        }
+    }
+    for (auto& pair : graphs) {
+        for (auto& space : pair.second.nodeSpace) {
+            space = findSpace(parent, space);
+        }
+    }
+
+    // Each agent works through its own requests in time order
+    std::vector<size_t> order(schedule.requests.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&schedule](size_t a, size_t b) {
+        return schedule.requests[a].time < schedule.requests[b].time;
+    });
+    for (size_t index : order) {
+        size_t agent = schedule.requests[index].agent;
+        if (agent >= agents.size()) {
+            std::cerr << "Request " << index << " names agent " << agent << " of " << agents.size() << std::endl;
+            return false;
+        }
+        agents[agent].requests.push_back(index);
+    }
+
+    using Event = std::pair<double, uint32_t>;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+    for (uint32_t a = 0; a < agents.size(); ++a) {
+        if (!agents[a].requests.empty()) {
+            agents[a].wakeAt = schedule.requests[agents[a].requests[0]].time;
+            events.emplace(agents[a].wakeAt, a);
+        }
+    }
+
+    ReservationTable reservations;
+    reservations.resize(spaceCount);
+    for (uint32_t a = 0; a < agents.size(); ++a) {
+        reservations.park(agents[a].state->nodeSpace[agents[a].node], -NEVER, a);
+        agents[a].parkedSince = -NEVER;
+    }
+    std::vector<Occupancy> occupancy;
+
+    // Time-expands a route into legs; the last leg is the target node
+    auto expand = [&](GraphState& state, const std::vector<uint32_t>& path, std::vector<Leg>& legs) {
+        const RoutingSnapshot& snapshot = *state.snapshot;
+        legs.clear();
+        double time = 0.0;
+        for (size_t i = 1; i < path.size(); ++i) {
+            float weight = UNREACHED;
+            for (uint32_t e = snapshot.offsets[path[i - 1]]; e < snapshot.offsets[path[i - 1] + 1]; ++e) {
+                if (snapshot.targets[e] == path[i]) {
+                    weight = std::min(weight, snapshot.weights[e]);
+                }
+            }
+            double duration = weight * options.secondsPerWeight;
+            auto lane = state.edgeSpace.emplace(laneKey(path[i - 1], path[i]), spaceCount);
+            if (lane.second) {
+                reservations.resize(++spaceCount);
+            }
+            legs.push_back({ lane.first->second, time, time + duration, path[i - 1], path[i] });
+            time += duration;
+            legs.push_back({ state.nodeSpace[path[i]], time, time + options.nodeClearance, path[i], path[i] });
+        }
+        // The agent stays at its target until its next request
+        legs.back().end = NEVER;
+    };
+
+    // Earliest wait at the start node after which no leg overlaps another agent's booking;
+    // 'blocker' is the parked agent in the way when there is none
+    auto earliestStart = [&](const std::vector<Leg>& legs, uint32_t agent, double now, double& wait,
+        uint32_t& blocker) {
+        wait = 0.0;
+        blocker = UINT32_MAX;
+        bool moved = true;
+        while (moved) {
+            moved = false;
+            for (const Leg& leg : legs) {
+                double until = reservations.blockedUntil(leg.space, now + wait + leg.start, now + wait + leg.end,
+                    agent, now, blocker);
+                if (until == NEVER) {
+                    return false;
+                }
+                if (until > now + wait + leg.start) {
+                    wait = until - now - leg.start;
+                    moved = true;
+                    if (wait > options.maxWait) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    };
+
+    auto book = [&](uint32_t space, uint32_t agent, double start, double end, uint32_t from, uint32_t to) {
+        if (end > start) {
+            occupancy.push_back({ space, agent, start, end, from, to });
+            if (options.replan) {
+                reservations.reserve(space, start, end, agent);
+            }
+        }
+    };
+
+    std::vector<uint32_t> path;
+    std::vector<uint32_t> candidate;
+    std::vector<Leg> legs;
+    std::vector<Leg> candidateLegs;
+    std::vector<char> avoid;
+    while (!events.empty()) {
+        double now = events.top().first;
+        uint32_t a = events.top().second;
+        events.pop();
+        AgentState& agent = agents[a];
+        GraphState& state = *agent.state;
+        const SimRequest& request = schedule.requests[agent.requests[agent.next]];
+        if (!agent.retrying) {
+            agent.eligibleAt = now;
+        }
+        agent.retrying = false;
+
+        auto target = state.graph->nodeIndex.find(request.target);
+        if (target == state.graph->nodeIndex.end() ||
+            !shortestPath(state, agent.node, static_cast<uint32_t>(target->second), path)) {
+            ++result.failed;
+            path.clear();
+        }
+
+        double wait = 0.0;
+        bool rerouted = false;
+        if (options.replan && path.size() > 1) {
+            expand(state, path, legs);
+
+            // Keep the shortest route if it is clear now, else take whichever candidate
+            // arrives first once clear
+            double bestArrival = NEVER;
+            uint32_t blocker;
+            if (earliestStart(legs, a, now, wait, blocker)) {
+                bestArrival = now + wait + legs.back().start;
+            }
+            auto consider = [&]() {
+                if (candidate == path) {
+                    return;
+                }
+                expand(state, candidate, candidateLegs);
+                double candidateWait;
+                uint32_t candidateBlocker;
+                if (earliestStart(candidateLegs, a, now, candidateWait, candidateBlocker) &&
+                    now + candidateWait + candidateLegs.back().start < bestArrival) {
+                    bestArrival = now + candidateWait + candidateLegs.back().start;
+                    wait = candidateWait;
+                    path.swap(candidate);
+                    legs.swap(candidateLegs);
+                    rerouted = true;
+                }
+            };
+            if (blocker != UINT32_MAX) {
+                // The shortest route around the nodes where other agents wait
+                avoid.assign(state.graph->nodes.size(), 0);
+                for (uint32_t other = 0; other < agents.size(); ++other) {
+                    if (other != a && agents[other].state == &state) {
+                        avoid[agents[other].node] = 1;
+                    }
+                }
+                if (detour(state, agent.node, path.back(), avoid, candidate)) {
+                    consider();
+                }
+            }
+            if (bestArrival == NEVER && options.alternatives > 1) {
+                auto routes = findKShortestPaths(*state.graph, state.graph->nodes[agent.node]->id,
+                    request.target, options.alternatives);
+                for (const auto& route : routes) {
+                    candidate.clear();
+                    for (const auto& id : route.nodes) {
+                        candidate.push_back(static_cast<uint32_t>(state.graph->nodeIndex[id]));
+                    }
+                    consider();
+                }
+            }
+
+            if (bestArrival == NEVER) {
+                // Try again once the agent parked on the shortest route moves on, if it
+                // ever does, or a little later when the route was only busy for too long
+                double retry = now + options.retryInterval;
+                if (blocker != UINT32_MAX) {
+                    retry = std::max(retry, agents[blocker].wakeAt);
+                }
+                if (retry - agent.eligibleAt <= options.maxWait) {
+                    agent.retrying = true;
+                    agent.wakeAt = retry;
+                    events.emplace(retry, a);
+                    continue;
+                }
+                // Nothing clears in time: take the shortest route anyway, the sweep will report it
+                ++result.unresolved;
+                wait = 0.0;
+            }
+            else {
+                result.rerouted += rerouted ? 1 : 0;
+                result.delayed += wait > 0.0 || now > agent.eligibleAt ? 1 : 0;
+            }
+        }
+
+        double freeAt = now;
+        if (!path.empty()) {
+            ++result.routed;
+        }
+        if (path.size() > 1) {
+            if (!options.replan) {
+                expand(state, path, legs);
+            }
+
+            // The start node is held until the agent has cleared it, the target from arrival on
+            double depart = now + wait;
+            uint32_t startSpace = state.nodeSpace[agent.node];
+            reservations.unpark(startSpace, a);
+            book(startSpace, a, agent.parkedSince, depart + options.nodeClearance, agent.node, agent.node);
+            for (size_t i = 0; i + 1 < legs.size(); ++i) {
+                const Leg& leg = legs[i];
+                book(leg.space, a, depart + leg.start, depart + leg.end, leg.from, leg.to);
+                if (leg.from != leg.to) {
+                    result.moves[a].push_back({ leg.from, leg.to, depart + leg.start, depart + leg.end });
+                }
+            }
+            agent.node = path.back();
+            agent.parkedSince = depart + legs.back().start;
+            reservations.park(state.nodeSpace[agent.node], agent.parkedSince, a);
+            freeAt = agent.parkedSince;
+            result.makespan = std::max(result.makespan, freeAt);
+        }
+
+        agent.wakeAt = NEVER;
+        if (++agent.next < agent.requests.size()) {
+            agent.wakeAt = std::max(schedule.requests[agent.requests[agent.next]].time, freeAt);
+            events.emplace(agent.wakeAt, a);
+        }
+    }
+    for (uint32_t a = 0; a < agents.size(); ++a) {
+        book(agents[a].state->nodeSpace[agents[a].node], a, agents[a].parkedSince, NEVER, agents[a].node, agents[a].node);
+    }
+
+    // Sweep every space in time order: whoever is still inside when another agent enters
+    // is in conflict with it. Bucketing by space first leaves only short lists to sort.
+    PROFILE_SCOPE("ConflictSimulator::sweep");
+    std::vector<size_t> bucket(spaceCount + 1, 0);
+    for (const Occupancy& entry : occupancy) {
+        ++bucket[entry.space + 1];
+    }
+    std::partial_sum(bucket.begin(), bucket.end(), bucket.begin());
+    std::vector<Occupancy> bySpace(occupancy.size());
+    std::vector<size_t> fill(bucket.begin(), bucket.end() - 1);
+    for (const Occupancy& entry : occupancy) {
+        bySpace[fill[entry.space]++] = entry;
+    }
+
+    std::vector<const Occupancy*> inside;
+    for (uint32_t space = 0; space < spaceCount; ++space) {
+        auto first = bySpace.begin() + bucket[space];
+        auto last = bySpace.begin() + bucket[space + 1];
+        std::sort(first, last, [](const Occupancy& a, const Occupancy& b) { return a.start < b.start; });
+        inside.clear();
+        for (auto it = first; it != last; ++it) {
+            const Occupancy& entry = *it;
+            inside.erase(std::remove_if(inside.begin(), inside.end(),
+                [&entry](const Occupancy* other) { return other->end <= entry.start; }), inside.end());
+            for (const Occupancy* other : inside) {
+                if (other->agent != entry.agent) {
+                    SimConflict conflict;
+                    conflict.begin = entry.start;
+                    conflict.end = std::min(entry.end, other->end);
+                    conflict.agents[0] = other->agent;
+                    conflict.agents[1] = entry.agent;
+                    conflict.from[0] = other->from;
+                    conflict.to[0] = other->to;
+                    conflict.from[1] = entry.from;
+                    conflict.to[1] = entry.to;
+                    result.conflicts.push_back(conflict);
+                }
+            }
+            inside.push_back(&entry);
+        }
+    }
+    std::stable_sort(result.conflicts.begin(), result.conflicts.end(),
+        [](const SimConflict& a, const SimConflict& b) { return a.begin < b.begin; });
+    return true;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "GraphModel.h"
+#include "GraphRouting.h"
+#include "CrossGraphRouter.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A machine that moves on one graph
+struct SimAgent {
+    std::string name;
+    std::string graph;
+    std::string start;
+};
+
+// Move an agent to a node of its graph, no earlier than 'time' (seconds) and not before
+// the agent has finished its previous request
+struct SimRequest {
+    size_t agent = 0;
+    double time = 0.0;
+    std::string target;
+};
+
+// Agents, their route requests, and groups of nodes that are the same physical space (for
+// example a gantry station above a hexapod position), possibly in different graphs
+struct SimSchedule {
+    std::vector<SimAgent> agents;
+    std::vector<SimRequest> requests;
+    std::vector<std::vector<CrossGraphStep>> sharedZones;
+
+    // {"agents": [{"name", "graph", "start"}], "requests": [{"agent", "time", "to"}],
+    //  "zones": [[{"graph", "node"}, ...]]}; requests name their agent
+    bool load(const std::string& filename);
+};
+
+struct SimulationOptions {
+    double secondsPerWeight = 1.0;  // an edge takes weight * secondsPerWeight to traverse
+    double nodeClearance = 0.25;    // seconds a node stays occupied after an agent left it
+    bool replan = false;            // plan around the reservations instead of only reporting
+    size_t alternatives = 3;        // replan: routes tried per request, shortest first
+    double maxWait = 60.0;          // replan: longest wait at the start node for a route to clear
+    double retryInterval = 0.5;     // replan: wait before trying a route blocked by a parked agent again
+};
+
+// One edge traversal of an agent
+struct SimMove {
+    uint32_t from = 0;
+    uint32_t to = 0;
+    double depart = 0.0;
+    double arrive = 0.0;
+};
+
+// Two agents in the same space at once. Each side is the node (from == to) or the edge
+// the agent occupied, as slots of that agent's graph.
+struct SimConflict {
+    double begin = 0.0;
+    double end = 0.0;
+    uint32_t agents[2] = {};
+    uint32_t from[2] = {};
+    uint32_t to[2] = {};
+};
+
+struct SimulationResult {
+    std::vector<std::string> agentNames;
+    std::vector<std::string> agentGraphs;
+    std::vector<uint64_t> graphVersions;        // per agent: topology version the slots belong to
+    std::vector<uint32_t> startSlots;
+    std::vector<std::vector<SimMove>> moves;    // per agent, in time order
+    std::vector<SimConflict> conflicts;         // by begin time
+    size_t routed = 0;
+    size_t failed = 0;              // unknown or unreachable target
+    size_t delayed = 0;             // replan: waited at the start node
+    size_t rerouted = 0;            // replan: took a longer route
+    size_t unresolved = 0;          // replan: no route cleared within maxWait
+    double makespan = 0.0;
+
+    // Where an agent is at the given time: at 'from' (from == to), or 'progress' of the way
+    // along the edge from 'from' to 'to'
+    void positionAt(size_t agent, double time, uint32_t& from, uint32_t& to, float& progress) const;
+};
+
+// Discrete-event simulation of route requests for several agents sharing physical space.
+//
+// Requests are processed in the order the agents become free to start them. Each route is
+// time-expanded along its edge weights into occupancy intervals of its nodes and edges
+// (both directions of an edge are one lane), and nodes grouped in a shared zone are one
+// space. An agent that arrives stays at its target until its next request. With replan
+// set, a route is checked against the reservations of everything planned so far and
+// delayed at its start node, or replaced by the shortest route around the nodes where other
+// agents wait or by one of the next-shortest routes, whichever arrives first. A request
+// that finds no clear route is tried again when the agent in its way moves on. Conflicts
+// are found afterwards by sweeping the occupancy of every space in time order, so they are
+// exact in both modes.
+//
+// Shortest routes follow a reverse distance tree per target, kept until the graph changes,
+// so a request costs little more than the length of its route.
+class ConflictSimulator {
+public:
+    bool run(GraphModel& model, const SimSchedule& schedule, const SimulationOptions& options,
+        SimulationResult& result);
+
+    // Drop the cached distance trees
+    void clear() { graphs.clear(); }
+
+private:
+    struct GraphState {
+        std::shared_ptr<Graph> graph;
+        std::shared_ptr<const RoutingSnapshot> snapshot;
+        std::unordered_map<uint32_t, std::vector<float>> trees;     // distances to a target slot
+        std::vector<uint32_t> nodeSpace;                            // space of each node this run
+        std::unordered_map<uint64_t, uint32_t> edgeSpace;           // space of each lane this run
+        std::vector<float> detourDist;
+        std::vector<uint32_t> detourPrevious;
+    };
+
+    GraphState* prepare(GraphModel& model, const std::string& name);
+    const std::vector<float>& treeTo(GraphState& state, uint32_t target);
+    bool shortestPath(GraphState& state, uint32_t source, uint32_t target, std::vector<uint32_t>& path);
+    bool detour(GraphState& state, uint32_t source, uint32_t target, const std::vector<char>& avoid,
+        std::vector<uint32_t>& path);
+
+    std::unordered_map<std::string, GraphState> graphs;
+};
@@ -0,0 +1,255 @@
+#include "CrossGraphRouter.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace {
+
+const float INF = std::numeric_limits<float>::infinity();
+
+// Slots of the given node ids, skipping ids that are not in the graph
+std::vector<uint32_t> slotsOf(const Graph& graph, const std::vector<std::string>& ids) {
+    std::vector<uint32_t> slots;
+    slots.reserve(ids.size());
+    for (const auto& id : ids) {
+        auto it = graph.nodeIndex.find(id);
+        if (it != graph.nodeIndex.end()) {
+            slots.push_back(static_cast<uint32_t>(it->second));
+        }
+    }
+    return slots;
+}
+
+} // namespace
+
+const CrossGraphRouter::BoundaryTable& CrossGraphRouter::table(const std::string& graphName,
+    const std::shared_ptr<Graph>& graph, const std::vector<std::string>& boundaryIds) {
+    BoundaryTable& entry = tables[graphName];
+    if (entry.graph.lock() == graph && entry.version == graph->version && entry.ids == boundaryIds) {
+        return entry;
+    }
+
+    // One early-terminating Dijkstra per boundary node, stopping once every boundary is settled
+    auto snap = routeCacheOf(*graph).snapshot(*graph);
+    const size_t count = boundaryIds.size();
+
+    entry.graph = graph;
+    entry.version = graph->version;
+    entry.ids = boundaryIds;
+    entry.slots = slotsOf(*graph, boundaryIds);
+    entry.indexOf.clear();
+    for (size_t i = 0; i < count; ++i) {
+        entry.indexOf[boundaryIds[i]] = static_cast<uint32_t>(i);
+    }
+
+    entry.distances.assign(count * count, INF);
+    std::vector<float> dist;
+    for (size_t i = 0; i < count; ++i) {
+        computeDistances(*snap, entry.slots[i], false, entry.slots, dist);
+        for (size_t j = 0; j < count; ++j) {
+            entry.distances[i * count + j] = dist[entry.slots[j]];
+        }
+    }
+
+    ++tableBuilds;
+    return entry;
+}
+
+CrossGraphRoute CrossGraphRouter::findRoute(GraphModel& model, const std::string& fromGraph, const std::string& fromNode,
+    const std::string& toGraph, const std::string& toNode) {
+    CrossGraphRoute result;
+
+    auto sourceGraph = model.getGraph(fromGraph);
+    auto targetGraph = model.getGraph(toGraph);
+    if (!sourceGraph || !targetGraph) {
+        return result;
+    }
+    auto sourceIt = sourceGraph->nodeIndex.find(fromNode);
+    auto targetIt = targetGraph->nodeIndex.find(toNode);
+    if (sourceIt == sourceGraph->nodeIndex.end() || targetIt == targetGraph->nodeIndex.end()) {
+        return result;
+    }
+
+    // Boundary nodes per graph: endpoints of transfer links that still exist
+    const auto& transfers = model.getTransfers();
+    std::unordered_map<std::string, std::vector<std::string>> boundaries;
+    std::unordered_map<std::string, std::shared_ptr<Graph>> linkedGraphs;
+    for (const auto& link : transfers) {
+        auto a = model.getGraph(link.fromGraph);
+        auto b = model.getGraph(link.toGraph);
+        if (!a || !b || !a->findNode(link.fromNode) || !b->findNode(link.toNode)) {
+            continue;
+        }
+        boundaries[link.fromGraph].push_back(link.fromNode);
+        boundaries[link.toGraph].push_back(link.toNode);
+        linkedGraphs[link.fromGraph] = a;
+        linkedGraphs[link.toGraph] = b;
+    }
+
+    // Overlay vertices are the boundary nodes of all graphs, numbered graph by graph
+    struct OverlayGraph {
+        const std::string* name;
+        const BoundaryTable* table;
+        uint32_t base;
+    };
+    std::vector<OverlayGraph> overlayGraphs;
+    std::unordered_map<std::string, size_t> overlayIndex;
+    uint32_t vertexCount = 0;
+    for (auto& pair : boundaries) {
+        auto& ids = pair.second;
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+        const BoundaryTable& t = table(pair.first, linkedGraphs[pair.first], ids);
+        overlayIndex[pair.first] = overlayGraphs.size();
+        overlayGraphs.push_back({ &pair.first, &t, vertexCount });
+        vertexCount += static_cast<uint32_t>(ids.size());
+    }
+
+    std::vector<uint32_t> graphOf(vertexCount);
+    for (uint32_t g = 0; g < overlayGraphs.size(); ++g) {
+        for (uint32_t i = 0; i < overlayGraphs[g].table->ids.size(); ++i) {
+            graphOf[overlayGraphs[g].base + i] = g;
+        }
+    }
+
+    auto vertexOf = [&](const std::string& graphName, const std::string& nodeId) -> uint32_t {
+        auto it = overlayIndex.find(graphName);
+        if (it == overlayIndex.end()) {
+            return UINT32_MAX;
+        }
+        const OverlayGraph& g = overlayGraphs[it->second];
+        auto nodeIt = g.table->indexOf.find(nodeId);
+        return nodeIt == g.table->indexOf.end() ? UINT32_MAX : g.base + nodeIt->second;
+    };
+
+    std::vector<std::vector<std::pair<uint32_t, float>>> transferOut(vertexCount);
+    for (const auto& link : transfers) {
+        uint32_t a = vertexOf(link.fromGraph, link.fromNode);
+        uint32_t b = vertexOf(link.toGraph, link.toNode);
+        if (a != UINT32_MAX && b != UINT32_MAX) {
+            transferOut[a].emplace_back(b, link.cost);
+        }
+    }
+
+    // Only the source and target graphs are searched node by node
+    const bool sameGraph = (sourceGraph == targetGraph);
+    const uint32_t sourceSlot = static_cast<uint32_t>(sourceIt->second);
+    const uint32_t targetSlot = static_cast<uint32_t>(targetIt->second);
+
+    auto sourceOverlay = overlayIndex.find(fromGraph);
+    auto targetOverlay = overlayIndex.find(toGraph);
+
+    std::vector<float> fromSource;
+    {
+        std::vector<uint32_t> stops;
+        if (sourceOverlay != overlayIndex.end()) {
+            stops = overlayGraphs[sourceOverlay->second].table->slots;
+        }
+        if (sameGraph) {
+            stops.push_back(targetSlot);
+        }
+        if (!stops.empty()) {
+            computeDistances(*routeCacheOf(*sourceGraph).snapshot(*sourceGraph), sourceSlot, false, stops, fromSource);
+        }
+    }
+
+    std::vector<float> toTarget;
+    if (targetOverlay != overlayIndex.end()) {
+        computeDistances(*routeCacheOf(*targetGraph).snapshot(*targetGraph), targetSlot, true,
+            overlayGraphs[targetOverlay->second].table->slots, toTarget);
+    }
+
+    // Dijkstra on the overlay; vertexCount stands for the target, vertexCount + 1 for the source
+    const uint32_t targetVertex = vertexCount;
+    const uint32_t sourceVertex = vertexCount + 1;
+    std::vector<float> dist(vertexCount + 2, INF);
+    std::vector<uint32_t> parent(vertexCount + 2, UINT32_MAX);
+
+    using Item = std::pair<float, uint32_t>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+
+    auto relax = [&](uint32_t from, uint32_t to, float candidate) {
+        if (candidate < dist[to]) {
+            dist[to] = candidate;
+            parent[to] = from;
+            queue.emplace(candidate, to);
+        }
+    };
+
+    dist[sourceVertex] = 0.0f;
+    if (sameGraph && !fromSource.empty()) {
+        relax(sourceVertex, targetVertex, fromSource[targetSlot]);
+    }
+    if (sourceOverlay != overlayIndex.end()) {
+        const OverlayGraph& g = overlayGraphs[sourceOverlay->second];
+        for (uint32_t i = 0; i < g.table->slots.size(); ++i) {
+            relax(sourceVertex, g.base + i, fromSource[g.table->slots[i]]);
+        }
+    }
+
+    while (!queue.empty()) {
+        Item item = queue.top();
+        queue.pop();
+        uint32_t v = item.second;
+        if (item.first > dist[v]) {
+            continue;
+        }
+        if (v == targetVertex) {
+            break;
+        }
+
+        const OverlayGraph& g = overlayGraphs[graphOf[v]];
+        const uint32_t local = v - g.base;
+        const size_t count = g.table->ids.size();
+
+        for (uint32_t j = 0; j < count; ++j) {
+            if (j != local) {
+                relax(v, g.base + j, item.first + g.table->distances[local * count + j]);
+            }
+        }
+        for (const auto& transfer : transferOut[v]) {
+            relax(v, transfer.first, item.first + transfer.second);
+        }
+        if (targetOverlay != overlayIndex.end() && graphOf[v] == targetOverlay->second) {
+            relax(v, targetVertex, item.first + toTarget[g.table->slots[local]]);
+        }
+    }
+
+    if (dist[targetVertex] == INF) {
+        return result;
+    }
+
+    // Waypoints along the overlay route, then expand each same-graph leg into moves
+    std::vector<CrossGraphStep> waypoints;
+    waypoints.push_back({ toGraph, toNode });
+    for (uint32_t v = parent[targetVertex]; v != sourceVertex; v = parent[v]) {
+        const OverlayGraph& g = overlayGraphs[graphOf[v]];
+        waypoints.push_back({ *g.name, g.table->ids[v - g.base] });
+    }
+    waypoints.push_back({ fromGraph, fromNode });
+    std::reverse(waypoints.begin(), waypoints.end());
+
+    result.cost = dist[targetVertex];
+    result.steps.push_back(waypoints.front());
+    for (size_t i = 1; i < waypoints.size(); ++i) {
+        const CrossGraphStep& previous = waypoints[i - 1];
+        const CrossGraphStep& next = waypoints[i];
+        if (previous.graph != next.graph) {
+            result.steps.push_back(next);   // transfer
+            continue;
+        }
+        if (previous.node == next.node) {
+            continue;
+        }
+
+        Route leg = findShortestPath(*model.getGraph(next.graph), previous.node, next.node);
+        for (size_t j = 1; j < leg.nodes.size(); ++j) {
+            result.steps.push_back({ next.graph, leg.nodes[j] });
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "GraphModel.h"
+#include "GraphRouting.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One stop of a cross-graph route
+struct CrossGraphStep {
+    std::string graph;
+    std::string node;
+};
+
+// Route across the graphs of a model; consecutive steps in different graphs are transfers
+struct CrossGraphRoute {
+    std::vector<CrossGraphStep> steps;
+    float cost = 0.0f;
+
+    bool empty() const { return steps.empty(); }
+};
+
+// Hierarchical router over the transfer links of a GraphModel.
+//
+// The endpoints of transfer links are the boundary nodes of each graph. For every graph the
+// boundary-to-boundary distances are precomputed and kept until that graph changes, so a
+// query only searches inside the source and target graphs and crosses everything else on
+// a small overlay of boundary nodes and transfers. The overlay route is then expanded into
+// individual moves with the per-graph shortest path.
+class CrossGraphRouter {
+public:
+    CrossGraphRoute findRoute(GraphModel& model, const std::string& fromGraph, const std::string& fromNode,
+        const std::string& toGraph, const std::string& toNode);
+
+    // Drop all precomputed tables
+    void clear() { tables.clear(); }
+
+    // Number of table rebuilds so far, for diagnostics
+    size_t getTableBuilds() const { return tableBuilds; }
+
+private:
+    struct BoundaryTable {
+        std::weak_ptr<Graph> graph;
+        uint64_t version = 0;
+        std::vector<std::string> ids;
+        std::vector<uint32_t> slots;
+        std::unordered_map<std::string, uint32_t> indexOf;
+        std::vector<float> distances;   // row-major, distances[i * ids.size() + j]
+    };
+
+    const BoundaryTable& table(const std::string& graphName, const std::shared_ptr<Graph>& graph,
+        const std::vector<std::string>& boundaryIds);
+
+    std::unordered_map<std::string, BoundaryTable> tables;
+    size_t tableBuilds = 0;
+};
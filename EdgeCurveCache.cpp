@@ -0,0 +1,111 @@
+#include "EdgeCurveCache.h"
+#include <algorithm>
+#include <cmath>
+
+const int MAX_SEGMENTS = 64;
+
+void EdgeCurveCache::prepare(Graph& target) {
+    if (graph != &target) {
+        graph = &target;
+        entries.clear();
+        curvedTopology = UINT64_MAX;
+    }
+    // Slots can shift when edges are removed; the endpoint check in get() covers that
+    entries.resize(target.edges.size());
+
+    // The reverse edge, if any, is among the edges incident to the target node
+    if (curvedTopology != target.topologyVersion) {
+        target.updateGeometryIndex();
+        curved.assign(target.edges.size(), 0);
+        for (size_t i = 0; i < target.edges.size(); ++i) {
+            uint32_t from = target.edgeFromSlot[i];
+            uint32_t to = target.edgeToSlot[i];
+            for (uint32_t e : target.incidentEdges[to]) {
+                if (target.edgeFromSlot[e] == to && target.edgeToSlot[e] == from) {
+                    curved[i] = 1;
+                    break;
+                }
+            }
+        }
+        curvedTopology = target.topologyVersion;
+    }
+}
+
+const std::vector<ImVec2>& EdgeCurveCache::get(size_t slot, const Node& from, const Node& to, float scale,
+    float tolerance) {
+    Entry& entry = entries[slot];
+    bool moved = entry.segments == 0 || entry.fromX != from.x || entry.fromY != from.y ||
+        entry.toX != to.x || entry.toY != to.y;
+    if (moved) {
+        entry.fromX = from.x;
+        entry.fromY = from.y;
+        entry.toX = to.x;
+        entry.toY = to.y;
+        entry.flatness = shape(from.x, from.y, to.x, to.y, radius, bulge, entry.control);
+    }
+
+    int segments = segmentsFor(entry.flatness, scale, tolerance);
+    if (moved || segments != entry.segments) {
+        entry.segments = segments;
+        if (entry.flatness > 0.0f) {
+            tessellate(entry.control, segments, entry.points);
+        }
+        else {
+            entry.points.clear();
+        }
+        buildCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    return entry.points;
+}
+
+float EdgeCurveCache::shape(float fromX, float fromY, float toX, float toY, float radius, float bulge,
+    ImVec2 control[4]) {
+    float dx = toX - fromX;
+    float dy = toY - fromY;
+    float dist = std::sqrt(dx * dx + dy * dy);
+    if (dist <= 0.0f) {
+        return 0.0f;
+    }
+
+    // Same shape the editor has always drawn: endpoints on the node boundaries, bulging
+    // to the left of the direction of travel so the two directions do not overlap
+    float ux = dx / dist;
+    float uy = dy / dist;
+    float offset = std::min(dist * 0.2f, bulge);
+    ImVec2* p = control;
+    p[0] = ImVec2(fromX + ux * radius, fromY + uy * radius);
+    p[3] = ImVec2(toX - ux * radius, toY - uy * radius);
+    ImVec2 middle((fromX + toX) * 0.5f - uy * offset, (fromY + toY) * 0.5f + ux * offset);
+    p[1] = ImVec2(p[0].x + (middle.x - p[0].x) * 0.5f, p[0].y + (middle.y - p[0].y) * 0.5f);
+    p[2] = ImVec2(p[3].x + (middle.x - p[3].x) * 0.5f, p[3].y + (middle.y - p[3].y) * 0.5f);
+
+    // |B''| <= 6 max(|p0 - 2 p1 + p2|, |p1 - 2 p2 + p3|)
+    float ax = p[0].x - 2.0f * p[1].x + p[2].x;
+    float ay = p[0].y - 2.0f * p[1].y + p[2].y;
+    float bx = p[1].x - 2.0f * p[2].x + p[3].x;
+    float by = p[1].y - 2.0f * p[2].y + p[3].y;
+    return 6.0f * std::sqrt(std::max(ax * ax + ay * ay, bx * bx + by * by));
+}
+
+int EdgeCurveCache::segmentsFor(float flatness, float scale, float tolerance) {
+    // A polyline of n segments stays within flatness / (8 n^2) of the curve
+    int segments = static_cast<int>(std::ceil(std::sqrt(flatness * scale / (8.0f * tolerance))));
+    return std::max(1, std::min(segments, MAX_SEGMENTS));
+}
+
+void EdgeCurveCache::tessellate(const ImVec2 control[4], int segments, std::vector<ImVec2>& points) {
+    const ImVec2* p = control;
+    points.clear();
+    points.reserve(segments + 1);
+    for (int i = 0; i <= segments; ++i) {
+        float t = static_cast<float>(i) / segments;
+        float u = 1.0f - t;
+        float w0 = u * u * u;
+        float w1 = 3.0f * u * u * t;
+        float w2 = 3.0f * u * t * t;
+        float w3 = t * t * t;
+        points.push_back(ImVec2(
+            w0 * p[0].x + w1 * p[1].x + w2 * p[2].x + w3 * p[3].x,
+            w0 * p[0].y + w1 * p[1].y + w2 * p[2].y + w3 * p[3].y));
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "GraphModel.h"
+#include "imgui.h"
+#include <atomic>
+#include <vector>
+
+// Tessellated curves of bidirectional edges, kept in graph space.
+//
+// The curve of an edge only depends on its endpoint positions, so an entry stays valid
+// until an endpoint moves; panning reuses it with a single transform. The segment count
+// is the smallest that keeps the on-screen polyline within the tessellation tolerance
+// of the true curve at the current zoom, so zooming only re-tessellates the curves whose
+// count actually changes.
+//
+// Entries are indexed by edge slot. get() may be called from several threads at once as
+// long as each slot is only used by one of them.
+class EdgeCurveCache {
+public:
+    EdgeCurveCache(float nodeRadius, float maxBulge) : radius(nodeRadius), bulge(maxBulge) {}
+
+    // Size the cache for the graph's edges and find the ones drawn curved; switching graphs
+    // drops every entry
+    void prepare(Graph& graph);
+
+    // Whether the edge in a slot has a reverse edge, and so is drawn as a curve
+    bool isCurved(size_t slot) const { return curved[slot] != 0; }
+
+    // Graph-space points from the start node boundary to the end node boundary, for a
+    // view scale and a tolerance in screen pixels (empty for coincident endpoints)
+    const std::vector<ImVec2>& get(size_t slot, const Node& from, const Node& to, float scale, float tolerance);
+
+    size_t getBuildCount() const { return buildCount.load(); }
+
+    // Cubic control points of the curve between two node centres, with the endpoints on the
+    // node boundaries; returns the bound on its second derivative (0 for coincident centres)
+    static float shape(float fromX, float fromY, float toX, float toY, float radius, float bulge,
+        ImVec2 control[4]);
+
+    // Segments for a polyline within the tolerance (screen pixels) of a curve at a view scale
+    static int segmentsFor(float flatness, float scale, float tolerance);
+
+    // Points of the curve at equal parameter steps, replacing the contents of points
+    static void tessellate(const ImVec2 control[4], int segments, std::vector<ImVec2>& points);
+
+private:
+    struct Entry {
+        float fromX = 0.0f;
+        float fromY = 0.0f;
+        float toX = 0.0f;
+        float toY = 0.0f;
+        ImVec2 control[4];
+        float flatness = 0.0f;      // bound on the curve's second derivative, graph units
+        int segments = 0;
+        std::vector<ImVec2> points;
+    };
+
+    float radius;
+    float bulge;
+    const Graph* graph = nullptr;
+    std::vector<Entry> entries;
+    std::vector<char> curved;
+    uint64_t curvedTopology = UINT64_MAX;
+    std::atomic<size_t> buildCount{ 0 };
+};
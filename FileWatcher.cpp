@@ -0,0 +1,127 @@
+#include "FileWatcher.h"
+#include <iostream>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#endif
+
+FileWatcher::~FileWatcher() {
+    stop();
+}
+
+bool FileWatcher::watch(const std::string& path) {
+    stop();
+
+    size_t slash = path.find_last_of("/\\");
+    std::string directory = (slash == std::string::npos) ? "." : path.substr(0, slash);
+    fileName = (slash == std::string::npos) ? path : path.substr(slash + 1);
+    watchedPath = path;
+
+#ifdef __linux__
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd >= 0) {
+        watchDescriptor = inotify_add_watch(inotifyFd, directory.c_str(),
+            IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE);
+        if (watchDescriptor >= 0) {
+            return true;
+        }
+        close(inotifyFd);
+        inotifyFd = -1;
+    }
+    std::cerr << "inotify unavailable for " << directory << ", polling instead" << std::endl;
+#endif
+
+    // Polling fallback: remember the current state so only later changes are reported
+    statChanged();
+    lastPoll = Clock::now();
+    return true;
+}
+
+void FileWatcher::stop() {
+#ifdef __linux__
+    if (inotifyFd >= 0) {
+        close(inotifyFd);
+    }
+#endif
+    inotifyFd = -1;
+    watchDescriptor = -1;
+    watchedPath.clear();
+    fileName.clear();
+    changePending = false;
+}
+
+bool FileWatcher::poll() {
+    if (watchedPath.empty()) {
+        return false;
+    }
+
+    Clock::time_point now = Clock::now();
+    bool changed = false;
+    if (inotifyFd >= 0) {
+        changed = readEvents();
+    }
+    else if (now - lastPoll >= std::chrono::milliseconds(POLL_INTERVAL_MS)) {
+        lastPoll = now;
+        changed = statChanged();
+    }
+
+    if (changed) {
+        changePending = true;
+        lastChange = now;
+        return false;
+    }
+
+    // Report only after the writer has gone quiet
+    if (changePending && now - lastChange >= std::chrono::milliseconds(SETTLE_MS)) {
+        changePending = false;
+        return true;
+    }
+    return false;
+}
+
+bool FileWatcher::readEvents() {
+    bool matched = false;
+#ifdef __linux__
+    alignas(inotify_event) char buffer[16 * (sizeof(inotify_event) + NAME_MAX + 1)];
+    for (;;) {
+        ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+
+        for (char* p = buffer; p < buffer + length; ) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+            if (event->len > 0 && fileName == event->name) {
+                matched = true;
+            }
+            p += sizeof(inotify_event) + event->len;
+        }
+    }
+#endif
+    return matched;
+}
+
+bool FileWatcher::statChanged() {
+    // A missing file counts as size -1, so creation and deletion are changes as well
+    int64_t modified = 0;
+    int64_t size = -1;
+#ifdef _WIN32
+    struct _stat64 info;
+    if (_stat64(watchedPath.c_str(), &info) == 0) {
+#else
+    struct stat info;
+    if (stat(watchedPath.c_str(), &info) == 0) {
+#endif
+        modified = static_cast<int64_t>(info.st_mtime);
+        size = static_cast<int64_t>(info.st_size);
+    }
+
+    bool changed = modified != lastModified || size != lastSize;
+    lastModified = modified;
+    lastSize = size;
+    return changed;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Watches a single file for changes made by other programs.
+//
+// On Linux this uses inotify on the containing directory, so tools that replace the
+// file by renaming a temporary over it are seen too. Elsewhere the file's modification
+// time and size are polled. Either way a change is only reported once the file has
+// been quiet for a short settle time, so a writer that is still busy is not read
+// half-way through.
+class FileWatcher {
+public:
+    FileWatcher() = default;
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool watch(const std::string& path);
+    void stop();
+    bool isWatching() const { return !watchedPath.empty(); }
+    const std::string& getPath() const { return watchedPath; }
+
+    // Non-blocking; returns true once per settled change. Call once per frame.
+    bool poll();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool readEvents();
+    bool statChanged();
+
+    std::string watchedPath;
+    std::string fileName;
+    int inotifyFd = -1;
+    int watchDescriptor = -1;
+
+    // Polling fallback state
+    int64_t lastModified = 0;
+    int64_t lastSize = -1;
+    Clock::time_point lastPoll;
+
+    bool changePending = false;
+    Clock::time_point lastChange;
+
+    static constexpr int SETTLE_MS = 150;
+    static constexpr int POLL_INTERVAL_MS = 500;
+};
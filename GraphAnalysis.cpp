@@ -0,0 +1,270 @@
+#include "GraphAnalysis.h"
+#include <algorithm>
+#include <utility>
+
+GraphAnalysis::~GraphAnalysis() {
+    detach();
+}
+
+void GraphAnalysis::attach(const std::shared_ptr<Graph>& target) {
+    graph = target;
+    needsRecompute = true;
+    if (graph) {
+        listenerId = graph->addListener(
+            [this](GraphChange change, const std::string& a, const std::string& b) {
+            onGraphChanged(change, a, b);
+        });
+    }
+}
+
+void GraphAnalysis::detach() {
+    if (graph) {
+        graph->removeListener(listenerId);
+        graph = nullptr;
+    }
+    listenerId = 0;
+}
+
+void GraphAnalysis::setRoot(const std::string& id) {
+    if (id != rootId) {
+        rootId = id;
+        needsRecompute = true;
+    }
+}
+
+void GraphAnalysis::update(const std::shared_ptr<Graph>& target) {
+    if (target != graph) {
+        detach();
+        attach(target);
+    }
+
+    if (!graph) {
+        return;
+    }
+
+    if (needsRecompute) {
+        recompute();
+        return;
+    }
+
+    if (componentsStale) {
+        computeComponents();
+    }
+    if (flagsStale) {
+        refreshFlags();
+    }
+}
+
+void GraphAnalysis::onGraphChanged(GraphChange change, const std::string& a, const std::string& b) {
+    if (needsRecompute) {
+        return;
+    }
+
+    if (change == GraphChange::NodeMoved || change == GraphChange::WeightsChanged) {
+        // Geometry and weights do not affect reachability
+        return;
+    }
+
+    if (change == GraphChange::NodeAdded) {
+        // New nodes are appended and start out isolated
+        if (a == rootId) {
+            needsRecompute = true;
+            return;
+        }
+        outEdges.emplace_back();
+        inEdges.emplace_back();
+        reachable.push_back(0);
+        returns.push_back(0);
+        component.push_back(static_cast<int>(componentCount++));
+        flagsStale = true;
+    }
+    else if (change == GraphChange::EdgeAdded) {
+        // An added edge can only extend the reachable/returning sets
+        auto fromIt = graph->nodeIndex.find(a);
+        auto toIt = graph->nodeIndex.find(b);
+        if (fromIt == graph->nodeIndex.end() || toIt == graph->nodeIndex.end()) {
+            needsRecompute = true;
+            return;
+        }
+
+        int from = static_cast<int>(fromIt->second);
+        int to = static_cast<int>(toIt->second);
+        edgeFrom.push_back(from);
+        edgeTo.push_back(to);
+        outEdges[from].push_back(to);
+        inEdges[to].push_back(from);
+
+        if (reachable[from] && !reachable[to]) {
+            propagate(reachable, outEdges, to);
+        }
+        if (returns[to] && !returns[from]) {
+            propagate(returns, inEdges, from);
+        }
+
+        componentsStale = true;
+        flagsStale = true;
+    }
+    else {
+        // Removals shift slots and can shrink the sets, so start over
+        needsRecompute = true;
+    }
+}
+
+void GraphAnalysis::recompute() {
+    const size_t nodeCount = graph->nodes.size();
+    const size_t edgeCount = graph->edges.size();
+
+    // Clear rather than reallocate so repeated recomputes reuse the adjacency storage
+    outEdges.resize(nodeCount);
+    inEdges.resize(nodeCount);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        outEdges[i].clear();
+        inEdges[i].clear();
+    }
+    edgeFrom.assign(edgeCount, -1);
+    edgeTo.assign(edgeCount, -1);
+
+    for (size_t i = 0; i < edgeCount; ++i) {
+        auto fromIt = graph->nodeIndex.find(graph->edges[i]->from);
+        auto toIt = graph->nodeIndex.find(graph->edges[i]->to);
+        if (fromIt == graph->nodeIndex.end() || toIt == graph->nodeIndex.end()) {
+            continue;
+        }
+
+        int from = static_cast<int>(fromIt->second);
+        int to = static_cast<int>(toIt->second);
+        edgeFrom[i] = from;
+        edgeTo[i] = to;
+        outEdges[from].push_back(to);
+        inEdges[to].push_back(from);
+    }
+
+    auto rootIt = graph->nodeIndex.find(rootId);
+    rootSlot = (rootIt != graph->nodeIndex.end()) ? static_cast<int>(rootIt->second) : -1;
+
+    reachable.assign(nodeCount, 0);
+    returns.assign(nodeCount, 0);
+    if (rootSlot >= 0) {
+        propagate(reachable, outEdges, rootSlot);
+        propagate(returns, inEdges, rootSlot);
+    }
+
+    computeComponents();
+    refreshFlags();
+    needsRecompute = false;
+}
+
+void GraphAnalysis::propagate(std::vector<char>& mark, const std::vector<std::vector<int>>& adjacency, int start) {
+    std::vector<int> stack;
+    stack.push_back(start);
+    mark[start] = 1;
+
+    while (!stack.empty()) {
+        int v = stack.back();
+        stack.pop_back();
+        for (int w : adjacency[v]) {
+            if (!mark[w]) {
+                mark[w] = 1;
+                stack.push_back(w);
+            }
+        }
+    }
+}
+
+void GraphAnalysis::computeComponents() {
+    // Iterative Tarjan: an explicit call stack of (node, next out-edge position)
+    const int nodeCount = static_cast<int>(outEdges.size());
+    std::vector<int> index(nodeCount, -1);
+    std::vector<int> lowLink(nodeCount, 0);
+    std::vector<char> onStack(nodeCount, 0);
+    std::vector<int> stack;
+    std::vector<std::pair<int, size_t>> callStack;
+
+    component.assign(nodeCount, -1);
+    componentCount = 0;
+    int nextIndex = 0;
+
+    for (int start = 0; start < nodeCount; ++start) {
+        if (index[start] != -1) {
+            continue;
+        }
+
+        index[start] = lowLink[start] = nextIndex++;
+        stack.push_back(start);
+        onStack[start] = 1;
+        callStack.emplace_back(start, 0);
+
+        while (!callStack.empty()) {
+            int v = callStack.back().first;
+            size_t next = callStack.back().second;
+
+            if (next < outEdges[v].size()) {
+                callStack.back().second = next + 1;
+                int w = outEdges[v][next];
+                if (index[w] == -1) {
+                    index[w] = lowLink[w] = nextIndex++;
+                    stack.push_back(w);
+                    onStack[w] = 1;
+                    callStack.emplace_back(w, 0);
+                }
+                else if (onStack[w]) {
+                    lowLink[v] = std::min(lowLink[v], index[w]);
+                }
+                continue;
+            }
+
+            // All successors done: v is the root of a component if its low-link is its own index
+            if (lowLink[v] == index[v]) {
+                int w;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    onStack[w] = 0;
+                    component[w] = static_cast<int>(componentCount);
+                } while (w != v);
+                ++componentCount;
+            }
+
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                int parent = callStack.back().first;
+                lowLink[parent] = std::min(lowLink[parent], lowLink[v]);
+            }
+        }
+    }
+
+    componentsStale = false;
+}
+
+void GraphAnalysis::refreshFlags() {
+    const size_t nodeCount = outEdges.size();
+    const bool rooted = rootSlot >= 0;
+
+    // With a root a dead end is reachable but cannot return; without one it has no way out
+    deadEnd.assign(nodeCount, 0);
+    unreachableCount = 0;
+    deadEndCount = 0;
+    for (size_t i = 0; i < nodeCount; ++i) {
+        if (rooted) {
+            deadEnd[i] = reachable[i] && !returns[i];
+            unreachableCount += reachable[i] ? 0 : 1;
+        }
+        else {
+            deadEnd[i] = outEdges[i].empty();
+        }
+        deadEndCount += deadEnd[i] ? 1 : 0;
+    }
+
+    trapEdge.assign(edgeFrom.size(), 0);
+    trapEdgeCount = 0;
+    if (rooted) {
+        for (size_t i = 0; i < edgeFrom.size(); ++i) {
+            if (edgeFrom[i] >= 0 && returns[edgeFrom[i]] && !returns[edgeTo[i]]) {
+                trapEdge[i] = 1;
+                ++trapEdgeCount;
+            }
+        }
+    }
+
+    flagsStale = false;
+}
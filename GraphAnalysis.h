@@ -0,0 +1,79 @@
+#pragma once
+
+#include "GraphModel.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Safety analysis of a motion graph: strongly connected components, reachability
+// from a root node (normally "Home") and the nodes that cannot get back to it.
+//
+// Results are indexed by node/edge slot (position in Graph::nodes / Graph::edges).
+// Node and edge additions are applied incrementally; removals and bulk changes
+// trigger a full O(V + E) recompute on the next update().
+class GraphAnalysis {
+public:
+    GraphAnalysis() = default;
+    ~GraphAnalysis();
+
+    GraphAnalysis(const GraphAnalysis&) = delete;
+    GraphAnalysis& operator=(const GraphAnalysis&) = delete;
+
+    // Track the given graph and bring the results up to date (cheap when nothing changed)
+    void update(const std::shared_ptr<Graph>& target);
+
+    void setRoot(const std::string& id);
+    const std::string& getRoot() const { return rootId; }
+    bool hasRoot() const { return rootSlot >= 0; }
+
+    // Per-node results
+    bool isReachable(size_t slot) const { return slot < reachable.size() && reachable[slot]; }
+    bool canReturn(size_t slot) const { return slot < returns.size() && returns[slot]; }
+    bool isUnreachable(size_t slot) const { return hasRoot() && slot < reachable.size() && !reachable[slot]; }
+    bool isDeadEnd(size_t slot) const { return slot < deadEnd.size() && deadEnd[slot]; }
+    int componentOf(size_t slot) const { return slot < component.size() ? component[slot] : -1; }
+
+    // Edge from a node that can still return to the root into one that cannot
+    bool isTrapEdge(size_t slot) const { return slot < trapEdge.size() && trapEdge[slot]; }
+
+    size_t getComponentCount() const { return componentCount; }
+    size_t getUnreachableCount() const { return unreachableCount; }
+    size_t getDeadEndCount() const { return deadEndCount; }
+    size_t getTrapEdgeCount() const { return trapEdgeCount; }
+
+private:
+    void attach(const std::shared_ptr<Graph>& target);
+    void detach();
+    void onGraphChanged(GraphChange change, const std::string& a, const std::string& b);
+
+    void recompute();
+    void computeComponents();
+    void propagate(std::vector<char>& mark, const std::vector<std::vector<int>>& adjacency, int start);
+    void refreshFlags();
+
+    std::shared_ptr<Graph> graph;
+    size_t listenerId = 0;
+    std::string rootId = "Home";
+    int rootSlot = -1;
+
+    // Adjacency by node slot, and endpoint slots by edge slot
+    std::vector<std::vector<int>> outEdges;
+    std::vector<std::vector<int>> inEdges;
+    std::vector<int> edgeFrom;
+    std::vector<int> edgeTo;
+
+    std::vector<char> reachable;
+    std::vector<char> returns;
+    std::vector<char> deadEnd;
+    std::vector<char> trapEdge;
+    std::vector<int> component;
+
+    size_t componentCount = 0;
+    size_t unreachableCount = 0;
+    size_t deadEndCount = 0;
+    size_t trapEdgeCount = 0;
+
+    bool needsRecompute = true;
+    bool componentsStale = true;
+    bool flagsStale = true;
+};
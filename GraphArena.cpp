@@ -0,0 +1,74 @@
+#include "GraphArena.h"
+#include <algorithm>
+#include <new>
+
+void* GraphArena::allocate(size_t size) {
+    size = std::max<size_t>((size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT, ALIGNMENT);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (size > MAX_SMALL_SIZE) {
+        largeBytes += size;
+        return ::operator new(size);
+    }
+
+    usedBytes += size;
+    FreeChunk*& freeList = freeLists[size / ALIGNMENT - 1];
+    if (freeList) {
+        FreeChunk* chunk = freeList;
+        freeList = chunk->next;
+        return chunk;
+    }
+
+    // The tail of the previous block is left unused; it is smaller than one chunk
+    if (static_cast<size_t>(blockEnd - cursor) < size) {
+        blocks.emplace_back(new char[nextBlockSize]);
+        cursor = blocks.back().get();
+        blockEnd = cursor + nextBlockSize;
+        reservedBytes += nextBlockSize;
+        nextBlockSize = std::min(nextBlockSize * 2, MAX_BLOCK_SIZE);
+    }
+    void* pointer = cursor;
+    cursor += size;
+    return pointer;
+}
+
+void GraphArena::deallocate(void* pointer, size_t size) {
+    if (!pointer) {
+        return;
+    }
+    size = std::max<size_t>((size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT, ALIGNMENT);
+    if (size <= MAX_SMALL_SIZE && released) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (size > MAX_SMALL_SIZE) {
+        largeBytes -= size;
+        ::operator delete(pointer);
+        return;
+    }
+
+    usedBytes -= size;
+    FreeChunk*& freeList = freeLists[size / ALIGNMENT - 1];
+    FreeChunk* chunk = static_cast<FreeChunk*>(pointer);
+    chunk->next = freeList;
+    freeList = chunk;
+}
+
+size_t GraphArena::getReservedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return reservedBytes;
+}
+
+size_t GraphArena::getUsedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return usedBytes;
+}
+
+size_t GraphArena::getLargeBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return largeBytes;
+}
+
+size_t GraphArena::getBlockCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return blocks.size();
+}
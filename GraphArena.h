@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Pooled storage for the many small objects of one graph: nodes, edges (with their shared_ptr
+// control blocks) and the entries of its lookup indexes.
+//
+// Small requests are carved from large blocks and recycled through per-size free lists, so
+// building a graph does not call the heap per object and freeing one does not fragment it.
+// The blocks are only released when the arena goes away, which takes one free per block.
+// Requests above MAX_SMALL_SIZE (vector storage, hash buckets) go straight to the heap.
+//
+// Thread-safe; a graph is normally built and torn down by one thread at a time.
+class GraphArena {
+public:
+    // Chunks are 8-byte aligned, enough for pointers, sizes and floats
+    static const size_t ALIGNMENT = 8;
+    static const size_t MAX_SMALL_SIZE = 256;
+
+    GraphArena() = default;
+
+    GraphArena(const GraphArena&) = delete;
+    GraphArena& operator=(const GraphArena&) = delete;
+
+    void* allocate(size_t size);
+    void deallocate(void* pointer, size_t size);
+
+    // The owner is being torn down: small chunks are no longer recycled, so freeing the
+    // remaining objects does not touch the free lists
+    void release() { released = true; }
+
+    // Bytes held in blocks, the part of them handed out, and the large requests outstanding
+    size_t getReservedBytes() const;
+    size_t getUsedBytes() const;
+    size_t getLargeBytes() const;
+    size_t getBlockCount() const;
+
+private:
+    static const size_t SIZE_CLASSES = MAX_SMALL_SIZE / ALIGNMENT;
+    static const size_t MIN_BLOCK_SIZE = 4 * 1024;
+    static const size_t MAX_BLOCK_SIZE = 4 * 1024 * 1024;
+
+    struct FreeChunk {
+        FreeChunk* next;
+    };
+
+    mutable std::mutex mutex;
+    std::atomic<bool> released{ false };
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* cursor = nullptr;
+    char* blockEnd = nullptr;
+    size_t nextBlockSize = MIN_BLOCK_SIZE;
+    FreeChunk* freeLists[SIZE_CLASSES] = {};
+    size_t reservedBytes = 0;
+    size_t usedBytes = 0;
+    size_t largeBytes = 0;
+};
+
+// Standard allocator drawing from a shared GraphArena. Every container or object allocated
+// through it holds a reference, so the arena outlives everything it handed out.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(std::shared_ptr<GraphArena> target) : arena(std::move(target)) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) {
+        static_assert(alignof(T) <= GraphArena::ALIGNMENT, "type needs more alignment than the arena gives");
+        return static_cast<T*>(arena->allocate(count * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t count) {
+        arena->deallocate(pointer, count * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+    std::shared_ptr<GraphArena> arena;
+};
@@ -0,0 +1,287 @@
+#include "GraphClusters.h"
+#include <algorithm>
+#include <cmath>
+
+// Level-0 cell edge, about one node spacing of the hand-made graphs
+const float BASE_CELL_SIZE = 150.0f;
+
+GraphClusters::~GraphClusters() {
+    detach();
+}
+
+void GraphClusters::attach(const std::shared_ptr<Graph>& target) {
+    graph = target;
+    needsReset = true;
+    if (graph) {
+        listenerId = graph->addListener(
+            [this](GraphChange change, const std::string& a, const std::string& b) {
+            onGraphChanged(change, a, b);
+        });
+    }
+}
+
+void GraphClusters::detach() {
+    if (graph) {
+        graph->removeListener(listenerId);
+        graph = nullptr;
+    }
+    listenerId = 0;
+}
+
+void GraphClusters::update(const std::shared_ptr<Graph>& target) {
+    if (target != graph) {
+        detach();
+        attach(target);
+    }
+    if (graph && needsReset) {
+        reset();
+    }
+}
+
+float GraphClusters::cellSize(int level) {
+    return BASE_CELL_SIZE * static_cast<float>(1u << level);
+}
+
+void GraphClusters::reset() {
+    for (int level = 0; level < LEVEL_COUNT; ++level) {
+        levels[level].clear();
+        built[level] = false;
+    }
+
+    size_t nodeCount = graph->nodes.size();
+    nodeX.resize(nodeCount);
+    nodeY.resize(nodeCount);
+    nodeCellX.resize(nodeCount);
+    nodeCellY.resize(nodeCount);
+    cellNodes.clear();
+    for (size_t i = 0; i < nodeCount; ++i) {
+        moveNode(i);
+        placeNode(i, 1);
+    }
+    needsReset = false;
+}
+
+const GraphClusters::Level& GraphClusters::getLevel(int level) {
+    if (graph && !built[level]) {
+        buildLevel(level);
+    }
+    return levels[level];
+}
+
+const GraphClusters::Cluster* GraphClusters::find(int level, int32_t cellX, int32_t cellY) {
+    const Level& clusters = getLevel(level);
+    auto it = clusters.find(cellKey(cellX, cellY));
+    return it != clusters.end() ? &it->second : nullptr;
+}
+
+void GraphClusters::queryRect(float minX, float minY, float maxX, float maxY, std::vector<uint32_t>& slots) {
+    slots.clear();
+    if (!graph) {
+        return;
+    }
+    if (needsReset) {
+        reset();
+    }
+
+    auto collect = [&](const std::vector<uint32_t>& cell) {
+        for (uint32_t slot : cell) {
+            if (nodeX[slot] >= minX && nodeX[slot] <= maxX && nodeY[slot] >= minY && nodeY[slot] <= maxY) {
+                slots.push_back(slot);
+            }
+        }
+    };
+
+    // Look the covered cells up one by one unless fewer cells are occupied
+    int32_t cellMinX = static_cast<int32_t>(std::floor(minX / BASE_CELL_SIZE));
+    int32_t cellMinY = static_cast<int32_t>(std::floor(minY / BASE_CELL_SIZE));
+    int32_t cellMaxX = static_cast<int32_t>(std::floor(maxX / BASE_CELL_SIZE));
+    int32_t cellMaxY = static_cast<int32_t>(std::floor(maxY / BASE_CELL_SIZE));
+    if (cellMaxX < cellMinX || cellMaxY < cellMinY) {
+        return;
+    }
+    uint64_t cellCount = static_cast<uint64_t>(cellMaxX - cellMinX + 1) * static_cast<uint64_t>(cellMaxY - cellMinY + 1);
+    if (cellCount > cellNodes.size()) {
+        for (const auto& pair : cellNodes) {
+            int32_t x = cellX(pair.first);
+            int32_t y = cellY(pair.first);
+            if (x >= cellMinX && x <= cellMaxX && y >= cellMinY && y <= cellMaxY) {
+                collect(pair.second);
+            }
+        }
+    }
+    else {
+        for (int32_t y = cellMinY; y <= cellMaxY; ++y) {
+            for (int32_t x = cellMinX; x <= cellMaxX; ++x) {
+                auto it = cellNodes.find(cellKey(x, y));
+                if (it != cellNodes.end()) {
+                    collect(it->second);
+                }
+            }
+        }
+    }
+}
+
+void GraphClusters::buildLevel(int level) {
+    levels[level].clear();
+    for (size_t i = 0; i < nodeX.size(); ++i) {
+        addNode(level, i, 1);
+    }
+
+    graph->updateGeometryIndex();
+    for (size_t e = 0; e < graph->edges.size(); ++e) {
+        addEdge(level, graph->edgeFromSlot[e], graph->edgeToSlot[e], 1);
+    }
+    built[level] = true;
+    ++levelBuilds;
+}
+
+void GraphClusters::addNode(int level, size_t slot, int sign) {
+    uint64_t key = keyOf(level, slot);
+    Cluster& cluster = levels[level][key];
+    cluster.count += sign;
+    cluster.sumX += sign * static_cast<double>(nodeX[slot]);
+    cluster.sumY += sign * static_cast<double>(nodeY[slot]);
+    if (cluster.count == 0) {
+        levels[level].erase(key);
+    }
+}
+
+void GraphClusters::addEdge(int level, size_t fromSlot, size_t toSlot, int sign) {
+    uint64_t from = keyOf(level, fromSlot);
+    uint64_t to = keyOf(level, toSlot);
+    Level& clusters = levels[level];
+    if (from == to) {
+        clusters[from].internalEdges += sign;
+        return;
+    }
+
+    // Both clusters exist: they hold the endpoints
+    Cluster& source = clusters[from];
+    if ((source.out[to] += sign) == 0) {
+        source.out.erase(to);
+    }
+    Cluster& target = clusters[to];
+    if ((target.in[from] += sign) == 0) {
+        target.in.erase(from);
+    }
+}
+
+void GraphClusters::moveNode(size_t slot) {
+    const Node& node = *graph->nodes[slot];
+    nodeX[slot] = node.x;
+    nodeY[slot] = node.y;
+    nodeCellX[slot] = static_cast<int32_t>(std::floor(node.x / BASE_CELL_SIZE));
+    nodeCellY[slot] = static_cast<int32_t>(std::floor(node.y / BASE_CELL_SIZE));
+}
+
+void GraphClusters::placeNode(size_t slot, int sign) {
+    uint64_t key = keyOf(0, slot);
+    if (sign > 0) {
+        cellNodes[key].push_back(static_cast<uint32_t>(slot));
+        return;
+    }
+
+    auto it = cellNodes.find(key);
+    if (it == cellNodes.end()) {
+        return;
+    }
+    auto& cell = it->second;
+    auto pos = std::find(cell.begin(), cell.end(), static_cast<uint32_t>(slot));
+    if (pos != cell.end()) {
+        *pos = cell.back();
+        cell.pop_back();
+    }
+    if (cell.empty()) {
+        cellNodes.erase(it);
+    }
+}
+
+void GraphClusters::onGraphChanged(GraphChange change, const std::string& a, const std::string& b) {
+    if (needsReset || change == GraphChange::WeightsChanged) {
+        return;
+    }
+
+    if (change == GraphChange::NodeAdded) {
+        // Appended in the next slot
+        size_t slot = nodeX.size();
+        nodeX.push_back(0.0f);
+        nodeY.push_back(0.0f);
+        nodeCellX.push_back(0);
+        nodeCellY.push_back(0);
+        moveNode(slot);
+        placeNode(slot, 1);
+        for (int level = 0; level < LEVEL_COUNT; ++level) {
+            if (built[level]) {
+                addNode(level, slot, 1);
+            }
+        }
+    }
+    else if (change == GraphChange::EdgeAdded || change == GraphChange::EdgeRemoved) {
+        auto fromIt = graph->nodeIndex.find(a);
+        auto toIt = graph->nodeIndex.find(b);
+        if (fromIt == graph->nodeIndex.end() || toIt == graph->nodeIndex.end()) {
+            needsReset = true;
+            return;
+        }
+        int sign = change == GraphChange::EdgeAdded ? 1 : -1;
+        for (int level = 0; level < LEVEL_COUNT; ++level) {
+            if (built[level]) {
+                addEdge(level, fromIt->second, toIt->second, sign);
+            }
+        }
+    }
+    else if (change == GraphChange::NodeMoved && !a.empty()) {
+        auto it = graph->nodeIndex.find(a);
+        if (it == graph->nodeIndex.end()) {
+            needsReset = true;
+            return;
+        }
+
+        // Within its cell a node only shifts the cluster centroid; otherwise it and its
+        // edges are taken out at the old cell and put back at the new one
+        size_t slot = it->second;
+        const Node& node = *graph->nodes[slot];
+        int32_t newCellX = static_cast<int32_t>(std::floor(node.x / BASE_CELL_SIZE));
+        int32_t newCellY = static_cast<int32_t>(std::floor(node.y / BASE_CELL_SIZE));
+        bool relinked[LEVEL_COUNT] = {};
+        graph->updateGeometryIndex();
+        const auto& incident = graph->incidentEdges[slot];
+        for (int level = 0; level < LEVEL_COUNT; ++level) {
+            if (!built[level]) {
+                continue;
+            }
+            if ((nodeCellX[slot] >> level) == (newCellX >> level) && (nodeCellY[slot] >> level) == (newCellY >> level)) {
+                Cluster& cluster = levels[level][keyOf(level, slot)];
+                cluster.sumX += static_cast<double>(node.x) - nodeX[slot];
+                cluster.sumY += static_cast<double>(node.y) - nodeY[slot];
+                continue;
+            }
+            relinked[level] = true;
+            for (uint32_t e : incident) {
+                addEdge(level, graph->edgeFromSlot[e], graph->edgeToSlot[e], -1);
+            }
+            addNode(level, slot, -1);
+        }
+        bool sameCell = newCellX == nodeCellX[slot] && newCellY == nodeCellY[slot];
+        if (!sameCell) {
+            placeNode(slot, -1);
+        }
+        moveNode(slot);
+        if (!sameCell) {
+            placeNode(slot, 1);
+        }
+        for (int level = 0; level < LEVEL_COUNT; ++level) {
+            if (!relinked[level]) {
+                continue;
+            }
+            addNode(level, slot, 1);
+            for (uint32_t e : incident) {
+                addEdge(level, graph->edgeFromSlot[e], graph->edgeToSlot[e], 1);
+            }
+        }
+    }
+    else {
+        // Node removals shift slots; bulk changes can touch anything
+        needsReset = true;
+    }
+}
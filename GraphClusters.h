@@ -0,0 +1,99 @@
+#pragma once
+
+#include "GraphModel.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Spatial cluster hierarchy of a graph for drawing it zoomed out.
+//
+// Level l groups the nodes by square cells of cellSize(l) graph units, each level twice the
+// size of the one below. A cluster keeps its node count, centroid and the number of edges
+// to every other cluster of its level, so a zoomed-out view draws one node per visible
+// cluster and one bundled edge per linked cluster pair.
+//
+// Levels are built on first use. After that, node and edge additions, edge removals and
+// single-node moves are applied incrementally to every built level (O(levels) per node;
+// a move is O(levels) within its cell and O(levels * degree) across cells); node removals
+// and bulk changes drop the built levels.
+//
+// The node slots of every level-0 cell are kept as well, so rectangle queries only look at
+// the nodes in the cells they cover.
+class GraphClusters {
+public:
+    struct Cluster {
+        uint32_t count = 0;
+        uint32_t internalEdges = 0;     // edges with both ends in this cluster
+        double sumX = 0.0;
+        double sumY = 0.0;
+        std::unordered_map<uint64_t, uint32_t> out;    // edges to other clusters, by cell key
+        std::unordered_map<uint64_t, uint32_t> in;     // edges from other clusters
+
+        float centerX() const { return static_cast<float>(sumX / count); }
+        float centerY() const { return static_cast<float>(sumY / count); }
+    };
+
+    using Level = std::unordered_map<uint64_t, Cluster>;
+
+    static const int LEVEL_COUNT = 12;
+
+    GraphClusters() = default;
+    ~GraphClusters();
+
+    GraphClusters(const GraphClusters&) = delete;
+    GraphClusters& operator=(const GraphClusters&) = delete;
+
+    // Track the given graph (cheap when nothing changed)
+    void update(const std::shared_ptr<Graph>& target);
+
+    static float cellSize(int level);
+    static uint64_t cellKey(int32_t cellX, int32_t cellY) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cellX)) << 32) | static_cast<uint32_t>(cellY);
+    }
+    static int32_t cellX(uint64_t key) { return static_cast<int32_t>(key >> 32); }
+    static int32_t cellY(uint64_t key) { return static_cast<int32_t>(key & 0xffffffffu); }
+
+    // Clusters of a level, built on first use
+    const Level& getLevel(int level);
+    const Cluster* find(int level, int32_t cellX, int32_t cellY);
+
+    // Slots of the nodes inside a graph-space rectangle, bounds included
+    void queryRect(float minX, float minY, float maxX, float maxY, std::vector<uint32_t>& slots);
+
+    size_t getLevelBuildCount() const { return levelBuilds; }
+
+private:
+    void attach(const std::shared_ptr<Graph>& target);
+    void detach();
+    void onGraphChanged(GraphChange change, const std::string& a, const std::string& b);
+    void reset();
+
+    void buildLevel(int level);
+    void addNode(int level, size_t slot, int sign);
+    void addEdge(int level, size_t fromSlot, size_t toSlot, int sign);
+    void moveNode(size_t slot);
+    void placeNode(size_t slot, int sign);
+
+    uint64_t keyOf(int level, size_t slot) const {
+        return cellKey(nodeCellX[slot] >> level, nodeCellY[slot] >> level);
+    }
+
+    std::shared_ptr<Graph> graph;
+    size_t listenerId = 0;
+
+    // Position and level-0 cell of every node, by slot, as last seen
+    std::vector<float> nodeX;
+    std::vector<float> nodeY;
+    std::vector<int32_t> nodeCellX;
+    std::vector<int32_t> nodeCellY;
+
+    // Node slots by level-0 cell key
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cellNodes;
+
+    Level levels[LEVEL_COUNT];
+    bool built[LEVEL_COUNT] = {};
+    bool needsReset = true;
+    size_t levelBuilds = 0;
+};
@@ -1,21 +1,64 @@
 #include "GraphEditor.h"
+#include "Profiler.h"
+#include "CanvasStyle.h"
 #include <iostream>
+#include <fstream>
 #include <cmath>
 #include <algorithm>
+#include <chrono>
 #include <imgui_internal.h>
 
 // Constants
-const float NODE_RADIUS = 30.0f;
-const ImU32 NODE_COLOR = IM_COL32(100, 150, 250, 255);
-const ImU32 NODE_SELECTED_COLOR = IM_COL32(250, 100, 100, 255);
-const ImU32 EDGE_COLOR = IM_COL32(200, 200, 200, 255);
-const ImU32 EDGE_SELECTED_COLOR = IM_COL32(250, 150, 50, 255);
-const ImU32 CANVAS_BG_COLOR = IM_COL32(50, 50, 50, 255);
-const float EDGE_THICKNESS = 2.0f;
-const float ARROW_SIZE = 10.0f;
+const ImU32 ROUTE_COLOR = IM_COL32(80, 220, 120, 200);
+const ImU32 TRANSFER_COLOR = IM_COL32(200, 120, 255, 255);
+const ImU32 BLOCKED_COLOR = IM_COL32(20, 20, 20, 230);
+const float LABEL_CULL_MARGIN = 100.0f;   // screen pixels a label may extend past its node or edge
+const float MIN_CANVAS_SCALE = 0.01f;
+const float MAX_CANVAS_SCALE = 5.0f;
+const size_t CLUSTER_MIN_NODES = 300;       // smaller graphs are always drawn node by node
+const float CLUSTER_DETAIL_SCALE = 0.5f;    // at or above this zoom nodes are drawn individually
+const float CLUSTER_MIN_PIXELS = 60.0f;     // smallest on-screen cluster cell
+const ImU32 CLUSTER_COLOR = IM_COL32(70, 110, 200, 230);
+const ImU32 CLUSTER_LINK_COLOR = IM_COL32(200, 200, 200, 140);
+const size_t MINIMAP_POINT_BUDGET = 2048;   // decimated nodes drawn by the minimap
+const ImVec2 MINIMAP_SIZE = ImVec2(220.0f, 160.0f);
+const ImU32 MINIMAP_BG_COLOR = IM_COL32(30, 30, 30, 220);
+const ImU32 MINIMAP_POINT_COLOR = IM_COL32(140, 180, 255, 255);
+const ImU32 MINIMAP_VIEW_COLOR = IM_COL32(255, 255, 255, 200);
 const float PI = 3.14159265358979323846f;
+const char* const INPUT_RECORDING_FILE = "InputRecording.json";
+const ImU32 MACHINE_COLOR = IM_COL32(0, 230, 230, 255);
+const ImU32 MACHINE_STALE_COLOR = IM_COL32(120, 140, 140, 200);
+const float MACHINE_STALE_SECONDS = 0.5f;   // older positions are drawn greyed out
+const float FEED_TIMEOUT_SECONDS = 2.0f;    // silent this long: reattach, the producer may have restarted
+const float FEED_RETRY_SECONDS = 1.0f;
+const ImU32 MARQUEE_COLOR = IM_COL32(250, 200, 100, 220);
+const ImU32 MARQUEE_FILL_COLOR = IM_COL32(250, 200, 100, 40);
+const float LASSO_POINT_SPACING = 4.0f;     // screen pixels between recorded lasso points
+const float MEMORY_REPORT_SECONDS = 1.0f;   // the per-graph memory report walks every id
+const char* const SIMULATION_SCHEDULE_FILE = "Schedule.json";
+const ImU32 SIM_AGENT_COLOR = IM_COL32(255, 190, 60, 255);
+const ImU32 SIM_CONFLICT_COLOR = IM_COL32(255, 60, 60, 255);
+const size_t SIM_CONFLICTS_LISTED = 10000; // longer conflict lists are cut off in the window
+
+namespace {
+
+// Even-odd rule: a point is inside when a ray from it crosses the outline an odd number of times
+bool isInsidePolygon(const std::vector<ImVec2>& polygon, float x, float y) {
+    bool inside = false;
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+        const ImVec2& a = polygon[i];
+        const ImVec2& b = polygon[j];
+        if ((a.y > y) != (b.y > y) && x < (b.x - a.x) * (y - a.y) / (b.y - a.y) + a.x) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+} // namespace
 
-GraphEditor::GraphEditor() {}
+GraphEditor::GraphEditor() : minimap(MINIMAP_POINT_BUDGET), curveCache(NODE_RADIUS, CURVE_BULGE) {}
 
 void GraphEditor::setModel(std::shared_ptr<GraphModel> graphModel) {
     model = graphModel;
@@ -28,12 +71,40 @@ void GraphEditor::setModel(std::shared_ptr<GraphModel> graphModel) {
     }
 }
 
+void GraphEditor::watchFile(const std::string& filename) {
+    if (!fileWatcher.watch(filename)) {
+        std::cerr << "Failed to watch file: " << filename << std::endl;
+    }
+}
+
 void GraphEditor::render() {
+    PROFILE_SCOPE("GraphEditor::render");
     if (!model) {
         ImGui::Text("No graph model loaded");
         return;
     }
 
+    if (isRecordingInput) {
+        inputRecording.frames.push_back(captureInputFrame());
+    }
+
+    // Merge external edits of the watched file
+    checkFileChanges();
+
+    // Write unsaved graphs to the recovery file now and then
+    autosave();
+
+    // Latest live machine positions
+    updateMachineFeed();
+
+    // Keep the safety analysis in sync with the current graph (no-op when unchanged)
+    {
+        PROFILE_SCOPE("GraphAnalysis::update");
+        analysis.update(currentGraph);
+    }
+    clusters.update(currentGraph);
+    selection.update(currentGraph);
+
     renderMainMenu();
 
     ImGui::Columns(2, "GraphEditorColumns", true);
@@ -54,6 +125,21 @@ void GraphEditor::render() {
 
         // Edge operations
         renderEdgeList();
+
+        ImGui::Separator();
+
+        // Reachability from the root node
+        renderAnalysisPanel();
+
+        ImGui::Separator();
+
+        // Alternative routes
+        renderRoutePanel();
+
+        ImGui::Separator();
+
+        // Links to other graphs
+        renderTransferPanel();
     }
 
     ImGui::EndChild();
@@ -66,16 +152,48 @@ void GraphEditor::render() {
     ImGui::EndChild();
 
     ImGui::Columns(1);
+
+    if (showProfiler) {
+        renderProfilerWindow();
+    }
+    if (showGenerator) {
+        renderGeneratorWindow();
+    }
+    if (showSimulation) {
+        renderSimulationWindow();
+    }
+    if (pendingExport.valid()) {
+        renderExportWindow();
+    }
 }
 
 void GraphEditor::renderMainMenu() {
+    PROFILE_SCOPE("GraphEditor::renderMainMenu");
     if (ImGui::BeginMainMenuBar()) {
         if (ImGui::BeginMenu("File")) {
             if (ImGui::MenuItem("Open", "Ctrl+O")) {
-                loadFile("WorkingGraphs.json"); // In a real app, this would use a file dialog
+                loadFile(graphFile); // In a real app, this would use a file dialog
             }
             if (ImGui::MenuItem("Save", "Ctrl+S")) {
-                saveFile("WorkingGraphs.json"); // In a real app, this would use a file dialog
+                saveFile(graphFile); // In a real app, this would use a file dialog
+            }
+            if (ImGui::MenuItem("Save Compact")) {
+                saveFile(graphFile, true);
+            }
+            if (ImGui::MenuItem("Import CSV")) {
+                // In a real app, this would use a file dialog
+                if (model->importCsv("Imported", "Nodes.csv", "Edges.csv")) {
+                    currentGraphName = "Imported";
+                    currentGraph = model->getGraph(currentGraphName);
+                    clearSelections();
+                }
+            }
+            ImGui::Separator();
+            if (ImGui::MenuItem("Export SVG", nullptr, false, currentGraph && !pendingExport.valid())) {
+                startExport(false);
+            }
+            if (ImGui::MenuItem("Export PNG", nullptr, false, currentGraph && !pendingExport.valid())) {
+                startExport(true);
             }
             ImGui::Separator();
             if (ImGui::MenuItem("Exit", "Alt+F4")) {
@@ -91,11 +209,28 @@ void GraphEditor::renderMainMenu() {
             ImGui::EndMenu();
         }
 
+        if (ImGui::BeginMenu("View")) {
+            ImGui::MenuItem("Profiler", nullptr, &showProfiler);
+            ImGui::MenuItem("Minimap", nullptr, &showMinimap);
+            ImGui::MenuItem("Machine Overlay", nullptr, &showMachineOverlay);
+            ImGui::EndMenu();
+        }
+
+        if (ImGui::BeginMenu("Debug")) {
+            ImGui::MenuItem("Generate Graph...", nullptr, &showGenerator);
+            ImGui::MenuItem("Route Simulation...", nullptr, &showSimulation);
+            if (ImGui::MenuItem(isRecordingInput ? "Stop Input Recording" : "Record Input")) {
+                toggleInputRecording();
+            }
+            ImGui::EndMenu();
+        }
+
         ImGui::EndMainMenuBar();
     }
 }
 
 void GraphEditor::renderGraphList() {
+    PROFILE_SCOPE("GraphEditor::renderGraphList");
     ImGui::Text("Graphs");
 
     auto graphNames = model->getGraphNames();
@@ -103,7 +238,10 @@ void GraphEditor::renderGraphList() {
     if (ImGui::BeginListBox("##GraphList", ImVec2(-1, 100))) {
         for (const auto& name : graphNames) {
             bool isSelected = (name == currentGraphName);
-            if (ImGui::Selectable(name.c_str(), isSelected)) {
+
+            // Unsaved graphs are marked; the ID stays the name either way
+            std::string label = model->isDirty(name) ? name + " *###" + name : name + "###" + name;
+            if (ImGui::Selectable(label.c_str(), isSelected)) {
                 currentGraphName = name;
                 currentGraph = model->getGraph(name);
                 clearSelections();
@@ -146,17 +284,39 @@ void GraphEditor::renderGraphList() {
 }
 
 void GraphEditor::renderNodeList() {
+    PROFILE_SCOPE("GraphEditor::renderNodeList");
     ImGui::Text("Nodes");
 
+    // Only the visible rows are submitted
     if (ImGui::BeginListBox("##NodeList", ImVec2(-1, 150))) {
-        for (const auto& node : currentGraph->nodes) {
-            bool isSelected = (node->id == selectedNodeId);
-            if (ImGui::Selectable(node->id.c_str(), isSelected)) {
-                selectNode(node->id);
-            }
-
-            if (isSelected) {
-                ImGui::SetItemDefaultFocus();
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(currentGraph->nodes.size()));
+        while (clipper.Step()) {
+            for (size_t i = clipper.DisplayStart; i < static_cast<size_t>(clipper.DisplayEnd); ++i) {
+                const auto& node = currentGraph->nodes[i];
+                bool isSelected = selection.contains(i);
+
+                // Flag nodes that break the reachability rules
+                ImU32 statusColor = nodeOutlineColor(i);
+                bool highlight = (statusColor != NODE_OUTLINE_COLOR);
+                if (highlight) {
+                    ImGui::PushStyleColor(ImGuiCol_Text, statusColor);
+                }
+                if (ImGui::Selectable(node->id.c_str(), isSelected)) {
+                    if (ImGui::GetIO().KeyCtrl) {
+                        selection.toggle(i);
+                    }
+                    else {
+                        selectNode(node->id);
+                    }
+                }
+                if (highlight) {
+                    ImGui::PopStyleColor();
+                }
+
+                if (isSelected) {
+                    ImGui::SetItemDefaultFocus();
+                }
             }
         }
         ImGui::EndListBox();
@@ -172,25 +332,50 @@ void GraphEditor::renderNodeList() {
         addNode();
     }
 
-    if (ImGui::Button("Remove Selected Node")) {
-        removeSelectedNode();
+    if (ImGui::Button(selection.size() > 1 ? "Remove Selected Nodes" : "Remove Selected Node")) {
+        removeSelectedNodes();
     }
 }
 
 void GraphEditor::renderEdgeList() {
+    PROFILE_SCOPE("GraphEditor::renderEdgeList");
     ImGui::Text("Edges");
 
+    // Only the visible rows are submitted; the selected edge is looked up once, by slot
     if (ImGui::BeginListBox("##EdgeList", ImVec2(-1, 150))) {
-        for (const auto& edge : currentGraph->edges) {
-            std::string label = edge->from + " -> " + edge->to + " (" + std::to_string(edge->weight) + ")";
-            bool isSelected = (selectedEdge && *edge == *selectedEdge);
-
-            if (ImGui::Selectable(label.c_str(), isSelected)) {
-                selectEdge(edge->from, edge->to);
+        size_t selectedSlot = SIZE_MAX;
+        if (selectedEdge) {
+            auto it = currentGraph->edgeIndex.find(std::make_pair(selectedEdge->from, selectedEdge->to));
+            if (it != currentGraph->edgeIndex.end()) {
+                selectedSlot = it->second;
             }
+        }
 
-            if (isSelected) {
-                ImGui::SetItemDefaultFocus();
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(currentGraph->edges.size()));
+        char label[256];
+        while (clipper.Step()) {
+            for (size_t i = clipper.DisplayStart; i < static_cast<size_t>(clipper.DisplayEnd); ++i) {
+                const auto& edge = currentGraph->edges[i];
+                ImFormatString(label, sizeof(label), "%s -> %s (%f)", edge->from.c_str(), edge->to.c_str(),
+                    edge->weight);
+                bool isSelected = (i == selectedSlot);
+
+                // Edges leading into a dead end are the usual culprit for stuck moves
+                bool isTrap = analysis.isTrapEdge(i);
+                if (isTrap) {
+                    ImGui::PushStyleColor(ImGuiCol_Text, DEAD_END_COLOR);
+                }
+                if (ImGui::Selectable(label, isSelected)) {
+                    selectEdge(edge->from, edge->to);
+                }
+                if (isTrap) {
+                    ImGui::PopStyleColor();
+                }
+
+                if (isSelected) {
+                    ImGui::SetItemDefaultFocus();
+                }
             }
         }
         ImGui::EndListBox();
@@ -226,7 +411,23 @@ void GraphEditor::renderEdgeList() {
         ImGui::EndCombo();
     }
 
-    ImGui::SliderFloat("Weight", &newEdgeWeight, 0.1f, 10.0f);
+    // Weights are either typed in or derived from the node positions
+    WeightModel weightModel = currentGraph->weightModel;
+    const char* weightModes[] = { "Manual", "Distance", "Move Time" };
+    int weightMode = static_cast<int>(weightModel.mode);
+    bool weightModelChanged = ImGui::Combo("Weight Model", &weightMode, weightModes, IM_ARRAYSIZE(weightModes));
+    weightModel.mode = static_cast<WeightModel::Mode>(weightMode);
+    if (weightModel.mode == WeightModel::Mode::MoveTime) {
+        weightModelChanged |= ImGui::InputFloat("Velocity", &weightModel.velocity, 10.0f, 100.0f, "%.1f");
+        weightModelChanged |= ImGui::InputFloat("Acceleration", &weightModel.acceleration, 100.0f, 1000.0f, "%.1f");
+    }
+    if (weightModelChanged) {
+        currentGraph->setWeightModel(weightModel);
+    }
+
+    if (weightModel.mode == WeightModel::Mode::Manual) {
+        ImGui::SliderFloat("Weight", &newEdgeWeight, 0.1f, 10.0f);
+    }
 
     if (ImGui::Button("Add Edge") && !newEdgeFrom.empty() && !newEdgeTo.empty()) {
         addEdge();
@@ -238,8 +439,499 @@ void GraphEditor::renderEdgeList() {
     }
 }
 
+void GraphEditor::renderAnalysisPanel() {
+    PROFILE_SCOPE("GraphEditor::renderAnalysisPanel");
+    ImGui::Text("Reachability");
+
+    // Root node selection (defaults to Home)
+    if (ImGui::BeginCombo("Root Node", analysis.getRoot().c_str())) {
+        for (const auto& node : currentGraph->nodes) {
+            bool isSelected = (node->id == analysis.getRoot());
+            if (ImGui::Selectable(node->id.c_str(), isSelected)) {
+                analysis.setRoot(node->id);
+            }
+
+            if (isSelected) {
+                ImGui::SetItemDefaultFocus();
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    if (!analysis.hasRoot()) {
+        ImGui::TextColored(ImColor(UNREACHABLE_COLOR), "Root node '%s' not found", analysis.getRoot().c_str());
+        ImGui::Text("Nodes without outgoing edges: %d", static_cast<int>(analysis.getDeadEndCount()));
+    }
+    else if (analysis.getUnreachableCount() == 0 && analysis.getDeadEndCount() == 0) {
+        ImGui::Text("All nodes reachable from and able to return to %s", analysis.getRoot().c_str());
+    }
+    else {
+        ImGui::TextColored(ImColor(UNREACHABLE_COLOR), "Unreachable from %s: %d",
+            analysis.getRoot().c_str(), static_cast<int>(analysis.getUnreachableCount()));
+        ImGui::TextColored(ImColor(DEAD_END_COLOR), "Cannot return to %s: %d",
+            analysis.getRoot().c_str(), static_cast<int>(analysis.getDeadEndCount()));
+        ImGui::TextColored(ImColor(DEAD_END_COLOR), "Edges into dead ends: %d",
+            static_cast<int>(analysis.getTrapEdgeCount()));
+    }
+    ImGui::Text("Strongly connected components: %d", static_cast<int>(analysis.getComponentCount()));
+}
+
+void GraphEditor::renderRoutePanel() {
+    PROFILE_SCOPE("GraphEditor::renderRoutePanel");
+    ImGui::Text("Routes");
+
+    if (ImGui::BeginCombo("Route From", routeFrom.c_str())) {
+        for (const auto& node : currentGraph->nodes) {
+            bool isSelected = (node->id == routeFrom);
+            if (ImGui::Selectable(node->id.c_str(), isSelected)) {
+                routeFrom = node->id;
+            }
+
+            if (isSelected) {
+                ImGui::SetItemDefaultFocus();
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    if (ImGui::BeginCombo("Route To", routeTo.c_str())) {
+        for (const auto& node : currentGraph->nodes) {
+            bool isSelected = (node->id == routeTo);
+            if (ImGui::Selectable(node->id.c_str(), isSelected)) {
+                routeTo = node->id;
+            }
+
+            if (isSelected) {
+                ImGui::SetItemDefaultFocus();
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    ImGui::SliderInt("Alternatives", &routeCount, 1, 10);
+
+    // Temporarily blocked stations are excluded from the query, the graph is untouched
+    auto blockedIt = std::find(blockedNodes.begin(), blockedNodes.end(), selectedNodeId);
+    if (blockedIt == blockedNodes.end()) {
+        if (ImGui::Button("Block Selected Node") && !selectedNodeId.empty()) {
+            blockedNodes.push_back(selectedNodeId);
+        }
+    }
+    else if (ImGui::Button("Unblock Selected Node")) {
+        blockedNodes.erase(blockedIt);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear Blocked")) {
+        blockedNodes.clear();
+    }
+
+    // Queries are answered from the graph's route cache until the graph changes
+    routes.clear();
+    if (!routeFrom.empty() && !routeTo.empty()) {
+        RouteExclusions exclusions;
+        exclusions.nodes = blockedNodes;
+        routes = findKShortestPaths(*currentGraph, routeFrom, routeTo, static_cast<size_t>(routeCount), exclusions);
+    }
+
+    if (routes.empty()) {
+        if (!routeFrom.empty() && !routeTo.empty()) {
+            ImGui::TextColored(ImColor(DEAD_END_COLOR), "No route from %s to %s", routeFrom.c_str(), routeTo.c_str());
+        }
+        return;
+    }
+
+    selectedRoute = std::min(selectedRoute, static_cast<int>(routes.size()) - 1);
+    if (ImGui::BeginListBox("##RouteList", ImVec2(-1, 100))) {
+        for (size_t i = 0; i < routes.size(); ++i) {
+            std::string label = "#" + std::to_string(i + 1) + " (" + std::to_string(routes[i].cost) + "):";
+            for (const auto& id : routes[i].nodes) {
+                label += " " + id;
+            }
+
+            bool isSelected = (static_cast<int>(i) == selectedRoute);
+            if (ImGui::Selectable(label.c_str(), isSelected)) {
+                selectedRoute = static_cast<int>(i);
+            }
+        }
+        ImGui::EndListBox();
+    }
+}
+
+void GraphEditor::renderTransferPanel() {
+    PROFILE_SCOPE("GraphEditor::renderTransferPanel");
+    ImGui::Text("Transfers");
+
+    const auto& transfers = model->getTransfers();
+    if (ImGui::BeginListBox("##TransferList", ImVec2(-1, 80))) {
+        for (size_t i = 0; i < transfers.size(); ++i) {
+            const auto& link = transfers[i];
+            std::string label = link.fromGraph + "/" + link.fromNode + " -> " +
+                link.toGraph + "/" + link.toNode + " (" + std::to_string(link.cost) + ")##" + std::to_string(i);
+
+            bool isSelected = (static_cast<int>(i) == selectedTransfer);
+            if (ImGui::Selectable(label.c_str(), isSelected)) {
+                selectedTransfer = static_cast<int>(i);
+            }
+        }
+        ImGui::EndListBox();
+    }
+
+    if (selectedTransfer >= 0 && ImGui::Button("Remove Transfer")) {
+        model->removeTransfer(static_cast<size_t>(selectedTransfer));
+        selectedTransfer = -1;
+    }
+
+    // Target graph and node for a new link, or for a cross-graph route
+    if (ImGui::BeginCombo("Other Graph", transferGraph.c_str())) {
+        for (const auto& name : model->getGraphNames()) {
+            bool isSelected = (name == transferGraph);
+            if (ImGui::Selectable(name.c_str(), isSelected)) {
+                transferGraph = name;
+                transferNode.clear();
+            }
+
+            if (isSelected) {
+                ImGui::SetItemDefaultFocus();
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    auto otherGraph = model->getGraph(transferGraph);
+    if (otherGraph && ImGui::BeginCombo("Other Node", transferNode.c_str())) {
+        for (const auto& node : otherGraph->nodes) {
+            bool isSelected = (node->id == transferNode);
+            if (ImGui::Selectable(node->id.c_str(), isSelected)) {
+                transferNode = node->id;
+            }
+
+            if (isSelected) {
+                ImGui::SetItemDefaultFocus();
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    ImGui::InputFloat("Transfer Cost", &transferCost, 0.1f, 1.0f);
+
+    if (!selectedNodeId.empty() && !transferNode.empty()) {
+        if (ImGui::Button("Link Selected Node To")) {
+            model->addTransfer({ currentGraphName, selectedNodeId, transferGraph, transferNode, transferCost });
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Link From")) {
+            model->addTransfer({ transferGraph, transferNode, currentGraphName, selectedNodeId, transferCost });
+        }
+
+        if (ImGui::Button("Route Selected Node To Other")) {
+            crossRoute = crossRouter.findRoute(*model, currentGraphName, selectedNodeId, transferGraph, transferNode);
+            if (crossRoute.empty()) {
+                std::cerr << "No route from " << currentGraphName << "/" << selectedNodeId
+                    << " to " << transferGraph << "/" << transferNode << std::endl;
+            }
+        }
+    }
+
+    if (!crossRoute.empty()) {
+        ImGui::Text("Cross-graph route, cost %.2f:", crossRoute.cost);
+        for (size_t i = 0; i < crossRoute.steps.size(); ++i) {
+            const auto& step = crossRoute.steps[i];
+            bool isTransfer = i > 0 && crossRoute.steps[i - 1].graph != step.graph;
+            if (isTransfer) {
+                ImGui::TextColored(ImColor(TRANSFER_COLOR), "  transfer -> %s/%s", step.graph.c_str(), step.node.c_str());
+            }
+            else {
+                ImGui::Text("  %s/%s", step.graph.c_str(), step.node.c_str());
+            }
+        }
+    }
+}
+
+void GraphEditor::renderProfilerWindow() {
+    ImGui::SetNextWindowSize(ImVec2(420, 300), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Profiler", &showProfiler)) {
+        ImGui::End();
+        return;
+    }
+
+    bool enabled = Profiler::isEnabled();
+    if (ImGui::Checkbox("Record", &enabled)) {
+        Profiler::setEnabled(enabled);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Save Trace")) {
+        if (Profiler::writeChromeTrace("GraphEditorTrace.json")) {
+            std::cout << "Saved trace to: GraphEditorTrace.json" << std::endl;
+        }
+    }
+#if !GRAPH_PROFILING
+    ImGui::TextDisabled("Built without GRAPH_PROFILING");
+#endif
+
+    // Stats describe the previous frame; the current one is still being recorded
+    ImGui::Text("Frame: %.3f ms (%.1f FPS)", Profiler::getFrameMs(), ImGui::GetIO().Framerate);
+
+    if (ImGui::CollapsingHeader("Graph Memory")) {
+        auto now = std::chrono::steady_clock::now();
+        if (std::chrono::duration<double>(now - lastMemoryReport).count() >= MEMORY_REPORT_SECONDS) {
+            lastMemoryReport = now;
+            memoryReport.clear();
+            for (const auto& name : model->getGraphNames()) {
+                GraphMemoryUsage usage;
+                if (model->getMemoryUsage(name, usage)) {
+                    memoryReport.emplace_back(name, usage);
+                }
+            }
+            std::sort(memoryReport.begin(), memoryReport.end(),
+                [](const std::pair<std::string, GraphMemoryUsage>& a, const std::pair<std::string, GraphMemoryUsage>& b) {
+                return a.first < b.first;
+            });
+        }
+
+        if (ImGui::BeginTable("##Memory", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+            ImGui::TableSetupColumn("Graph");
+            ImGui::TableSetupColumn("Nodes");
+            ImGui::TableSetupColumn("Edges");
+            ImGui::TableSetupColumn("MB");
+            ImGui::TableSetupColumn("Arena used");
+            ImGui::TableHeadersRow();
+
+            for (const auto& entry : memoryReport) {
+                const GraphMemoryUsage& usage = entry.second;
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(entry.first.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%zu", usage.nodeCount);
+                ImGui::TableNextColumn();
+                ImGui::Text("%zu", usage.edgeCount);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", usage.total() / 1e6);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.0f%%", usage.arenaBytes > 0 ? 100.0 * usage.arenaUsedBytes / usage.arenaBytes : 0.0);
+            }
+            ImGui::EndTable();
+        }
+        ImGui::Text("%zu of %zu graphs loaded", memoryReport.size(), model->getGraphNames().size());
+    }
+
+    if (ImGui::BeginTable("##Zones", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders |
+        ImGuiTableFlags_ScrollY)) {
+        ImGui::TableSetupColumn("Zone");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("Last ms");
+        ImGui::TableSetupColumn("Avg ms");
+        ImGui::TableHeadersRow();
+
+        for (const auto& zone : Profiler::getFrameStats()) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(zone.name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", zone.calls);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", zone.lastMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", zone.averageMs);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+void GraphEditor::renderGeneratorWindow() {
+    ImGui::SetNextWindowSize(ImVec2(320, 0), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Generate Graph", &showGenerator)) {
+        ImGui::End();
+        return;
+    }
+
+    const GeneratorOptions::Kind kinds[] = {
+        GeneratorOptions::Kind::Grid,
+        GeneratorOptions::Kind::RandomGeometric,
+        GeneratorOptions::Kind::ScaleFree,
+        GeneratorOptions::Kind::HubAndSpoke
+    };
+    if (ImGui::BeginCombo("Kind", generatorKindName(generatorOptions.kind))) {
+        for (auto kind : kinds) {
+            if (ImGui::Selectable(generatorKindName(kind), kind == generatorOptions.kind)) {
+                generatorOptions.kind = kind;
+            }
+        }
+        ImGui::EndCombo();
+    }
+
+    int nodeCount = static_cast<int>(generatorOptions.nodeCount);
+    if (ImGui::InputInt("Nodes", &nodeCount, 1000, 100000)) {
+        generatorOptions.nodeCount = static_cast<size_t>(std::max(1, nodeCount));
+    }
+    int seed = static_cast<int>(generatorOptions.seed);
+    if (ImGui::InputInt("Seed", &seed)) {
+        generatorOptions.seed = static_cast<uint32_t>(seed);
+    }
+    ImGui::InputFloat("Spacing", &generatorOptions.spacing, 10.0f, 50.0f, "%.0f");
+    ImGui::InputFloat("Avg Degree", &generatorOptions.averageDegree, 1.0f, 2.0f, "%.1f");
+    ImGui::Checkbox("Bidirectional", &generatorOptions.bidirectional);
+
+    ImGui::InputText("Graph Name", generatorGraphName, sizeof(generatorGraphName));
+
+    if (ImGui::Button("Generate") && generatorGraphName[0] != '\0') {
+        auto start = std::chrono::steady_clock::now();
+        if (generateGraph(*model, generatorGraphName, generatorOptions)) {
+            currentGraphName = generatorGraphName;
+            currentGraph = model->getGraph(currentGraphName);
+            clearSelections();
+            std::cout << "Generated " << currentGraph->nodes.size() << " nodes and "
+                << currentGraph->edges.size() << " edges in "
+                << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                << " ms" << std::endl;
+        }
+    }
+
+    ImGui::End();
+}
+
+void GraphEditor::renderExportWindow() {
+    // Finished: report once and stop polling
+    if (pendingExport.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        bool written = pendingExport.get();
+        if (written) {
+            std::cout << "Exported " << currentGraphName << " to: " << exportFile << std::endl;
+        }
+        else if (!exportProgress->cancel) {
+            std::cerr << "Failed to export: " << exportFile << std::endl;
+        }
+        exportProgress.reset();
+        return;
+    }
+
+    ImGui::SetNextWindowSize(ImVec2(320, 0), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Export");
+    ImGui::Text("%s", exportFile.c_str());
+    ImGui::ProgressBar(exportProgress->fraction);
+    if (exportProgress->cancel) {
+        ImGui::TextDisabled("Cancelling...");
+    }
+    else if (ImGui::Button("Cancel")) {
+        exportProgress->cancel = true;
+    }
+    ImGui::End();
+}
+
+void GraphEditor::renderSimulationWindow() {
+    ImGui::SetNextWindowSize(ImVec2(380, 0), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Route Simulation", &showSimulation)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Checkbox("Replan", &simulationOptions.replan);
+    ImGui::InputDouble("Node Clearance", &simulationOptions.nodeClearance, 0.05, 0.25, "%.2f s");
+    ImGui::InputDouble("Max Wait", &simulationOptions.maxWait, 5.0, 30.0, "%.0f s");
+    simulationOptions.nodeClearance = std::max(0.0, simulationOptions.nodeClearance);
+
+    if (ImGui::Button("Run Schedule")) {
+        // In a real app, this would use a file dialog
+        SimSchedule schedule;
+        auto start = std::chrono::steady_clock::now();
+        if (schedule.load(SIMULATION_SCHEDULE_FILE) && simulator.run(*model, schedule, simulationOptions, simulation)) {
+            hasSimulation = true;
+            replayTime = 0.0;
+            isReplaying = false;
+            std::cout << "Simulated " << schedule.requests.size() << " requests of " << schedule.agents.size()
+                << " agents in "
+                << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                << " ms" << std::endl;
+        }
+    }
+    if (!hasSimulation) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Text("%zu routed, %zu failed, %zu delayed, %zu rerouted, %zu unresolved", simulation.routed,
+        simulation.failed, simulation.delayed, simulation.rerouted, simulation.unresolved);
+    ImGui::Text("%zu conflicts, makespan %.1f s", simulation.conflicts.size(), simulation.makespan);
+
+    if (isReplaying) {
+        replayTime += ImGui::GetIO().DeltaTime * replaySpeed;
+        if (replayTime >= simulation.makespan) {
+            replayTime = simulation.makespan;
+            isReplaying = false;
+        }
+    }
+    if (ImGui::Button(isReplaying ? "Pause" : "Play")) {
+        isReplaying = !isReplaying;
+        if (isReplaying && replayTime >= simulation.makespan) {
+            replayTime = 0.0;
+        }
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120.0f);
+    ImGui::SliderFloat("Speed", &replaySpeed, 0.1f, 1000.0f, "%.1fx", ImGuiSliderFlags_Logarithmic);
+    const double startTime = 0.0;
+    ImGui::SliderScalar("Time", ImGuiDataType_Double, &replayTime, &startTime, &simulation.makespan, "%.2f s");
+
+    // Conflicts in time order; picking one shows its moment on the first agent's graph
+    size_t listed = std::min(simulation.conflicts.size(), SIM_CONFLICTS_LISTED);
+    if (ImGui::BeginListBox("##Conflicts", ImVec2(-1, 200))) {
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(listed));
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                const SimConflict& conflict = simulation.conflicts[i];
+                std::string places[2];
+                for (int side = 0; side < 2; ++side) {
+                    uint32_t agent = conflict.agents[side];
+                    auto graph = model->getGraph(simulation.agentGraphs[agent]);
+                    if (!graph || graph->topologyVersion != simulation.graphVersions[agent]) {
+                        places[side] = "?";
+                        continue;
+                    }
+                    places[side] = graph->nodes[conflict.from[side]]->id;
+                    if (conflict.to[side] != conflict.from[side]) {
+                        places[side] += "->" + graph->nodes[conflict.to[side]]->id;
+                    }
+                }
+                char label[256];
+                snprintf(label, sizeof(label), "%.2f s  %s %s / %s %s##%d", conflict.begin,
+                    simulation.agentNames[conflict.agents[0]].c_str(), places[0].c_str(),
+                    simulation.agentNames[conflict.agents[1]].c_str(), places[1].c_str(), i);
+                if (ImGui::Selectable(label)) {
+                    replayTime = conflict.begin;
+                    isReplaying = false;
+                    const std::string& graphName = simulation.agentGraphs[conflict.agents[0]];
+                    if (graphName != currentGraphName && model->getGraph(graphName)) {
+                        currentGraphName = graphName;
+                        currentGraph = model->getGraph(currentGraphName);
+                        clearSelections();
+                    }
+                }
+            }
+        }
+        ImGui::EndListBox();
+    }
+    if (simulation.conflicts.size() > listed) {
+        ImGui::TextDisabled("%zu more", simulation.conflicts.size() - listed);
+    }
+
+    ImGui::End();
+}
+
+ImU32 GraphEditor::nodeOutlineColor(size_t slot) const {
+    if (analysis.isDeadEnd(slot)) {
+        return DEAD_END_COLOR;
+    }
+    if (analysis.isUnreachable(slot)) {
+        return UNREACHABLE_COLOR;
+    }
+    return NODE_OUTLINE_COLOR;
+}
+
 // Modify the renderGraphCanvas method to enable proper panning in all directions
 void GraphEditor::renderGraphCanvas() {
+    PROFILE_SCOPE("GraphEditor::renderGraphCanvas");
     if (!currentGraph) {
         ImGui::Text("No graph selected");
         return;
@@ -288,7 +980,7 @@ void GraphEditor::renderGraphCanvas() {
             // Adjust scale with smooth factor
             float oldScale = canvasScale;
             canvasScale += wheel * 0.1f * canvasScale; // Proportional zooming
-            canvasScale = std::max(0.1f, std::min(canvasScale, 5.0f)); // Limit zoom range
+            canvasScale = std::max(MIN_CANVAS_SCALE, std::min(canvasScale, MAX_CANVAS_SCALE)); // Limit zoom range
 
             // Adjust offset to zoom at mouse position
             canvasOffset.x += mouseCanvasPos.x * (oldScale - canvasScale);
@@ -297,9 +989,14 @@ void GraphEditor::renderGraphCanvas() {
     }
 
     // Draw grid (optional, helps with orientation)
-    const float GRID_SIZE = 50.0f * canvasScale;
+    float GRID_SIZE = 50.0f * canvasScale;
     const ImU32 GRID_COLOR = IM_COL32(60, 60, 60, 100);
 
+    // Coarser grid when zoomed far out, so it stays a handful of lines
+    while (GRID_SIZE < 10.0f) {
+        GRID_SIZE *= 10.0f;
+    }
+
     float gridOffsetX = fmodf(canvasOffset.x, GRID_SIZE);
     float gridOffsetY = fmodf(canvasOffset.y, GRID_SIZE);
 
@@ -326,79 +1023,485 @@ void GraphEditor::renderGraphCanvas() {
     );
     drawList->AddCircleFilled(originPos, 5.0f, IM_COL32(255, 0, 0, 200));
 
-    // Draw edges
-    for (const auto& edge : currentGraph->edges) {
-        auto fromNode = currentGraph->findNode(edge->from);
-        auto toNode = currentGraph->findNode(edge->to);
+    // Only items that can touch the canvas are drawn; the margins cover curve bulge,
+    // arrow heads and labels
+    ImVec2 visibleMin = canvasPos;
+    ImVec2 visibleMax = ImVec2(canvasPos.x + canvasSize.x, canvasPos.y + canvasSize.y);
+    float nodeMargin = NODE_RADIUS * canvasScale + LABEL_CULL_MARGIN;
+    float edgeMargin = (NODE_RADIUS + CURVE_BULGE) * canvasScale + LABEL_CULL_MARGIN;
+    auto toScreen = [&](const Node& node) {
+        return ImVec2(canvasPos.x + node.x * canvasScale + canvasOffset.x,
+            canvasPos.y + node.y * canvasScale + canvasOffset.y);
+    };
+
+    // Zoomed out on a large graph: clusters replace the individual nodes and edges
+    int clusterLevel = clusterLevelFor(canvasScale);
+    if (clusterLevel >= 0) {
+        drawClusters(drawList, canvasPos, canvasSize, clusterLevel);
+    }
 
-        if (fromNode && toNode) {
-            drawEdge(drawList, edge, fromNode, toNode, canvasPos);
+    // Draw edges, in chunks on the thread pool for large graphs. Endpoints come from the
+    // geometry index by slot, so the workers share no id lookups or reference counts.
+    curveCache.prepare(*currentGraph);
+    size_t selectedEdgeSlot = SIZE_MAX;
+    if (selectedEdge) {
+        auto it = currentGraph->edgeIndex.find(std::make_pair(selectedEdge->from, selectedEdge->to));
+        if (it != currentGraph->edgeIndex.end()) {
+            selectedEdgeSlot = it->second;
         }
     }
+    canvasBuilder.build(drawList, clusterLevel < 0 ? currentGraph->edges.size() : 0, [&](ImDrawList* list, size_t begin, size_t end) {
+        PROFILE_SCOPE("GraphEditor::drawEdges");
+        for (size_t i = begin; i < end; ++i) {
+            const Node& fromNode = *currentGraph->nodes[currentGraph->edgeFromSlot[i]];
+            const Node& toNode = *currentGraph->nodes[currentGraph->edgeToSlot[i]];
+
+            ImVec2 a = toScreen(fromNode);
+            ImVec2 b = toScreen(toNode);
+            if (std::max(a.x, b.x) < visibleMin.x - edgeMargin || std::min(a.x, b.x) > visibleMax.x + edgeMargin ||
+                std::max(a.y, b.y) < visibleMin.y - edgeMargin || std::min(a.y, b.y) > visibleMax.y + edgeMargin) {
+                continue;
+            }
+            drawEdge(list, i, *currentGraph->edges[i], fromNode, toNode, canvasPos, i == selectedEdgeSlot,
+                analysis.isTrapEdge(i));
+        }
+    });
 
-    // Draw nodes
-    for (const auto& node : currentGraph->nodes) {
-        drawNode(drawList, node, canvasPos);
+    // Highlight the selected alternative route
+    if (selectedRoute >= 0 && selectedRoute < static_cast<int>(routes.size())) {
+        drawRoute(drawList, routes[selectedRoute], canvasPos);
     }
 
-    // Node selection and dragging
-    if (isCanvasActive && !isPanning && ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
-        ImVec2 mousePos = ImGui::GetMousePos();
-        bool nodeSelected = false;
-
-        // Check if a node was clicked
-        for (const auto& node : currentGraph->nodes) {
-            ImVec2 nodePos = ImVec2(
-                canvasPos.x + node->x * canvasScale + canvasOffset.x,
-                canvasPos.y + node->y * canvasScale + canvasOffset.y
-            );
-
-            float distSq = (mousePos.x - nodePos.x) * (mousePos.x - nodePos.x) +
-                (mousePos.y - nodePos.y) * (mousePos.y - nodePos.y);
-
-            if (distSq <= NODE_RADIUS * NODE_RADIUS * canvasScale * canvasScale) {
-                selectNode(node->id);
-                nodeSelected = true;
-                break;
+    // Draw nodes
+    canvasBuilder.build(drawList, clusterLevel < 0 ? currentGraph->nodes.size() : 0, [&](ImDrawList* list, size_t begin, size_t end) {
+        PROFILE_SCOPE("GraphEditor::drawNodes");
+        for (size_t i = begin; i < end; ++i) {
+            ImVec2 p = toScreen(*currentGraph->nodes[i]);
+            if (p.x < visibleMin.x - nodeMargin || p.x > visibleMax.x + nodeMargin ||
+                p.y < visibleMin.y - nodeMargin || p.y > visibleMax.y + nodeMargin) {
+                continue;
             }
+            drawNode(list, currentGraph->nodes[i], canvasPos, nodeOutlineColor(i), selection.contains(i));
         }
+    });
 
-        if (!nodeSelected) {
-            clearSelections();
+    // Mark nodes that have transfers to other graphs
+    for (const auto& link : model->getTransfers()) {
+        std::shared_ptr<Node> node;
+        if (link.fromGraph == currentGraphName) {
+            node = currentGraph->findNode(link.fromNode);
+        }
+        else if (link.toGraph == currentGraphName) {
+            node = currentGraph->findNode(link.toNode);
+        }
+        if (node) {
+            drawTransferMarker(drawList, node, canvasPos);
         }
     }
 
-    // Node dragging
-    if (!selectedNodeId.empty() && ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
-        auto node = currentGraph->findNode(selectedNodeId);
+    // Mark nodes blocked for route queries
+    for (const auto& id : blockedNodes) {
+        auto node = currentGraph->findNode(id);
         if (node) {
-            ImVec2 delta = ImGui::GetIO().MouseDelta;
-            node->x += delta.x / canvasScale;
-            node->y += delta.y / canvasScale;
+            drawBlockedNode(drawList, node, canvasPos);
         }
     }
 
-    // Display canvas controls information
-    ImGui::SetCursorPos(ImVec2(10, 10));
-    ImGui::BeginChild("CanvasControls", ImVec2(200, 100), true);
+    // Live machine positions on top
+    if (showMachineOverlay) {
+        drawMachineOverlay(drawList, canvasPos);
+    }
+
+    // Simulated agents at the replay time
+    if (showSimulation && hasSimulation) {
+        drawSimulationReplay(drawList, canvasPos);
+    }
+
+    // Clicking a cluster zooms in on it, one level at a time
+    if (clusterLevel >= 0 && isCanvasActive && !isPanning && ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+        expandClusterAt(ImGui::GetMousePos(), canvasPos, canvasSize, clusterLevel);
+    }
+
+    // Node selection, rectangle/lasso selection and group dragging
+    if (clusterLevel < 0 && !isPanning) {
+        handleCanvasSelection(canvasPos, isCanvasActive);
+    }
+    else {
+        marquee = Marquee::None;
+        isDragging = false;
+    }
+
+    if (marquee == Marquee::Rect) {
+        ImVec2 start = ImVec2(canvasPos.x + marqueeStart.x * canvasScale + canvasOffset.x,
+            canvasPos.y + marqueeStart.y * canvasScale + canvasOffset.y);
+        ImVec2 end = ImGui::GetMousePos();
+        ImVec2 rectMin = ImVec2(std::min(start.x, end.x), std::min(start.y, end.y));
+        ImVec2 rectMax = ImVec2(std::max(start.x, end.x), std::max(start.y, end.y));
+        drawList->AddRectFilled(rectMin, rectMax, MARQUEE_FILL_COLOR);
+        drawList->AddRect(rectMin, rectMax, MARQUEE_COLOR);
+    }
+    else if (marquee == Marquee::Lasso && lassoPoints.size() > 1) {
+        std::vector<ImVec2> outline;
+        outline.reserve(lassoPoints.size());
+        for (const ImVec2& point : lassoPoints) {
+            outline.push_back(ImVec2(canvasPos.x + point.x * canvasScale + canvasOffset.x,
+                canvasPos.y + point.y * canvasScale + canvasOffset.y));
+        }
+        drawList->AddPolyline(outline.data(), static_cast<int>(outline.size()), MARQUEE_COLOR,
+            ImDrawFlags_Closed, 1.5f);
+    }
+
+    // Delete removes the whole selection in one batch
+    if (isCanvasHovered && !ImGui::GetIO().WantTextInput && ImGui::IsKeyPressed(ImGuiKey_Delete, false)) {
+        removeSelectedNodes();
+    }
+
+    if (showMinimap) {
+        renderMinimap(canvasPos, canvasSize);
+    }
+
+    // Display canvas controls information
+    ImGui::SetCursorPos(ImVec2(10, 10));
+    ImGui::BeginChild("CanvasControls", ImVec2(200, 150), true);
     ImGui::Text("Canvas Controls:");
     ImGui::BulletText("Pan: Middle Mouse");
     ImGui::BulletText("Alt+Right Mouse");
     ImGui::BulletText("Zoom: Mouse Wheel");
     ImGui::BulletText("Select: Left Click");
-    ImGui::Text("Scale: %.2f", canvasScale);
+    ImGui::BulletText("Box: Drag, Lasso: Alt+Drag");
+    ImGui::BulletText("Shift adds, Ctrl toggles");
+    ImGui::BulletText("Delete: Remove Selection");
+    if (clusterLevel >= 0) {
+        ImGui::Text("Scale: %.2f (%zu clusters)", canvasScale, visibleClusters.size());
+    }
+    else {
+        ImGui::Text("Scale: %.2f", canvasScale);
+    }
     ImGui::EndChild();
 }
-void GraphEditor::drawNode(ImDrawList* drawList, const std::shared_ptr<Node>& node, const ImVec2& canvasPos) {
+
+void GraphEditor::handleCanvasSelection(const ImVec2& canvasPos, bool isCanvasActive) {
+    PROFILE_SCOPE("GraphEditor::handleCanvasSelection");
+    const ImGuiIO& io = ImGui::GetIO();
+    ImVec2 mousePos = ImGui::GetMousePos();
+    ImVec2 mouseGraph = ImVec2((mousePos.x - canvasPos.x - canvasOffset.x) / canvasScale,
+        (mousePos.y - canvasPos.y - canvasOffset.y) / canvasScale);
+
+    if (isCanvasActive && ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+        // Nearest node under the mouse, among the nodes of the cells around it
+        clusters.update(currentGraph);
+        clusters.queryRect(mouseGraph.x - NODE_RADIUS, mouseGraph.y - NODE_RADIUS,
+            mouseGraph.x + NODE_RADIUS, mouseGraph.y + NODE_RADIUS, selectionSlots);
+        int64_t hit = -1;
+        float hitDistSq = NODE_RADIUS * NODE_RADIUS;
+        for (uint32_t slot : selectionSlots) {
+            const Node& node = *currentGraph->nodes[slot];
+            float distSq = (node.x - mouseGraph.x) * (node.x - mouseGraph.x) +
+                (node.y - mouseGraph.y) * (node.y - mouseGraph.y);
+            if (distSq <= hitDistSq) {
+                hit = slot;
+                hitDistSq = distSq;
+            }
+        }
+
+        selection.update(currentGraph);
+        if (hit >= 0 && io.KeyCtrl) {
+            selection.toggle(static_cast<size_t>(hit));
+            selectedNodeId = selection.contains(static_cast<size_t>(hit)) ? currentGraph->nodes[hit]->id : "";
+            selectedEdge = nullptr;
+        }
+        else if (hit >= 0) {
+            // Pressing an unselected node starts a new selection unless Shift extends it
+            if (!io.KeyShift && !selection.contains(static_cast<size_t>(hit))) {
+                selection.clear();
+            }
+            selection.add(static_cast<size_t>(hit));
+            selectedNodeId = currentGraph->nodes[hit]->id;
+            selectedEdge = nullptr;
+            isDragging = true;
+        }
+        else {
+            if (!io.KeyShift && !io.KeyCtrl) {
+                clearSelections();
+            }
+            marquee = io.KeyAlt ? Marquee::Lasso : Marquee::Rect;
+            marqueeToggles = io.KeyCtrl;
+            marqueeStart = mouseGraph;
+            lassoPoints.assign(1, mouseGraph);
+        }
+    }
+
+    // Group drag: one offset applied to every selected node (only while the press started
+    // on the canvas, not on an overlay)
+    if (isDragging) {
+        if (!isCanvasActive || !ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+            isDragging = false;
+        }
+        else if (io.MouseDelta.x != 0.0f || io.MouseDelta.y != 0.0f) {
+            selection.getSlots(selectionSlots);
+            currentGraph->moveNodes(selectionSlots, io.MouseDelta.x / canvasScale, io.MouseDelta.y / canvasScale);
+        }
+    }
+
+    if (marquee == Marquee::Lasso && ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+        const ImVec2& last = lassoPoints.back();
+        float dx = (mouseGraph.x - last.x) * canvasScale;
+        float dy = (mouseGraph.y - last.y) * canvasScale;
+        if (dx * dx + dy * dy >= LASSO_POINT_SPACING * LASSO_POINT_SPACING) {
+            lassoPoints.push_back(mouseGraph);
+        }
+    }
+    if (marquee != Marquee::None && !ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+        finishMarquee(mouseGraph);
+    }
+}
+
+void GraphEditor::finishMarquee(const ImVec2& mouseGraph) {
+    PROFILE_SCOPE("GraphEditor::finishMarquee");
+    Marquee mode = marquee;
+    marquee = Marquee::None;
+
+    // Candidates come from the cells under the rectangle or the lasso's bounds
+    float minX = std::min(marqueeStart.x, mouseGraph.x);
+    float minY = std::min(marqueeStart.y, mouseGraph.y);
+    float maxX = std::max(marqueeStart.x, mouseGraph.x);
+    float maxY = std::max(marqueeStart.y, mouseGraph.y);
+    if (mode == Marquee::Lasso) {
+        if (lassoPoints.size() < 3) {
+            lassoPoints.clear();
+            return;
+        }
+        minX = maxX = lassoPoints[0].x;
+        minY = maxY = lassoPoints[0].y;
+        for (const ImVec2& point : lassoPoints) {
+            minX = std::min(minX, point.x);
+            minY = std::min(minY, point.y);
+            maxX = std::max(maxX, point.x);
+            maxY = std::max(maxY, point.y);
+        }
+    }
+
+    clusters.update(currentGraph);
+    clusters.queryRect(minX, minY, maxX, maxY, selectionSlots);
+    selection.update(currentGraph);
+    for (uint32_t slot : selectionSlots) {
+        const Node& node = *currentGraph->nodes[slot];
+        if (mode == Marquee::Lasso && !isInsidePolygon(lassoPoints, node.x, node.y)) {
+            continue;
+        }
+        if (marqueeToggles) {
+            selection.toggle(slot);
+        }
+        else {
+            selection.add(slot);
+        }
+    }
+    lassoPoints.clear();
+
+    // Keep a primary node for the panels that work on one node
+    auto primary = currentGraph->nodeIndex.find(selectedNodeId);
+    if (primary == currentGraph->nodeIndex.end() || !selection.contains(primary->second)) {
+        selection.getSlots(selectionSlots);
+        selectedNodeId = selectionSlots.empty() ? "" : currentGraph->nodes[selectionSlots[0]]->id;
+    }
+}
+
+void GraphEditor::renderMinimap(const ImVec2& canvasPos, const ImVec2& canvasSize) {
+    PROFILE_SCOPE("GraphEditor::renderMinimap");
+    if (canvasSize.x < MINIMAP_SIZE.x * 2.0f || canvasSize.y < MINIMAP_SIZE.y * 2.0f) {
+        return;
+    }
+    minimap.update(*currentGraph);
+
+    // Bottom-right corner of the canvas
+    ImGui::SetCursorScreenPos(ImVec2(canvasPos.x + canvasSize.x - MINIMAP_SIZE.x - 10.0f,
+        canvasPos.y + canvasSize.y - MINIMAP_SIZE.y - 10.0f));
+    ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(4.0f, 4.0f));
+    ImGui::BeginChild("Minimap", MINIMAP_SIZE, true, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse);
+    ImGui::PopStyleVar();
+
+    ImVec2 areaMin = ImGui::GetCursorScreenPos();
+    ImVec2 areaSize = ImGui::GetContentRegionAvail();
+    ImVec2 areaMax = ImVec2(areaMin.x + areaSize.x, areaMin.y + areaSize.y);
+    ImGui::InvisibleButton("minimap", areaSize);
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    drawList->AddRectFilled(areaMin, areaMax, MINIMAP_BG_COLOR);
+    if (minimap.isEmpty()) {
+        ImGui::EndChild();
+        return;
+    }
+
+    ImVec2 mapMin;
+    ImVec2 mapMax;
+    minimap.fit(areaMin, areaMax, mapMin, mapMax);
+
+    // Click or drag centres the canvas on the point under the mouse
+    if (ImGui::IsItemActive() && ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+        ImVec2 target = minimap.toGraph(ImGui::GetMousePos(), mapMin, mapMax);
+        canvasOffset.x = canvasSize.x * 0.5f - target.x * canvasScale;
+        canvasOffset.y = canvasSize.y * 0.5f - target.y * canvasScale;
+    }
+
+    minimap.draw(drawList, mapMin, mapMax, MINIMAP_POINT_COLOR);
+
+    // Current viewport, clipped to the minimap
+    ImVec2 viewMin = minimap.toMap(ImVec2(-canvasOffset.x / canvasScale, -canvasOffset.y / canvasScale),
+        mapMin, mapMax);
+    ImVec2 viewMax = minimap.toMap(ImVec2((canvasSize.x - canvasOffset.x) / canvasScale,
+        (canvasSize.y - canvasOffset.y) / canvasScale), mapMin, mapMax);
+    drawList->PushClipRect(areaMin, areaMax, true);
+    drawList->AddRect(viewMin, viewMax, MINIMAP_VIEW_COLOR, 0.0f, 0, 1.5f);
+    drawList->PopClipRect();
+
+    ImGui::EndChild();
+}
+
+int GraphEditor::clusterLevelFor(float scale) const {
+    if (!currentGraph || currentGraph->nodes.size() < CLUSTER_MIN_NODES || scale >= CLUSTER_DETAIL_SCALE) {
+        return -1;
+    }
+    for (int level = 0; level < GraphClusters::LEVEL_COUNT; ++level) {
+        if (GraphClusters::cellSize(level) * scale >= CLUSTER_MIN_PIXELS) {
+            return level;
+        }
+    }
+    return GraphClusters::LEVEL_COUNT - 1;
+}
+
+float GraphEditor::clusterRadius(const GraphClusters::Cluster& cluster, float cellPixels) const {
+    float radius = 4.0f + 3.0f * std::log2(static_cast<float>(cluster.count) + 1.0f);
+    return std::min(radius, cellPixels * 0.4f);
+}
+
+void GraphEditor::drawClusters(ImDrawList* drawList, const ImVec2& canvasPos, const ImVec2& canvasSize, int level) {
+    PROFILE_SCOPE("GraphEditor::drawClusters");
+    const GraphClusters::Level& clusterLevel = clusters.getLevel(level);
+    float cell = GraphClusters::cellSize(level);
+    float cellPixels = cell * canvasScale;
+
+    // Cells overlapping the canvas; look them up one by one unless the level has fewer clusters
+    int32_t minX = static_cast<int32_t>(std::floor(-canvasOffset.x / cellPixels));
+    int32_t minY = static_cast<int32_t>(std::floor(-canvasOffset.y / cellPixels));
+    int32_t maxX = static_cast<int32_t>(std::floor((canvasSize.x - canvasOffset.x) / cellPixels));
+    int32_t maxY = static_cast<int32_t>(std::floor((canvasSize.y - canvasOffset.y) / cellPixels));
+    auto isVisible = [&](uint64_t key) {
+        int32_t x = GraphClusters::cellX(key);
+        int32_t y = GraphClusters::cellY(key);
+        return x >= minX && x <= maxX && y >= minY && y <= maxY;
+    };
+
+    visibleClusters.clear();
+    uint64_t cellCount = static_cast<uint64_t>(maxX - minX + 1) * static_cast<uint64_t>(maxY - minY + 1);
+    if (cellCount > clusterLevel.size()) {
+        for (const auto& pair : clusterLevel) {
+            if (isVisible(pair.first)) {
+                visibleClusters.emplace_back(pair.first, &pair.second);
+            }
+        }
+    }
+    else {
+        for (int32_t y = minY; y <= maxY; ++y) {
+            for (int32_t x = minX; x <= maxX; ++x) {
+                auto it = clusterLevel.find(GraphClusters::cellKey(x, y));
+                if (it != clusterLevel.end()) {
+                    visibleClusters.emplace_back(it->first, &it->second);
+                }
+            }
+        }
+    }
+
+    ImVec2 origin = ImVec2(canvasPos.x + canvasOffset.x, canvasPos.y + canvasOffset.y);
+    auto toScreen = [&](const GraphClusters::Cluster& cluster) {
+        return ImVec2(origin.x + cluster.centerX() * canvasScale, origin.y + cluster.centerY() * canvasScale);
+    };
+
+    // One bundled edge per linked pair: outgoing links of visible clusters, plus incoming
+    // links whose source is off screen
+    auto drawLink = [&](const GraphClusters::Cluster& from, const GraphClusters::Cluster& to, uint32_t count) {
+        ImVec2 a = toScreen(from);
+        ImVec2 b = toScreen(to);
+        float dx = b.x - a.x;
+        float dy = b.y - a.y;
+        float length = std::sqrt(dx * dx + dy * dy);
+        if (length <= 0.0f) {
+            return;
+        }
+        float fromRadius = clusterRadius(from, cellPixels);
+        float toRadius = clusterRadius(to, cellPixels);
+        ImVec2 start = ImVec2(a.x + dx / length * fromRadius, a.y + dy / length * fromRadius);
+        ImVec2 end = ImVec2(b.x - dx / length * toRadius, b.y - dy / length * toRadius);
+        float thickness = std::min(1.0f + std::log2(static_cast<float>(count)), 8.0f);
+        drawList->AddLine(start, end, CLUSTER_LINK_COLOR, thickness);
+        drawDirectedArrow(drawList, start, end, CLUSTER_LINK_COLOR, thickness, ARROW_SIZE);
+    };
+
+    for (const auto& visible : visibleClusters) {
+        const GraphClusters::Cluster& cluster = *visible.second;
+        for (const auto& link : cluster.out) {
+            auto it = clusterLevel.find(link.first);
+            if (it != clusterLevel.end()) {
+                drawLink(cluster, it->second, link.second);
+            }
+        }
+        for (const auto& link : cluster.in) {
+            auto it = clusterLevel.find(link.first);
+            if (!isVisible(link.first) && it != clusterLevel.end()) {
+                drawLink(it->second, cluster, link.second);
+            }
+        }
+    }
+
+    for (const auto& visible : visibleClusters) {
+        const GraphClusters::Cluster& cluster = *visible.second;
+        ImVec2 center = toScreen(cluster);
+        float radius = clusterRadius(cluster, cellPixels);
+        drawList->AddCircleFilled(center, radius, CLUSTER_COLOR);
+        drawList->AddCircle(center, radius, NODE_OUTLINE_COLOR, 0, 2.0f);
+
+        if (radius >= 10.0f) {
+            char label[16];
+            snprintf(label, sizeof(label), "%u", cluster.count);
+            ImVec2 textSize = ImGui::CalcTextSize(label);
+            drawList->AddText(ImVec2(center.x - textSize.x * 0.5f, center.y - textSize.y * 0.5f),
+                IM_COL32(255, 255, 255, 255), label);
+        }
+    }
+}
+
+void GraphEditor::expandClusterAt(const ImVec2& mousePos, const ImVec2& canvasPos, const ImVec2& canvasSize, int level) {
+    float cellPixels = GraphClusters::cellSize(level) * canvasScale;
+    for (const auto& visible : visibleClusters) {
+        const GraphClusters::Cluster& cluster = *visible.second;
+        float x = canvasPos.x + cluster.centerX() * canvasScale + canvasOffset.x;
+        float y = canvasPos.y + cluster.centerY() * canvasScale + canvasOffset.y;
+        float radius = clusterRadius(cluster, cellPixels);
+        if ((mousePos.x - x) * (mousePos.x - x) + (mousePos.y - y) * (mousePos.y - y) > radius * radius) {
+            continue;
+        }
+
+        // Zoom so the cluster's cells split into the next level down (or into nodes),
+        // centred on the cluster
+        canvasScale = level > 0 ? CLUSTER_MIN_PIXELS / GraphClusters::cellSize(level - 1) : CLUSTER_DETAIL_SCALE;
+        canvasScale = std::max(MIN_CANVAS_SCALE, std::min(canvasScale, MAX_CANVAS_SCALE));
+        canvasOffset.x = canvasSize.x * 0.5f - cluster.centerX() * canvasScale;
+        canvasOffset.y = canvasSize.y * 0.5f - cluster.centerY() * canvasScale;
+        return;
+    }
+}
+
+void GraphEditor::drawNode(ImDrawList* drawList, const std::shared_ptr<Node>& node, const ImVec2& canvasPos,
+    ImU32 outlineColor, bool isSelected) {
     ImVec2 nodePos = ImVec2(
         canvasPos.x + node->x * canvasScale + canvasOffset.x,
         canvasPos.y + node->y * canvasScale + canvasOffset.y
     );
 
-    ImU32 color = (node->id == selectedNodeId) ? NODE_SELECTED_COLOR : NODE_COLOR;
+    ImU32 color = isSelected ? NODE_SELECTED_COLOR : NODE_COLOR;
 
     drawList->AddCircleFilled(nodePos, NODE_RADIUS * canvasScale, color);
-    drawList->AddCircle(nodePos, NODE_RADIUS * canvasScale, IM_COL32(255, 255, 255, 100), 0, 2.0f);
+    drawList->AddCircle(nodePos, NODE_RADIUS * canvasScale, outlineColor, 0,
+        outlineColor == NODE_OUTLINE_COLOR ? NODE_OUTLINE_THICKNESS : STATUS_OUTLINE_THICKNESS);
 
     // Center the text
     ImVec2 textSize = ImGui::CalcTextSize(node->id.c_str());
@@ -407,24 +1510,26 @@ void GraphEditor::drawNode(ImDrawList* drawList, const std::shared_ptr<Node>& no
         nodePos.y - textSize.y * 0.5f
     );
 
-    drawList->AddText(textPos, IM_COL32(255, 255, 255, 255), node->id.c_str());
+    drawList->AddText(textPos, LABEL_COLOR, node->id.c_str());
 }
 
-void GraphEditor::drawEdge(ImDrawList* drawList, const std::shared_ptr<Edge>& edge,
-    const std::shared_ptr<Node>& fromNode,
-    const std::shared_ptr<Node>& toNode,
-    const ImVec2& canvasPos) {
+void GraphEditor::drawEdge(ImDrawList* drawList, size_t slot, const Edge& edge,
+    const Node& fromNode,
+    const Node& toNode,
+    const ImVec2& canvasPos,
+    bool isSelected,
+    bool isTrap) {
     ImVec2 fromPos = ImVec2(
-        canvasPos.x + fromNode->x * canvasScale + canvasOffset.x,
-        canvasPos.y + fromNode->y * canvasScale + canvasOffset.y
+        canvasPos.x + fromNode.x * canvasScale + canvasOffset.x,
+        canvasPos.y + fromNode.y * canvasScale + canvasOffset.y
     );
 
     ImVec2 toPos = ImVec2(
-        canvasPos.x + toNode->x * canvasScale + canvasOffset.x,
-        canvasPos.y + toNode->y * canvasScale + canvasOffset.y
+        canvasPos.x + toNode.x * canvasScale + canvasOffset.x,
+        canvasPos.y + toNode.y * canvasScale + canvasOffset.y
     );
 
-    ImU32 color = (selectedEdge && *edge == *selectedEdge) ? EDGE_SELECTED_COLOR : EDGE_COLOR;
+    ImU32 color = isSelected ? EDGE_SELECTED_COLOR : (isTrap ? DEAD_END_COLOR : EDGE_COLOR);
 
     // Adjust start and end points to be on the node boundaries
     float angle = atan2(toPos.y - fromPos.y, toPos.x - fromPos.x);
@@ -439,65 +1544,41 @@ void GraphEditor::drawEdge(ImDrawList* drawList, const std::shared_ptr<Edge>& ed
     );
 
     // Check if there's a bidirectional edge
-    bool isBidirectional = false;
-    for (const auto& otherEdge : currentGraph->edges) {
-        if (otherEdge->from == edge->to && otherEdge->to == edge->from) {
-            isBidirectional = true;
-            break;
-        }
-    }
+    bool isBidirectional = curveCache.isCurved(slot);
 
     // Draw the arrow differently if it's bidirectional
     if (isBidirectional) {
-        // Calculate offset for curved lines
-        float dx = toPos.x - fromPos.x;
-        float dy = toPos.y - fromPos.y;
-        float dist = sqrt(dx * dx + dy * dy);
-
-        // Normal vector
-        float nx = -dy / dist;
-        float ny = dx / dist;
-
-        // Control point offset
-        float offset = std::min(dist * 0.2f, 50.0f * canvasScale);
-
-        ImVec2 control = ImVec2(
-            (fromPos.x + toPos.x) * 0.5f + nx * offset,
-            (fromPos.y + toPos.y) * 0.5f + ny * offset
-        );
-
-        // Draw the curved arrow
-        drawList->AddBezierCubic(
-            fromAdjusted,
-            ImVec2(fromAdjusted.x + (control.x - fromAdjusted.x) * 0.5f,
-                fromAdjusted.y + (control.y - fromAdjusted.y) * 0.5f),
-            ImVec2(toAdjusted.x + (control.x - toAdjusted.x) * 0.5f,
-                toAdjusted.y + (control.y - toAdjusted.y) * 0.5f),
-            toAdjusted,
-            color,
-            EDGE_THICKNESS * canvasScale
-        );
-
-        // Calculate the angle at the end of the curve for the arrow
-        ImVec2 tangent = ImVec2(
-            toAdjusted.x - (control.x + toAdjusted.x) * 0.5f,
-            toAdjusted.y - (control.y + toAdjusted.y) * 0.5f
-        );
+        // Cached graph-space curve, placed on screen with one scale and offset
+        const auto& curve = curveCache.get(slot, fromNode, toNode, canvasScale,
+            drawList->_Data->CurveTessellationTol);
+
+        // Coincident endpoints have no curve (the label is still drawn)
+        if (curve.size() >= 2) {
+            ImVec2 origin = ImVec2(canvasPos.x + canvasOffset.x, canvasPos.y + canvasOffset.y);
+            drawList->PathClear();
+            for (const auto& point : curve) {
+                drawList->PathLineTo(ImVec2(origin.x + point.x * canvasScale, origin.y + point.y * canvasScale));
+            }
+            drawList->PathStroke(color, 0, EDGE_THICKNESS * canvasScale);
 
-        float arrowAngle = atan2(tangent.y, tangent.x);
+            // Arrow head along the last cached segment
+            const ImVec2& tip = curve[curve.size() - 1];
+            const ImVec2& before = curve[curve.size() - 2];
+            float arrowAngle = atan2(tip.y - before.y, tip.x - before.x);
+            ImVec2 curveEnd = ImVec2(origin.x + tip.x * canvasScale, origin.y + tip.y * canvasScale);
 
-        // Draw the arrow head
-        ImVec2 arrowP1 = ImVec2(
-            toAdjusted.x - ARROW_SIZE * canvasScale * cos(arrowAngle - 0.5f),
-            toAdjusted.y - ARROW_SIZE * canvasScale * sin(arrowAngle - 0.5f)
-        );
+            ImVec2 arrowP1 = ImVec2(
+                curveEnd.x - ARROW_SIZE * canvasScale * cos(arrowAngle - ARROW_ANGLE),
+                curveEnd.y - ARROW_SIZE * canvasScale * sin(arrowAngle - ARROW_ANGLE)
+            );
 
-        ImVec2 arrowP2 = ImVec2(
-            toAdjusted.x - ARROW_SIZE * canvasScale * cos(arrowAngle + 0.5f),
-            toAdjusted.y - ARROW_SIZE * canvasScale * sin(arrowAngle + 0.5f)
-        );
+            ImVec2 arrowP2 = ImVec2(
+                curveEnd.x - ARROW_SIZE * canvasScale * cos(arrowAngle + ARROW_ANGLE),
+                curveEnd.y - ARROW_SIZE * canvasScale * sin(arrowAngle + ARROW_ANGLE)
+            );
 
-        drawList->AddTriangleFilled(toAdjusted, arrowP1, arrowP2, color);
+            drawList->AddTriangleFilled(curveEnd, arrowP1, arrowP2, color);
+        }
     }
     else {
         // Draw a straight arrow
@@ -508,24 +1589,224 @@ void GraphEditor::drawEdge(ImDrawList* drawList, const std::shared_ptr<Edge>& ed
     }
 
     // Draw the weight
-    std::string weightText = std::to_string(edge->weight);
+    char weightText[32];
+    ImFormatString(weightText, sizeof(weightText), "%f", edge.weight);
     ImVec2 midpoint = ImVec2(
         (fromAdjusted.x + toAdjusted.x) * 0.5f,
         (fromAdjusted.y + toAdjusted.y) * 0.5f
     );
 
-    ImVec2 textSize = ImGui::CalcTextSize(weightText.c_str());
+    ImVec2 textSize = ImGui::CalcTextSize(weightText);
     drawList->AddRectFilled(
-        ImVec2(midpoint.x - textSize.x * 0.5f - 2, midpoint.y - textSize.y * 0.5f - 2),
-        ImVec2(midpoint.x + textSize.x * 0.5f + 2, midpoint.y + textSize.y * 0.5f + 2),
-        IM_COL32(30, 30, 30, 200)
+        ImVec2(midpoint.x - textSize.x * 0.5f - LABEL_PADDING, midpoint.y - textSize.y * 0.5f - LABEL_PADDING),
+        ImVec2(midpoint.x + textSize.x * 0.5f + LABEL_PADDING, midpoint.y + textSize.y * 0.5f + LABEL_PADDING),
+        LABEL_BG_COLOR
     );
 
     drawList->AddText(
         ImVec2(midpoint.x - textSize.x * 0.5f, midpoint.y - textSize.y * 0.5f),
-        IM_COL32(255, 255, 255, 255),
-        weightText.c_str()
+        LABEL_COLOR,
+        weightText
+    );
+}
+
+void GraphEditor::drawRoute(ImDrawList* drawList, const Route& route, const ImVec2& canvasPos) {
+    for (size_t i = 1; i < route.nodes.size(); ++i) {
+        auto fromNode = currentGraph->findNode(route.nodes[i - 1]);
+        auto toNode = currentGraph->findNode(route.nodes[i]);
+        if (!fromNode || !toNode) {
+            continue;
+        }
+
+        ImVec2 fromPos = ImVec2(
+            canvasPos.x + fromNode->x * canvasScale + canvasOffset.x,
+            canvasPos.y + fromNode->y * canvasScale + canvasOffset.y
+        );
+        ImVec2 toPos = ImVec2(
+            canvasPos.x + toNode->x * canvasScale + canvasOffset.x,
+            canvasPos.y + toNode->y * canvasScale + canvasOffset.y
+        );
+
+        drawList->AddLine(fromPos, toPos, ROUTE_COLOR, EDGE_THICKNESS * 3.0f * canvasScale);
+    }
+}
+
+void GraphEditor::drawTransferMarker(ImDrawList* drawList, const std::shared_ptr<Node>& node, const ImVec2& canvasPos) {
+    ImVec2 nodePos = ImVec2(
+        canvasPos.x + node->x * canvasScale + canvasOffset.x,
+        canvasPos.y + node->y * canvasScale + canvasOffset.y
     );
+
+    drawList->AddCircle(nodePos, (NODE_RADIUS + 5.0f) * canvasScale, TRANSFER_COLOR, 0, 2.0f * canvasScale);
+}
+
+void GraphEditor::drawBlockedNode(ImDrawList* drawList, const std::shared_ptr<Node>& node, const ImVec2& canvasPos) {
+    ImVec2 nodePos = ImVec2(
+        canvasPos.x + node->x * canvasScale + canvasOffset.x,
+        canvasPos.y + node->y * canvasScale + canvasOffset.y
+    );
+
+    float r = NODE_RADIUS * 0.7f * canvasScale;
+    drawList->AddLine(ImVec2(nodePos.x - r, nodePos.y - r), ImVec2(nodePos.x + r, nodePos.y + r), BLOCKED_COLOR, 4.0f * canvasScale);
+    drawList->AddLine(ImVec2(nodePos.x - r, nodePos.y + r), ImVec2(nodePos.x + r, nodePos.y - r), BLOCKED_COLOR, 4.0f * canvasScale);
+}
+
+bool GraphEditor::resolveMachine(MachineState& machine) {
+    const MachineSample& sample = machine.sample;
+    bool same = machine.resolvedGraph == currentGraph.get() &&
+        machine.resolvedTopology == currentGraph->topologyVersion &&
+        strncmp(machine.resolved.fromNode, sample.fromNode, MachineSample::ID_SIZE) == 0 &&
+        strncmp(machine.resolved.toNode, sample.toNode, MachineSample::ID_SIZE) == 0;
+    if (!same) {
+        machine.resolved = sample;
+        machine.resolvedGraph = currentGraph.get();
+        machine.resolvedTopology = currentGraph->topologyVersion;
+        machine.fromSlot = -1;
+        machine.toSlot = -1;
+        machine.edgeSlot = -1;
+        machine.curved = false;
+
+        auto fromIt = currentGraph->nodeIndex.find(sample.fromNode);
+        if (fromIt != currentGraph->nodeIndex.end()) {
+            machine.fromSlot = static_cast<int64_t>(fromIt->second);
+        }
+        auto toIt = currentGraph->nodeIndex.find(sample.toNode);
+        if (sample.toNode[0] != '\0' && toIt != currentGraph->nodeIndex.end()) {
+            machine.toSlot = static_cast<int64_t>(toIt->second);
+            auto edgeIt = currentGraph->edgeIndex.find(std::make_pair(std::string(sample.fromNode), std::string(sample.toNode)));
+            if (edgeIt != currentGraph->edgeIndex.end()) {
+                machine.edgeSlot = static_cast<int64_t>(edgeIt->second);
+                machine.curved = currentGraph->findEdge(sample.toNode, sample.fromNode) != nullptr;
+            }
+        }
+    }
+    return machine.fromSlot >= 0;
+}
+
+void GraphEditor::drawMachineOverlay(ImDrawList* drawList, const ImVec2& canvasPos) {
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < machineCount; ++i) {
+        MachineState& machine = machines[i];
+        if (currentGraphName.compare(machine.sample.graph) != 0 || !resolveMachine(machine)) {
+            continue;
+        }
+
+        bool stale = std::chrono::duration<float>(now - machine.received).count() > MACHINE_STALE_SECONDS;
+        ImU32 color = stale ? MACHINE_STALE_COLOR : MACHINE_COLOR;
+        auto toScreen = [&](float x, float y) {
+            return ImVec2(canvasPos.x + x * canvasScale + canvasOffset.x, canvasPos.y + y * canvasScale + canvasOffset.y);
+        };
+        const Node& from = *currentGraph->nodes[machine.fromSlot];
+        float progress = std::max(0.0f, std::min(machine.sample.progress, 1.0f));
+        char label[96];
+
+        if (machine.toSlot < 0) {
+            // Standing at a node
+            ImVec2 p = toScreen(from.x, from.y);
+            drawList->AddCircle(p, NODE_RADIUS * canvasScale + 6.0f, color, 0, 4.0f);
+            snprintf(label, sizeof(label), "%s", machine.sample.fromNode);
+            drawList->AddText(ImVec2(p.x + NODE_RADIUS * canvasScale + 8.0f, p.y - 8.0f), color, label);
+            continue;
+        }
+
+        // In transit: highlight the edge and mark the position along it
+        const Node& to = *currentGraph->nodes[machine.toSlot];
+        ImVec2 position = drawEdgeProgress(drawList, machine.curved ? machine.edgeSlot : -1, from, to, progress,
+            canvasPos, color);
+        drawList->AddCircleFilled(position, 9.0f, color);
+        drawList->AddCircle(position, 9.0f, IM_COL32(0, 0, 0, 255), 0, 2.0f);
+        snprintf(label, sizeof(label), "%s -> %s %d%%", machine.sample.fromNode, machine.sample.toNode,
+            static_cast<int>(progress * 100.0f));
+        drawList->AddText(ImVec2(position.x + 12.0f, position.y - 8.0f), color, label);
+    }
+}
+
+void GraphEditor::drawSimulationReplay(ImDrawList* drawList, const ImVec2& canvasPos) {
+    // Agents in a conflict that is going on at the replay time
+    agentInConflict.assign(simulation.agentNames.size(), 0);
+    for (const auto& conflict : simulation.conflicts) {
+        if (conflict.begin > replayTime) {
+            break;
+        }
+        if (conflict.end > replayTime) {
+            agentInConflict[conflict.agents[0]] = 1;
+            agentInConflict[conflict.agents[1]] = 1;
+        }
+    }
+
+    // Slots name nodes of the graph as it was simulated; after an edit the replay is hidden
+    for (size_t i = 0; i < simulation.agentNames.size(); ++i) {
+        if (simulation.agentGraphs[i] != currentGraphName ||
+            simulation.graphVersions[i] != currentGraph->topologyVersion) {
+            continue;
+        }
+        uint32_t fromSlot, toSlot;
+        float progress;
+        simulation.positionAt(i, replayTime, fromSlot, toSlot, progress);
+        ImU32 color = agentInConflict[i] ? SIM_CONFLICT_COLOR : SIM_AGENT_COLOR;
+        const Node& from = *currentGraph->nodes[fromSlot];
+        ImVec2 position;
+        if (fromSlot == toSlot) {
+            position = ImVec2(canvasPos.x + from.x * canvasScale + canvasOffset.x,
+                canvasPos.y + from.y * canvasScale + canvasOffset.y);
+            drawList->AddCircle(position, NODE_RADIUS * canvasScale + 6.0f, color, 0, 4.0f);
+        }
+        else {
+            const Node& to = *currentGraph->nodes[toSlot];
+            int64_t curveSlot = -1;
+            if (currentGraph->findEdge(to.id, from.id)) {
+                auto edgeIt = currentGraph->edgeIndex.find(std::make_pair(from.id, to.id));
+                if (edgeIt != currentGraph->edgeIndex.end()) {
+                    curveSlot = static_cast<int64_t>(edgeIt->second);
+                }
+            }
+            position = drawEdgeProgress(drawList, curveSlot, from, to, progress, canvasPos, color);
+            drawList->AddCircleFilled(position, 7.0f, color);
+        }
+        drawList->AddText(ImVec2(position.x + 10.0f, position.y - 8.0f), color, simulation.agentNames[i].c_str());
+    }
+}
+
+// Highlights an edge as it is drawn, along its cached curve when it is bidirectional (edge
+// slot given), and returns the point 'progress' of the way along it
+ImVec2 GraphEditor::drawEdgeProgress(ImDrawList* drawList, int64_t curveSlot, const Node& from, const Node& to,
+    float progress, const ImVec2& canvasPos, ImU32 color) {
+    auto toScreen = [&](float x, float y) {
+        return ImVec2(canvasPos.x + x * canvasScale + canvasOffset.x, canvasPos.y + y * canvasScale + canvasOffset.y);
+    };
+    ImVec2 position;
+    if (curveSlot >= 0) {
+        // Same cached curve the edge is drawn with, walked by arc length
+        const auto& curve = curveCache.get(static_cast<size_t>(curveSlot), from, to, canvasScale,
+            drawList->_Data->CurveTessellationTol);
+        float length = 0.0f;
+        for (size_t k = 1; k < curve.size(); ++k) {
+            length += std::hypot(curve[k].x - curve[k - 1].x, curve[k].y - curve[k - 1].y);
+        }
+        float remaining = length * progress;
+        position = curve.empty() ? toScreen(from.x, from.y) : toScreen(curve.back().x, curve.back().y);
+        for (size_t k = 1; k < curve.size(); ++k) {
+            drawList->PathLineTo(toScreen(curve[k - 1].x, curve[k - 1].y));
+            float segment = std::hypot(curve[k].x - curve[k - 1].x, curve[k].y - curve[k - 1].y);
+            if (remaining >= 0.0f && remaining <= segment && segment > 0.0f) {
+                float t = remaining / segment;
+                position = toScreen(curve[k - 1].x + (curve[k].x - curve[k - 1].x) * t,
+                    curve[k - 1].y + (curve[k].y - curve[k - 1].y) * t);
+            }
+            remaining -= segment;
+        }
+        if (!curve.empty()) {
+            drawList->PathLineTo(toScreen(curve.back().x, curve.back().y));
+        }
+        drawList->PathStroke(color, 0, EDGE_THICKNESS * 2.5f);
+    }
+    else {
+        ImVec2 a = toScreen(from.x, from.y);
+        ImVec2 b = toScreen(to.x, to.y);
+        drawList->AddLine(a, b, color, EDGE_THICKNESS * 2.5f);
+        position = ImVec2(a.x + (b.x - a.x) * progress, a.y + (b.y - a.y) * progress);
+    }
+    return position;
 }
 
 void GraphEditor::drawDirectedArrow(ImDrawList* drawList, const ImVec2& from, const ImVec2& to,
@@ -533,13 +1814,13 @@ void GraphEditor::drawDirectedArrow(ImDrawList* drawList, const ImVec2& from, co
     float angle = atan2(to.y - from.y, to.x - from.x);
 
     ImVec2 arrowP1 = ImVec2(
-        to.x - arrowSize * cos(angle - 0.5f),
-        to.y - arrowSize * sin(angle - 0.5f)
+        to.x - arrowSize * cos(angle - ARROW_ANGLE),
+        to.y - arrowSize * sin(angle - ARROW_ANGLE)
     );
 
     ImVec2 arrowP2 = ImVec2(
-        to.x - arrowSize * cos(angle + 0.5f),
-        to.y - arrowSize * sin(angle + 0.5f)
+        to.x - arrowSize * cos(angle + ARROW_ANGLE),
+        to.y - arrowSize * sin(angle + ARROW_ANGLE)
     );
 
     drawList->AddTriangleFilled(to, arrowP1, arrowP2, color);
@@ -550,22 +1831,33 @@ void GraphEditor::addNode() {
         currentGraph->addNode(newNodeId);
 
         // Place the new node at a random position on the canvas
-        auto node = currentGraph->findNode(newNodeId);
-        if (node) {
-            node->x = 100.0f + (rand() % int(canvasWidth - 200.0f));
-            node->y = 100.0f + (rand() % int(canvasHeight - 200.0f));
-        }
+        currentGraph->setNodePosition(newNodeId,
+            100.0f + (rand() % int(canvasWidth - 200.0f)),
+            100.0f + (rand() % int(canvasHeight - 200.0f)));
 
         // Clear the input field
         newNodeId.clear();
     }
 }
 
-void GraphEditor::removeSelectedNode() {
-    if (currentGraph && !selectedNodeId.empty()) {
-        currentGraph->removeNode(selectedNodeId);
-        selectedNodeId.clear();
+void GraphEditor::removeSelectedNodes() {
+    if (!currentGraph) {
+        return;
+    }
+    selection.update(currentGraph);
+    std::vector<std::string> ids = selection.getIds();
+    if (ids.empty() && !selectedNodeId.empty()) {
+        ids.push_back(selectedNodeId);
     }
+    if (ids.empty()) {
+        return;
+    }
+
+    // One pass over the edges and nodes, however many are selected
+    GraphBatch batch = currentGraph->beginBatch();
+    batch.removeNodes(ids);
+    batch.commit();
+    clearSelections();
 }
 
 void GraphEditor::addEdge() {
@@ -589,19 +1881,31 @@ void GraphEditor::removeSelectedEdge() {
 void GraphEditor::selectNode(const std::string& nodeId) {
     selectedNodeId = nodeId;
     selectedEdge = nullptr;
+
+    selection.update(currentGraph);
+    selection.clear();
+    auto it = currentGraph->nodeIndex.find(nodeId);
+    if (it != currentGraph->nodeIndex.end()) {
+        selection.add(it->second);
+    }
 }
 
 void GraphEditor::selectEdge(const std::string& from, const std::string& to) {
     selectedNodeId.clear();
+    selection.clear();
     selectedEdge = currentGraph->findEdge(from, to);
 }
 
 void GraphEditor::clearSelections() {
     selectedNodeId.clear();
     selectedEdge = nullptr;
+    selection.clear();
+    marquee = Marquee::None;
+    isDragging = false;
 }
 
 void GraphEditor::layoutGraph() {
+    PROFILE_SCOPE("GraphEditor::layoutGraph");
     if (!currentGraph || currentGraph->nodes.empty()) {
         return;
     }
@@ -647,10 +1951,19 @@ void GraphEditor::layoutGraph() {
             currentGraph->nodes[i]->y = (row - rows / 2.0f) * SPACING;
         }
     }
+
+    // Positions were written directly, so re-derive weights in one pass
+    currentGraph->recomputeWeights();
+    currentGraph->notifyChange(GraphChange::NodeMoved);
 }
 void GraphEditor::loadFile(const std::string& filename) {
-    if (model->loadFromFile(filename)) {
+    // Lazy load: each graph is parsed when it is first selected
+    if (model->loadFromFile(filename, true)) {
         std::cout << "Successfully loaded graph data from: " << filename << std::endl;
+        watchFile(filename);
+        if (filename == graphFile) {
+            graphFileLoaded = true;
+        }
 
         // Auto-select the first graph if available
         auto graphNames = model->getGraphNames();
@@ -672,9 +1985,205 @@ void GraphEditor::loadFile(const std::string& filename) {
     }
 }
 
-void GraphEditor::saveFile(const std::string& filename) {
-    if (model->saveToFile(filename)) {
+void GraphEditor::beginReplay(const InputRecording& recording) {
+    if (model && model->hasGraph(recording.graphName)) {
+        currentGraphName = recording.graphName;
+        currentGraph = model->getGraph(currentGraphName);
+    }
+    canvasOffset = recording.canvasOffset;
+    canvasScale = recording.canvasScale;
+    clearSelections();
+}
+
+void GraphEditor::toggleInputRecording() {
+    if (!isRecordingInput) {
+        // Starts with the next frame, from the current view
+        inputRecording = InputRecording();
+        inputRecording.graphName = currentGraphName;
+        inputRecording.canvasOffset = canvasOffset;
+        inputRecording.canvasScale = canvasScale;
+        isRecordingInput = true;
+        return;
+    }
+
+    isRecordingInput = false;
+    if (inputRecording.save(INPUT_RECORDING_FILE)) {
+        std::cout << "Recorded " << inputRecording.frames.size() << " frames of input to: " << INPUT_RECORDING_FILE << std::endl;
+    }
+    inputRecording = InputRecording();
+}
+
+void GraphEditor::connectMachineFeed(const std::string& name) {
+    machineFeedName = name;
+    machineFeed.close();
+    lastFeedAttempt = std::chrono::steady_clock::time_point();
+}
+
+void GraphEditor::updateMachineFeed() {
+    if (machineFeedName.empty()) {
+        return;
+    }
+    PROFILE_SCOPE("GraphEditor::updateMachineFeed");
+    auto now = std::chrono::steady_clock::now();
+
+    // The producer may start after the editor, or restart with a new segment
+    if (machineFeed.isOpen() && std::chrono::duration<float>(now - lastMachineSample).count() > FEED_TIMEOUT_SECONDS) {
+        machineFeed.close();
+        lastFeedAttempt = now;
+    }
+    if (!machineFeed.isOpen()) {
+        if (std::chrono::duration<float>(now - lastFeedAttempt).count() < FEED_RETRY_SECONDS) {
+            return;
+        }
+        lastFeedAttempt = now;
+        if (!machineFeed.open(machineFeedName)) {
+            return;
+        }
+        lastMachineSample = now;
+    }
+
+    if (machineFeed.drain([&](const MachineSample& sample) { storeMachineSample(sample, now); }) > 0) {
+        lastMachineSample = now;
+    }
+}
+
+void GraphEditor::storeMachineSample(const MachineSample& incoming, std::chrono::steady_clock::time_point received) {
+    // Ids come from another process: terminate them here, they are used as C strings from now on
+    MachineSample sample = incoming;
+    sample.graph[MachineSample::ID_SIZE - 1] = '\0';
+    sample.fromNode[MachineSample::ID_SIZE - 1] = '\0';
+    sample.toNode[MachineSample::ID_SIZE - 1] = '\0';
+
+    // Only the newest sample per graph is kept; a plain copy, no allocation
+    for (size_t i = 0; i < machineCount; ++i) {
+        if (strcmp(machines[i].sample.graph, sample.graph) == 0) {
+            machines[i].sample = sample;
+            machines[i].received = received;
+            return;
+        }
+    }
+    if (machineCount < MAX_MACHINES) {
+        machines[machineCount].sample = sample;
+        machines[machineCount].received = received;
+        ++machineCount;
+    }
+}
+
+void GraphEditor::setAutosave(const std::string& filename, double intervalSeconds) {
+    recoveryFile = filename;
+    autosaveInterval = intervalSeconds;
+    lastAutosave = std::chrono::steady_clock::now();
+}
+
+void GraphEditor::autosave() {
+    if (recoveryFile.empty() || autosaveInterval <= 0.0) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - lastAutosave).count() < autosaveInterval) {
+        return;
+    }
+    lastAutosave = now;
+
+    // Only unsaved graphs are written, and nothing when they have not changed since last time
+    PROFILE_SCOPE("GraphEditor::autosave");
+    if (!model->saveRecovery(recoveryFile)) {
+        std::cerr << "Failed to write recovery file: " << recoveryFile << std::endl;
+    }
+}
+
+void GraphEditor::checkFileChanges() {
+    PROFILE_SCOPE("GraphEditor::checkFileChanges");
+    // Only the merge of changed graphs runs on the UI thread
+    if (pendingReload.valid()) {
+        if (pendingReload.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            auto index = pendingReload.get();
+            if (index) {
+                applyReload(*index);
+            }
+        }
+        return;
+    }
+
+    if (fileWatcher.poll()) {
+        std::string path = fileWatcher.getPath();
+        pendingReload = std::async(std::launch::async, [path]() {
+            auto index = std::make_shared<GraphFileIndex>();
+            return GraphFileIndex::read(path, *index) ? index : nullptr;
+        });
+    }
+}
+
+void GraphEditor::startExport(bool png) {
+    // The snapshot is taken now, so the graph can be edited while the file is written
+    auto snapshot = std::make_shared<GraphExport>();
+    snapshot->capture(*currentGraph, &analysis);
+
+    ExportOptions options;
+    exportFile = png ? "WorkingGraphs.png" : "WorkingGraphs.svg"; // In a real app, this would use a file dialog
+    exportProgress = std::make_shared<ExportProgress>();
+    auto progress = exportProgress;
+    std::string filename = exportFile;
+    pendingExport = std::async(std::launch::async, [snapshot, progress, filename, options, png]() {
+        return png ? snapshot->writePng(filename, options, progress.get())
+            : snapshot->writeSvg(filename, options, progress.get());
+    });
+}
+
+void GraphEditor::applyReload(const GraphFileIndex& index) {
+    size_t changed = model->reloadChanged(index);
+    if (changed == 0) {
+        return;
+    }
+    std::cout << "Reloaded " << changed << " changed graph(s) from: " << fileWatcher.getPath() << std::endl;
+
+    // Graphs are merged in place, so the view stays; only drop what no longer exists
+    if (!model->hasGraph(currentGraphName)) {
+        auto graphNames = model->getGraphNames();
+        currentGraphName = graphNames.empty() ? "" : graphNames[0];
+        currentGraph = graphNames.empty() ? nullptr : model->getGraph(currentGraphName);
+        clearSelections();
+        return;
+    }
+
+    currentGraph = model->getGraph(currentGraphName);
+    // Merges that remove nodes clear the multi-selection; keep the primary node if it is left
+    if (!selectedNodeId.empty() && !currentGraph->findNode(selectedNodeId)) {
+        selectedNodeId.clear();
+    }
+    else if (!selectedNodeId.empty() && selection.empty()) {
+        selection.update(currentGraph);
+        selection.add(currentGraph->nodeIndex[selectedNodeId]);
+    }
+    if (selectedEdge && currentGraph->findEdge(selectedEdge->from, selectedEdge->to) != selectedEdge) {
+        selectedEdge = nullptr;
+    }
+}
+
+void GraphEditor::setGraphFile(const std::string& filename, bool loaded) {
+    graphFile = filename;
+    graphFileLoaded = loaded;
+}
+
+bool GraphEditor::canSaveGraphFile() const {
+    return graphFileLoaded || !std::ifstream(graphFile).good();
+}
+
+void GraphEditor::saveFile(const std::string& filename, bool compact) {
+    if (filename == graphFile && !canSaveGraphFile()) {
+        std::cerr << "Not saving over " << filename << ": it did not load" << std::endl;
+        return;
+    }
+    if (model->saveToFile(filename, compact)) {
         std::cout << "Successfully saved graph data to: " << filename << std::endl;
+        if (filename == graphFile) {
+            graphFileLoaded = true;
+        }
+
+        // Everything is saved now, so this drops the recovery file
+        if (!recoveryFile.empty()) {
+            model->saveRecovery(recoveryFile);
+        }
     }
     else {
         std::cerr << "Failed to save graph data to: " << filename << std::endl;
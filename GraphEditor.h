@@ -1,10 +1,26 @@
 #pragma once
 
 #include "GraphModel.h"
+#include "GraphAnalysis.h"
+#include "GraphRouting.h"
+#include "CrossGraphRouter.h"
+#include "FileWatcher.h"
+#include "GraphGenerator.h"
+#include "ParallelDrawList.h"
+#include "EdgeCurveCache.h"
+#include "GraphClusters.h"
+#include "NodeSelection.h"
+#include "GraphMinimap.h"
+#include "InputRecording.h"
+#include "MachineFeed.h"
+#include "GraphExport.h"
+#include "ConflictSimulator.h"
 #include "imgui.h"
 #include <memory>
 #include <string>
 #include <functional>
+#include <future>
+#include <chrono>
 
 class GraphEditor {
 public:
@@ -14,22 +30,52 @@ public:
     void render();
     void setModel(std::shared_ptr<GraphModel> model);
 
+    // Hot-reload external changes to the given file into the live model
+    void watchFile(const std::string& filename);
+
+    // File the File menu opens and saves; the same path the model was loaded from, so a
+    // clean save is recognized and skipped. loaded tells whether that load succeeded.
+    void setGraphFile(const std::string& filename, bool loaded);
+
+    // False while the graph file exists but neither loaded nor was saved from this session,
+    // so saving would replace it with whatever the model holds
+    bool canSaveGraphFile() const;
+
+    // Periodically write unsaved graphs to a recovery file (deleted again by a full save)
+    void setAutosave(const std::string& filename, double intervalSeconds);
+
+    // Restore the view a recording started from, before replaying its input
+    void beginReplay(const InputRecording& recording);
+
+    // Show live machine positions published on the named shared-memory feed
+    void connectMachineFeed(const std::string& name);
+
 private:
     // Rendering functions
     void renderMainMenu();
     void renderGraphList();
     void renderNodeList();
     void renderEdgeList();
+    void renderAnalysisPanel();
+    void renderRoutePanel();
+    void renderTransferPanel();
     void renderGraphCanvas();
+    void renderMinimap(const ImVec2& canvasPos, const ImVec2& canvasSize);
+    void renderProfilerWindow();
+    void renderGeneratorWindow();
+    void renderExportWindow();
+    void renderSimulationWindow();
 
     // Node and edge operations
     void addNode();
-    void removeSelectedNode();
+    void removeSelectedNodes();
     void addEdge();
     void removeSelectedEdge();
 
     // Selection handling
     void selectNode(const std::string& nodeId);
+    void handleCanvasSelection(const ImVec2& canvasPos, bool isCanvasActive);
+    void finishMarquee(const ImVec2& mouseGraph);
     void selectEdge(const std::string& from, const std::string& to);
     void clearSelections();
 
@@ -38,7 +84,14 @@ private:
 
     // File operations
     void loadFile(const std::string& filename);
-    void saveFile(const std::string& filename);
+    void saveFile(const std::string& filename, bool compact = false);
+    void checkFileChanges();
+    void startExport(bool png);
+    void applyReload(const GraphFileIndex& index);
+    void autosave();
+    void toggleInputRecording();
+    void updateMachineFeed();
+    void storeMachineSample(const MachineSample& incoming, std::chrono::steady_clock::time_point received);
 
     // State variables
     std::shared_ptr<GraphModel> model;
@@ -59,15 +112,144 @@ private:
     ImVec2 canvasOffset = ImVec2(0.0f, 0.0f);
     float canvasScale = 1.0f;
     bool isDragging = false;
+    bool showProfiler = false;
+    bool showGenerator = false;
+    bool showMinimap = true;
+    bool showMachineOverlay = true;
     std::string selectedNodeId;
     std::shared_ptr<Edge> selectedEdge;
 
+    // Multi-selection by node slot; selectedNodeId is its primary node for the route and
+    // transfer panels. The drag offset is applied to the whole set at once.
+    NodeSelection selection;
+    std::vector<uint32_t> selectionSlots;
+
+    // Rectangle or lasso being drawn on the canvas, in graph space
+    enum class Marquee {
+        None,
+        Rect,
+        Lasso
+    };
+    Marquee marquee = Marquee::None;
+    bool marqueeToggles = false;    // Ctrl held: flip the enclosed nodes instead of adding them
+    ImVec2 marqueeStart;
+    std::vector<ImVec2> lassoPoints;
+
+    std::string graphFile = "WorkingGraphs.json";
+    bool graphFileLoaded = false;
+
+    // External change detection; the file is read and scanned on a worker thread
+    FileWatcher fileWatcher;
+    std::future<std::shared_ptr<GraphFileIndex>> pendingReload;
+
+    // Picture export of the current graph; the snapshot is written on a worker thread
+    std::future<bool> pendingExport;
+    std::shared_ptr<ExportProgress> exportProgress;
+    std::string exportFile;
+
+    // Recovery file autosave
+    std::string recoveryFile;
+    double autosaveInterval = 0.0;
+    std::chrono::steady_clock::time_point lastAutosave;
+
+    // Reachability/SCC analysis of the current graph
+    GraphAnalysis analysis;
+
+    // Spatial cluster hierarchy for the zoomed-out view, and the clusters drawn this frame
+    GraphClusters clusters;
+    std::vector<std::pair<uint64_t, const GraphClusters::Cluster*>> visibleClusters;
+
+    // Whole-graph overview in the canvas corner
+    GraphMinimap minimap;
+
+    // Alternative route query state
+    std::string routeFrom;
+    std::string routeTo;
+    int routeCount = 3;
+    std::vector<std::string> blockedNodes;
+    std::vector<Route> routes;
+    int selectedRoute = 0;
+
+    // Inter-graph transfer and cross-graph route state
+    CrossGraphRouter crossRouter;
+    std::string transferGraph;
+    std::string transferNode;
+    float transferCost = 0.0f;
+    int selectedTransfer = -1;
+    CrossGraphRoute crossRoute;
+
+    // Live machine positions, latest sample per graph. The node and edge slots a sample
+    // names are looked up again only when its ids or the graph topology change.
+    struct MachineState {
+        MachineSample sample;
+        std::chrono::steady_clock::time_point received;
+        MachineSample resolved;         // ids the slots below belong to
+        const Graph* resolvedGraph = nullptr;
+        uint64_t resolvedTopology = 0;
+        int64_t fromSlot = -1;
+        int64_t toSlot = -1;
+        int64_t edgeSlot = -1;
+        bool curved = false;            // drawn as a bidirectional curve
+    };
+    static const size_t MAX_MACHINES = 16;
+    MachineFeed machineFeed;
+    std::string machineFeedName;
+    MachineState machines[MAX_MACHINES];
+    size_t machineCount = 0;
+    std::chrono::steady_clock::time_point lastMachineSample;
+    std::chrono::steady_clock::time_point lastFeedAttempt;
+
+    // Per-graph memory shown in the profiler window, refreshed now and then
+    std::vector<std::pair<std::string, GraphMemoryUsage>> memoryReport;
+    std::chrono::steady_clock::time_point lastMemoryReport;
+
+    // Input capture for replay benchmarks (Debug menu)
+    bool isRecordingInput = false;
+    InputRecording inputRecording;
+
+    // Synthetic graph generator (Debug menu)
+    GeneratorOptions generatorOptions;
+    char generatorGraphName[64] = "Synthetic";
+
+    // Multi-agent route simulation and its replay on the canvas (Debug menu)
+    bool showSimulation = false;
+    ConflictSimulator simulator;
+    SimulationOptions simulationOptions;
+    SimulationResult simulation;
+    bool hasSimulation = false;
+    double replayTime = 0.0;
+    float replaySpeed = 10.0f;      // simulated seconds per second
+    bool isReplaying = false;
+    std::vector<char> agentInConflict;
+
+    // Chunked, multi-threaded canvas geometry
+    ParallelDrawList canvasBuilder;
+
+    // Tessellated bidirectional edge curves, in graph space
+    EdgeCurveCache curveCache;
+
     // Drawing helpers
-    void drawNode(ImDrawList* drawList, const std::shared_ptr<Node>& node, const ImVec2& canvasPos);
-    void drawEdge(ImDrawList* drawList, const std::shared_ptr<Edge>& edge,
-        const std::shared_ptr<Node>& fromNode,
-        const std::shared_ptr<Node>& toNode,
-        const ImVec2& canvasPos);
+    void drawNode(ImDrawList* drawList, const std::shared_ptr<Node>& node, const ImVec2& canvasPos,
+        ImU32 outlineColor, bool isSelected);
+    void drawEdge(ImDrawList* drawList, size_t slot, const Edge& edge,
+        const Node& fromNode,
+        const Node& toNode,
+        const ImVec2& canvasPos,
+        bool isSelected,
+        bool isTrap);
+    ImU32 nodeOutlineColor(size_t slot) const;
+    int clusterLevelFor(float scale) const;
+    float clusterRadius(const GraphClusters::Cluster& cluster, float cellPixels) const;
+    void drawClusters(ImDrawList* drawList, const ImVec2& canvasPos, const ImVec2& canvasSize, int level);
+    void expandClusterAt(const ImVec2& mousePos, const ImVec2& canvasPos, const ImVec2& canvasSize, int level);
+    void drawRoute(ImDrawList* drawList, const Route& route, const ImVec2& canvasPos);
+    void drawTransferMarker(ImDrawList* drawList, const std::shared_ptr<Node>& node, const ImVec2& canvasPos);
+    void drawBlockedNode(ImDrawList* drawList, const std::shared_ptr<Node>& node, const ImVec2& canvasPos);
+    void drawMachineOverlay(ImDrawList* drawList, const ImVec2& canvasPos);
+    bool resolveMachine(MachineState& machine);
+    void drawSimulationReplay(ImDrawList* drawList, const ImVec2& canvasPos);
+    ImVec2 drawEdgeProgress(ImDrawList* drawList, int64_t curveSlot, const Node& from, const Node& to,
+        float progress, const ImVec2& canvasPos, ImU32 color);
     void drawDirectedArrow(ImDrawList* drawList, const ImVec2& from, const ImVec2& to,
         ImU32 color, float thickness, float arrowSize);
 };
\ No newline at end of file
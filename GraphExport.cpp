@@ -0,0 +1,1260 @@
+#include "GraphExport.h"
+#include "GraphAnalysis.h"
+#include "EdgeCurveCache.h"
+#include "CanvasStyle.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include <imgui_internal.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+const float CURVE_TOLERANCE = 1.25f;        // ImGui's default, as on the canvas
+const int TILE_WIDTH = 256;                 // columns of a band rasterized by one thread
+const size_t PNG_CHUNK_SIZE = 1 << 16;      // compressed bytes per IDAT chunk
+const size_t FILTER_SAMPLE_STRIDE = 7;      // bytes between the samples that pick a row's filter
+const size_t DEFLATE_WINDOW = 32768;
+const size_t DEFLATE_MAX_MATCH = 258;
+const int DEFLATE_HASH_BITS = 15;
+const uint32_t PNG_MAX_SIZE = 0x7fffffff;   // width and height limit of the format
+const size_t OUTPUT_BUFFER_SIZE = 1 << 16;
+const size_t PROGRESS_INTERVAL = 4096;      // SVG elements between progress updates
+const float LABEL_REACH = 100.0f;           // pixels a label may extend sideways past its node or edge
+
+namespace {
+
+float clamp01(float value) {
+    return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+// Proggy Clean, the editor's default font, in a private atlas so export needs no ImGui context
+struct LabelFont {
+    ImFontAtlas atlas;
+    ImFont* font = nullptr;
+    unsigned char* pixels = nullptr;
+    int width = 0;
+    int height = 0;
+
+    LabelFont() {
+        font = atlas.AddFontDefault();
+        atlas.GetTexDataAsAlpha8(&pixels, &width, &height);
+    }
+};
+
+const LabelFont& labelFont() {
+    static LabelFont font;
+    return font;
+}
+
+// Same rounding as ImGui::CalcTextSize
+ImVec2 textSize(const char* begin, const char* end) {
+    const LabelFont& label = labelFont();
+    ImVec2 size = label.font->CalcTextSizeA(label.font->FontSize, FLT_MAX, 0.0f, begin, end);
+    return ImVec2(std::floor(size.x + 0.99999f), size.y);
+}
+
+int formatWeight(float weight, char* buffer, size_t size) {
+    // std::to_string's format, as on the canvas
+    return snprintf(buffer, size, "%f", weight);
+}
+
+// Horizontal extent of a convex polygon within the rows [top, bottom); false if it misses them
+bool rowSpan(const ImVec2* polygon, int count, float top, float bottom, float& left, float& right) {
+    left = FLT_MAX;
+    right = -FLT_MAX;
+    for (int i = 0, j = count - 1; i < count; j = i++) {
+        ImVec2 a = polygon[j];
+        ImVec2 b = polygon[i];
+        if (a.y > b.y) {
+            std::swap(a, b);
+        }
+        if (b.y < top || a.y > bottom) {
+            continue;
+        }
+        float dy = b.y - a.y;
+        float xTop = a.x;
+        float xBottom = b.x;
+        if (dy > 0.0f) {
+            xTop = a.x + (b.x - a.x) * (std::max(top, a.y) - a.y) / dy;
+            xBottom = a.x + (b.x - a.x) * (std::min(bottom, b.y) - a.y) / dy;
+        }
+        left = std::min(left, std::min(xTop, xBottom));
+        right = std::max(right, std::max(xTop, xBottom));
+    }
+    return left <= right;
+}
+
+void appendFloat(std::string& out, float value) {
+    char buffer[32];
+    int length = snprintf(buffer, sizeof(buffer), "%.2f", value);
+    out.append(buffer, static_cast<size_t>(length));
+}
+
+void appendPoint(std::string& out, const ImVec2& point) {
+    appendFloat(out, point.x);
+    out += ' ';
+    appendFloat(out, point.y);
+}
+
+void appendEscaped(std::string& out, const char* text, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        switch (text[i]) {
+        case '&': out += "&amp;"; break;
+        case '<': out += "&lt;"; break;
+        case '>': out += "&gt;"; break;
+        case '"': out += "&quot;"; break;
+        default: out += text[i]; break;
+        }
+    }
+}
+
+std::string svgColor(ImU32 color) {
+    char buffer[8];
+    snprintf(buffer, sizeof(buffer), "#%02x%02x%02x", (color >> IM_COL32_R_SHIFT) & 0xff,
+        (color >> IM_COL32_G_SHIFT) & 0xff, (color >> IM_COL32_B_SHIFT) & 0xff);
+    return buffer;
+}
+
+std::string svgOpacity(ImU32 color) {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%.3f", ((color >> IM_COL32_A_SHIFT) & 0xff) / 255.0f);
+    return buffer;
+}
+
+// Streaming PNG encoder for 8-bit RGB rows. Each row gets the filter with the smallest sum of
+// absolute differences; the filtered bytes are compressed as one fixed-Huffman deflate block.
+// Matches are found with a single hash probe into the last 32 KB (plus runs of the previous
+// byte), which is enough for a picture of flat background, repeated glyphs and lines.
+class PngWriter {
+public:
+    bool open(const std::string& filename, uint32_t imageWidth, uint32_t imageHeight);
+    void writeRow(const uint8_t* row);
+    bool finish();
+
+private:
+    struct Code {
+        uint16_t bits = 0;          // already bit-reversed for LSB-first output
+        uint8_t length = 0;
+    };
+
+    struct Tables {
+        uint32_t crc[256];
+        Code literal[288];
+        uint16_t lengthSymbol[259];
+        uint8_t lengthExtraBits[259];
+        uint16_t lengthExtra[259];
+        uint8_t distanceCode[512];  // by distance - 1 below 256, else 256 + ((distance - 1) >> 7)
+        uint16_t distanceBase[30];
+        uint8_t distanceExtraBits[30];
+        uint8_t distanceBits[30];   // 5-bit fixed codes, bit-reversed
+        Tables();
+    };
+    static const Tables& tables();
+
+    void putBits(uint32_t bits, int count);
+    void putMatch(size_t length, size_t distance);
+    void compress(const uint8_t* data, size_t size);
+    void writeChunk(const char* type, const uint8_t* data, size_t size);
+
+    std::ofstream file;
+    size_t rowBytes = 0;
+    std::vector<uint8_t> previous;      // unfiltered, after 3 zero bytes
+    std::vector<uint8_t> current;
+    std::vector<uint8_t> filtered;
+    std::vector<uint8_t> output;
+    uint64_t bitBuffer = 0;
+    int bitCount = 0;
+    uint32_t adlerA = 1;
+    uint32_t adlerB = 0;
+
+    // Uncompressed bytes: up to a window of history, then the row being compressed
+    std::vector<uint8_t> history;
+    uint64_t historyStart = 0;          // stream position of history[0]
+    std::vector<int64_t> hashHead;      // stream position of the last 3-byte string per hash
+};
+
+PngWriter::Tables::Tables() {
+    for (uint32_t n = 0; n < 256; ++n) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        crc[n] = c;
+    }
+
+    // Fixed Huffman code (RFC 1951 3.2.6)
+    for (int symbol = 0; symbol < 288; ++symbol) {
+        uint32_t code;
+        int length;
+        if (symbol < 144) {
+            code = 0x30 + symbol;
+            length = 8;
+        }
+        else if (symbol < 256) {
+            code = 0x190 + symbol - 144;
+            length = 9;
+        }
+        else if (symbol < 280) {
+            code = symbol - 256;
+            length = 7;
+        }
+        else {
+            code = 0xc0 + symbol - 280;
+            length = 8;
+        }
+        uint32_t reversed = 0;
+        for (int i = 0; i < length; ++i) {
+            reversed |= ((code >> i) & 1) << (length - 1 - i);
+        }
+        literal[symbol].bits = static_cast<uint16_t>(reversed);
+        literal[symbol].length = static_cast<uint8_t>(length);
+    }
+
+    static const uint16_t BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    for (int code = 0; code < 29; ++code) {
+        int end = code < 28 ? BASE[code + 1] : 259;
+        for (int length = BASE[code]; length < end; ++length) {
+            lengthSymbol[length] = static_cast<uint16_t>(257 + code);
+            lengthExtraBits[length] = EXTRA[code];
+            lengthExtra[length] = static_cast<uint16_t>(length - BASE[code]);
+        }
+    }
+
+    uint32_t base = 1;
+    for (int code = 0; code < 30; ++code) {
+        distanceBase[code] = static_cast<uint16_t>(base);
+        distanceExtraBits[code] = static_cast<uint8_t>(code < 2 ? 0 : code / 2 - 1);
+        uint32_t reversed = 0;
+        for (int i = 0; i < 5; ++i) {
+            reversed |= ((code >> i) & 1) << (4 - i);
+        }
+        distanceBits[code] = static_cast<uint8_t>(reversed);
+        for (uint32_t distance = base; distance < base + (1u << distanceExtraBits[code]); ++distance) {
+            size_t index = distance <= 256 ? distance - 1 : 256 + ((distance - 1) >> 7);
+            distanceCode[index] = static_cast<uint8_t>(code);
+        }
+        base += 1u << distanceExtraBits[code];
+    }
+}
+
+const PngWriter::Tables& PngWriter::tables() {
+    static Tables instance;
+    return instance;
+}
+
+bool PngWriter::open(const std::string& filename, uint32_t imageWidth, uint32_t imageHeight) {
+    file.open(filename, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        return false;
+    }
+    rowBytes = static_cast<size_t>(imageWidth) * 3;
+    previous.assign(rowBytes + 3, 0);
+    current.assign(rowBytes + 3, 0);
+    filtered.resize(rowBytes + 1);
+
+    static const uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    file.write(reinterpret_cast<const char*>(SIGNATURE), sizeof(SIGNATURE));
+    uint8_t header[13] = { 0 };
+    for (int i = 0; i < 4; ++i) {
+        header[i] = static_cast<uint8_t>(imageWidth >> (24 - 8 * i));
+        header[4 + i] = static_cast<uint8_t>(imageHeight >> (24 - 8 * i));
+    }
+    header[8] = 8;      // bits per sample
+    header[9] = 2;      // RGB
+    writeChunk("IHDR", header, sizeof(header));
+
+    // zlib header (deflate, 32K window), then the single final fixed-Huffman block
+    output.push_back(0x78);
+    output.push_back(0x01);
+    putBits(1, 1);
+    putBits(1, 2);
+    return true;
+}
+
+// Neighbour closest to a + b - c, written without branches so the loops vectorize
+inline int paethPredictor(int a, int b, int c) {
+    int pa = std::abs(b - c);
+    int pb = std::abs(a - c);
+    int pc = std::abs(a + b - 2 * c);
+    int bc = pb <= pc ? b : c;
+    return pa <= std::min(pb, pc) ? a : bc;
+}
+
+// Filter type byte of a row, then the filtered bytes; left and up are the unfiltered row and
+// the one above, each behind one pixel of zeros so the left neighbours need no bounds check
+template <int Filter>
+void filterRow(const uint8_t* left, const uint8_t* up, size_t size, uint8_t* out) {
+    out[0] = static_cast<uint8_t>(Filter);
+    for (size_t i = 0; i < size; ++i) {
+        int x = left[i + 3];
+        int a = left[i];
+        int b = up[i + 3];
+        int c = up[i];
+        int value = x;
+        if (Filter == 1) {
+            value = x - a;
+        }
+        else if (Filter == 2) {
+            value = x - b;
+        }
+        else if (Filter == 3) {
+            value = x - ((a + b) >> 1);
+        }
+        else if (Filter == 4) {
+            value = x - paethPredictor(a, b, c);
+        }
+        out[i + 1] = static_cast<uint8_t>(value);
+    }
+}
+
+void PngWriter::writeRow(const uint8_t* row) {
+    std::memcpy(current.data() + 3, row, rowBytes);
+    const uint8_t* left = current.data();
+    const uint8_t* up = previous.data();
+
+    // Pick the filter with the smallest sum of absolute differences over a sample of the row
+    uint64_t sums[5] = { 0, 0, 0, 0, 0 };
+    for (size_t i = 0; i < rowBytes; i += FILTER_SAMPLE_STRIDE) {
+        int x = left[i + 3];
+        int a = left[i];
+        int b = up[i + 3];
+        int c = up[i];
+        sums[0] += std::abs(static_cast<int8_t>(x));
+        sums[1] += std::abs(static_cast<int8_t>(x - a));
+        sums[2] += std::abs(static_cast<int8_t>(x - b));
+        sums[3] += std::abs(static_cast<int8_t>(x - ((a + b) >> 1)));
+        sums[4] += std::abs(static_cast<int8_t>(x - paethPredictor(a, b, c)));
+    }
+    uint8_t* out = filtered.data();
+    switch (std::min_element(sums, sums + 5) - sums) {
+    case 0: filterRow<0>(left, up, rowBytes, out); break;
+    case 1: filterRow<1>(left, up, rowBytes, out); break;
+    case 2: filterRow<2>(left, up, rowBytes, out); break;
+    case 3: filterRow<3>(left, up, rowBytes, out); break;
+    default: filterRow<4>(left, up, rowBytes, out); break;
+    }
+    previous.swap(current);
+    compress(out, rowBytes + 1);
+
+    if (output.size() >= PNG_CHUNK_SIZE) {
+        writeChunk("IDAT", output.data(), output.size());
+        output.clear();
+    }
+}
+
+bool PngWriter::finish() {
+    const Tables& table = tables();
+    putBits(table.literal[256].bits, table.literal[256].length);
+    while (bitCount > 0) {
+        output.push_back(static_cast<uint8_t>(bitBuffer));
+        bitBuffer >>= 8;
+        bitCount -= 8;
+    }
+    bitCount = 0;
+    uint32_t adler = (adlerB << 16) | adlerA;
+    for (int i = 0; i < 4; ++i) {
+        output.push_back(static_cast<uint8_t>(adler >> (24 - 8 * i)));
+    }
+    writeChunk("IDAT", output.data(), output.size());
+    output.clear();
+    writeChunk("IEND", nullptr, 0);
+    file.close();
+    return !file.fail();
+}
+
+void PngWriter::putBits(uint32_t bits, int count) {
+    bitBuffer |= static_cast<uint64_t>(bits) << bitCount;
+    bitCount += count;
+    if (bitCount >= 32) {
+        uint8_t bytes[4] = { static_cast<uint8_t>(bitBuffer), static_cast<uint8_t>(bitBuffer >> 8),
+            static_cast<uint8_t>(bitBuffer >> 16), static_cast<uint8_t>(bitBuffer >> 24) };
+        output.insert(output.end(), bytes, bytes + 4);
+        bitBuffer >>= 32;
+        bitCount -= 32;
+    }
+}
+
+void PngWriter::putMatch(size_t length, size_t distance) {
+    const Tables& table = tables();
+    const Code& code = table.literal[table.lengthSymbol[length]];
+    putBits(code.bits, code.length);
+    putBits(table.lengthExtra[length], table.lengthExtraBits[length]);
+    int distanceCode = table.distanceCode[distance <= 256 ? distance - 1 : 256 + ((distance - 1) >> 7)];
+    putBits(table.distanceBits[distanceCode], 5);
+    putBits(static_cast<uint32_t>(distance - table.distanceBase[distanceCode]), table.distanceExtraBits[distanceCode]);
+}
+
+void PngWriter::compress(const uint8_t* data, size_t size) {
+    const Tables& table = tables();
+
+    // Adler-32 of the uncompressed stream, reduced often enough not to overflow
+    for (size_t begin = 0; begin < size; begin += 5552) {
+        size_t end = std::min(size, begin + 5552);
+        for (size_t i = begin; i < end; ++i) {
+            adlerA += data[i];
+            adlerB += adlerA;
+        }
+        adlerA %= 65521;
+        adlerB %= 65521;
+    }
+
+    if (history.size() > DEFLATE_WINDOW) {
+        size_t drop = history.size() - DEFLATE_WINDOW;
+        history.erase(history.begin(), history.begin() + drop);
+        historyStart += drop;
+    }
+    if (hashHead.empty()) {
+        hashHead.assign(size_t(1) << DEFLATE_HASH_BITS, -1);
+    }
+    size_t i = history.size();
+    history.insert(history.end(), data, data + size);
+    const uint8_t* bytes = history.data();
+    size_t end = history.size();
+
+    while (i < end) {
+        size_t maxLength = std::min<size_t>(DEFLATE_MAX_MATCH, end - i);
+        size_t length = 0;
+        size_t distance = 0;
+        if (maxLength >= 3) {
+            // Run of the previous byte
+            if (i > 0) {
+                while (length < maxLength && bytes[i + length] == bytes[i - 1]) {
+                    ++length;
+                }
+                distance = 1;
+            }
+            // Last occurrence of the next three bytes
+            uint32_t key = (static_cast<uint32_t>(bytes[i]) << 16) | (bytes[i + 1] << 8) | bytes[i + 2];
+            uint32_t hash = (key * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+            int64_t candidate = hashHead[hash] - static_cast<int64_t>(historyStart);
+            hashHead[hash] = static_cast<int64_t>(historyStart + i);
+            if (candidate >= 0 && i - static_cast<size_t>(candidate) <= DEFLATE_WINDOW && length < maxLength) {
+                size_t match = 0;
+                while (match < maxLength && bytes[candidate + match] == bytes[i + match]) {
+                    ++match;
+                }
+                if (match > length) {
+                    length = match;
+                    distance = i - static_cast<size_t>(candidate);
+                }
+            }
+        }
+        if (length >= 3) {
+            putMatch(length, distance);
+            i += length;
+            continue;
+        }
+        const Code& code = table.literal[bytes[i]];
+        putBits(code.bits, code.length);
+        ++i;
+    }
+}
+
+void PngWriter::writeChunk(const char* type, const uint8_t* data, size_t size) {
+    const Tables& table = tables();
+    uint8_t length[4];
+    for (int i = 0; i < 4; ++i) {
+        length[i] = static_cast<uint8_t>(size >> (24 - 8 * i));
+    }
+    uint32_t crc = 0xffffffffu;
+    for (int i = 0; i < 4; ++i) {
+        crc = table.crc[(crc ^ static_cast<uint8_t>(type[i])) & 0xff] ^ (crc >> 8);
+    }
+    for (size_t i = 0; i < size; ++i) {
+        crc = table.crc[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    crc ^= 0xffffffffu;
+    uint8_t crcBytes[4];
+    for (int i = 0; i < 4; ++i) {
+        crcBytes[i] = static_cast<uint8_t>(crc >> (24 - 8 * i));
+    }
+    file.write(reinterpret_cast<const char*>(length), 4);
+    file.write(type, 4);
+    file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    file.write(reinterpret_cast<const char*>(crcBytes), 4);
+}
+
+// Items (edges or nodes) grouped by the first band they touch, with the last band of each
+struct BandBuckets {
+    std::vector<uint32_t> start;    // items of band b: order[start[b], start[b + 1])
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> last;
+
+    // rows(i, top, bottom): pixel rows item i may touch
+    template <typename Rows>
+    void build(size_t itemCount, size_t bandCount, size_t bandRows, size_t height, Rows rows) {
+        const uint32_t NONE = UINT32_MAX;
+        std::vector<uint32_t> first(itemCount, NONE);
+        last.assign(itemCount, 0);
+        start.assign(bandCount + 1, 0);
+        for (size_t i = 0; i < itemCount; ++i) {
+            float top, bottom;
+            rows(i, top, bottom);
+            if (bottom < 0.0f || top >= static_cast<float>(height)) {
+                continue;
+            }
+            first[i] = static_cast<uint32_t>(static_cast<size_t>(std::max(top, 0.0f)) / bandRows);
+            last[i] = static_cast<uint32_t>(std::min(static_cast<size_t>(bottom), height - 1) / bandRows);
+            ++start[first[i] + 1];
+        }
+        for (size_t b = 0; b < bandCount; ++b) {
+            start[b + 1] += start[b];
+        }
+        order.resize(start[bandCount]);
+        std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+        for (size_t i = 0; i < itemCount; ++i) {
+            if (first[i] != NONE) {
+                order[fill[first[i]]++] = static_cast<uint32_t>(i);
+            }
+        }
+    }
+
+    // Add the items starting in the band to the active list, keeping it in draw order
+    void enter(size_t band, std::vector<uint32_t>& active, std::vector<uint32_t>& scratch) const {
+        scratch.clear();
+        std::merge(active.begin(), active.end(), order.begin() + start[band], order.begin() + start[band + 1],
+            std::back_inserter(scratch));
+        active.swap(scratch);
+    }
+
+    void leave(size_t band, std::vector<uint32_t>& active) const {
+        active.erase(std::remove_if(active.begin(), active.end(),
+            [&](uint32_t i) { return last[i] <= band; }), active.end());
+    }
+};
+
+} // namespace
+
+// Rows [top, bottom) of the picture held in memory, and the columns [left, right) one
+// thread draws into. Coverage is computed per pixel centre, with half a pixel of
+// anti-aliasing like ImGui's.
+struct GraphExport::Band {
+    uint8_t* pixels = nullptr;
+    size_t stride = 0;
+    int top = 0;
+    int bottom = 0;
+    int left = 0;
+    int right = 0;
+
+    // A colour split into channels once per primitive
+    struct Paint {
+        int r, g, b;
+        float alpha;
+
+        explicit Paint(ImU32 color)
+            : r((color >> IM_COL32_R_SHIFT) & 0xff), g((color >> IM_COL32_G_SHIFT) & 0xff),
+            b((color >> IM_COL32_B_SHIFT) & 0xff), alpha(static_cast<float>((color >> IM_COL32_A_SHIFT) & 0xff)) {}
+    };
+
+    void blend(int x, int y, const Paint& paint, float coverage) {
+        int alpha = static_cast<int>(paint.alpha * coverage + 0.5f);
+        if (alpha <= 0) {
+            return;
+        }
+        uint8_t* pixel = pixels + static_cast<size_t>(y - top) * stride + static_cast<size_t>(x) * 3;
+        if (alpha >= 255) {
+            pixel[0] = static_cast<uint8_t>(paint.r);
+            pixel[1] = static_cast<uint8_t>(paint.g);
+            pixel[2] = static_cast<uint8_t>(paint.b);
+            return;
+        }
+        pixel[0] = static_cast<uint8_t>((pixel[0] * (255 - alpha) + paint.r * alpha + 127) / 255);
+        pixel[1] = static_cast<uint8_t>((pixel[1] * (255 - alpha) + paint.g * alpha + 127) / 255);
+        pixel[2] = static_cast<uint8_t>((pixel[2] * (255 - alpha) + paint.b * alpha + 127) / 255);
+    }
+
+    // Rows and columns of the band within [minX, maxX] x [minY, maxY]
+    bool clip(float minX, float minY, float maxX, float maxY, int& x0, int& y0, int& x1, int& y1) const {
+        x0 = std::max(left, static_cast<int>(std::floor(minX)));
+        y0 = std::max(top, static_cast<int>(std::floor(minY)));
+        x1 = std::min(right, static_cast<int>(std::ceil(maxX)) + 1);
+        y1 = std::min(bottom, static_cast<int>(std::ceil(maxY)) + 1);
+        return x0 < x1 && y0 < y1;
+    }
+
+    void fillCircle(const ImVec2& center, float radius, ImU32 color) {
+        ring(center, radius + 0.5f, -1.0f, color, [&](float d) { return clamp01(radius + 0.5f - d); });
+    }
+
+    void strokeCircle(const ImVec2& center, float radius, float thickness, ImU32 color) {
+        float half = thickness * 0.5f;
+        ring(center, radius + half + 0.5f, radius - half - 0.5f, color,
+            [&](float d) { return clamp01(half + 0.5f - std::fabs(d - radius)); });
+    }
+
+    // Pixels between two radii around a centre (inner < 0: the whole disc), by distance
+    template <typename Coverage>
+    void ring(const ImVec2& center, float outer, float inner, ImU32 color, Coverage coverage) {
+        Paint paint(color);
+        int x0, y0, x1, y1;
+        if (!clip(center.x - outer, center.y - outer, center.x + outer, center.y + outer, x0, y0, x1, y1)) {
+            return;
+        }
+        for (int y = y0; y < y1; ++y) {
+            float dy = y + 0.5f - center.y;
+            float outerSpan = outer * outer - dy * dy;
+            if (outerSpan <= 0.0f) {
+                continue;
+            }
+            outerSpan = std::sqrt(outerSpan);
+            float innerSpan = inner > 0.0f && inner * inner > dy * dy ? std::sqrt(inner * inner - dy * dy) : -1.0f;
+            int from = std::max(x0, static_cast<int>(std::floor(center.x - outerSpan)));
+            int to = std::min(x1, static_cast<int>(std::ceil(center.x + outerSpan)) + 1);
+            for (int x = from; x < to; ++x) {
+                float dx = x + 0.5f - center.x;
+                if (std::fabs(dx) < innerSpan) {
+                    x = std::max(x, static_cast<int>(center.x + innerSpan) - 1);
+                    continue;
+                }
+                float c = coverage(std::sqrt(dx * dx + dy * dy));
+                if (c > 0.0f) {
+                    blend(x, y, paint, c);
+                }
+            }
+        }
+    }
+
+    // Thick line; butt ends like ImGui's AddLine, or round ones to join polyline segments
+    void strokeSegment(const ImVec2& a, const ImVec2& b, float thickness, ImU32 color, bool roundEnds) {
+        float dx = b.x - a.x;
+        float dy = b.y - a.y;
+        float length = std::sqrt(dx * dx + dy * dy);
+        if (length <= 0.0f) {
+            return;
+        }
+        float ux = dx / length;
+        float uy = dy / length;
+        float half = thickness * 0.5f;
+        float reach = half + 0.5f;
+        float cap = roundEnds ? reach : 0.5f;
+        Paint paint(color);
+        ImVec2 quad[4] = {
+            ImVec2(a.x - ux * cap - uy * reach, a.y - uy * cap + ux * reach),
+            ImVec2(b.x + ux * cap - uy * reach, b.y + uy * cap + ux * reach),
+            ImVec2(b.x + ux * cap + uy * reach, b.y + uy * cap - ux * reach),
+            ImVec2(a.x - ux * cap + uy * reach, a.y - uy * cap - ux * reach)
+        };
+        int x0, y0, x1, y1;
+        if (!clip(std::min(a.x, b.x) - reach, std::min(a.y, b.y) - reach, std::max(a.x, b.x) + reach,
+            std::max(a.y, b.y) + reach, x0, y0, x1, y1)) {
+            return;
+        }
+        for (int y = y0; y < y1; ++y) {
+            float spanLeft, spanRight;
+            if (!rowSpan(quad, 4, static_cast<float>(y), static_cast<float>(y + 1), spanLeft, spanRight)) {
+                continue;
+            }
+            int from = std::max(x0, static_cast<int>(std::floor(spanLeft)));
+            int to = std::min(x1, static_cast<int>(std::ceil(spanRight)) + 1);
+            float py = y + 0.5f - a.y;
+            for (int x = from; x < to; ++x) {
+                float px = x + 0.5f - a.x;
+                float along = px * ux + py * uy;
+                float across = std::fabs(px * uy - py * ux);
+                float c;
+                if (roundEnds) {
+                    float t = std::max(0.0f, std::min(length, along));
+                    float ex = px - ux * t;
+                    float ey = py - uy * t;
+                    c = clamp01(reach - std::sqrt(ex * ex + ey * ey));
+                }
+                else {
+                    c = clamp01(reach - across) * clamp01(along + 0.5f) * clamp01(length - along + 0.5f);
+                }
+                if (c > 0.0f) {
+                    blend(x, y, paint, c);
+                }
+            }
+        }
+    }
+
+    void fillTriangle(const ImVec2* points, ImU32 color) {
+        Paint paint(color);
+        ImVec2 p[3] = { points[0], points[1], points[2] };
+        float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+        if (area == 0.0f) {
+            return;
+        }
+        if (area < 0.0f) {
+            std::swap(p[1], p[2]);
+        }
+        // Inward unit normals of the three sides
+        float nx[3], ny[3];
+        for (int i = 0; i < 3; ++i) {
+            const ImVec2& s = p[i];
+            const ImVec2& e = p[(i + 1) % 3];
+            float length = std::sqrt((e.x - s.x) * (e.x - s.x) + (e.y - s.y) * (e.y - s.y));
+            nx[i] = -(e.y - s.y) / length;
+            ny[i] = (e.x - s.x) / length;
+        }
+        int x0, y0, x1, y1;
+        if (!clip(std::min(p[0].x, std::min(p[1].x, p[2].x)) - 1.0f, std::min(p[0].y, std::min(p[1].y, p[2].y)) - 1.0f,
+            std::max(p[0].x, std::max(p[1].x, p[2].x)) + 1.0f, std::max(p[0].y, std::max(p[1].y, p[2].y)) + 1.0f,
+            x0, y0, x1, y1)) {
+            return;
+        }
+        for (int y = y0; y < y1; ++y) {
+            for (int x = x0; x < x1; ++x) {
+                float inside = FLT_MAX;
+                for (int i = 0; i < 3; ++i) {
+                    inside = std::min(inside, (x + 0.5f - p[i].x) * nx[i] + (y + 0.5f - p[i].y) * ny[i]);
+                }
+                float c = clamp01(inside + 0.5f);
+                if (c > 0.0f) {
+                    blend(x, y, paint, c);
+                }
+            }
+        }
+    }
+
+    // Unrounded rectangle, covering pixels by area like ImGui's AddRectFilled
+    void fillRect(const ImVec2& min, const ImVec2& max, ImU32 color) {
+        Paint paint(color);
+        int x0, y0, x1, y1;
+        if (!clip(min.x, min.y, max.x, max.y, x0, y0, x1, y1)) {
+            return;
+        }
+        for (int y = y0; y < y1; ++y) {
+            float cy = clamp01(std::min(max.y, y + 1.0f) - std::max(min.y, static_cast<float>(y)));
+            for (int x = x0; x < x1; ++x) {
+                float cx = clamp01(std::min(max.x, x + 1.0f) - std::max(min.x, static_cast<float>(x)));
+                if (cx * cy > 0.0f) {
+                    blend(x, y, paint, cx * cy);
+                }
+            }
+        }
+    }
+
+    // Glyphs copied from the font atlas at whole pixels, as ImGui's AddText places them
+    void drawText(const ImVec2& position, const char* begin, const char* end, ImU32 color) {
+        const LabelFont& label = labelFont();
+        Paint paint(color);
+        float x = static_cast<float>(static_cast<int>(position.x));
+        float y = static_cast<float>(static_cast<int>(position.y));
+        if (y >= bottom || y + label.font->FontSize <= top || x >= right) {
+            return;
+        }
+        const char* text = begin;
+        while (text < end) {
+            unsigned int c = static_cast<unsigned char>(*text);
+            if (c < 0x80) {
+                ++text;
+            }
+            else {
+                text += ImTextCharFromUtf8(&c, text, end);
+            }
+            if (c == 0) {
+                break;
+            }
+            const ImFontGlyph* glyph = label.font->FindGlyph(static_cast<ImWchar>(c));
+            if (!glyph) {
+                continue;
+            }
+            if (glyph->Visible) {
+                int gx0 = static_cast<int>(x + glyph->X0);
+                int gy0 = static_cast<int>(y + glyph->Y0);
+                int u0 = static_cast<int>(glyph->U0 * label.width + 0.5f);
+                int v0 = static_cast<int>(glyph->V0 * label.height + 0.5f);
+                int glyphWidth = static_cast<int>(glyph->X1 - glyph->X0);
+                int glyphHeight = static_cast<int>(glyph->Y1 - glyph->Y0);
+                for (int gy = std::max(0, top - gy0); gy < glyphHeight && gy0 + gy < bottom; ++gy) {
+                    const unsigned char* source = label.pixels + static_cast<size_t>(v0 + gy) * label.width + u0;
+                    for (int gx = std::max(0, left - gx0); gx < glyphWidth && gx0 + gx < right; ++gx) {
+                        if (source[gx]) {
+                            blend(gx0 + gx, gy0 + gy, paint, source[gx] / 255.0f);
+                        }
+                    }
+                }
+            }
+            x += glyph->AdvanceX;
+        }
+    }
+};
+
+void GraphExport::capture(Graph& graph, const GraphAnalysis* analysis) {
+    PROFILE_SCOPE("GraphExport::capture");
+    graph.updateGeometryIndex();
+    size_t nodeCount = graph.nodes.size();
+    size_t edgeCount = graph.edges.size();
+
+    nodeX.resize(nodeCount);
+    nodeY.resize(nodeCount);
+    nodeStatus.assign(nodeCount, Normal);
+    idText.clear();
+    idEnd.resize(nodeCount);
+    idHalfWidth.resize(nodeCount);
+    minX = minY = FLT_MAX;
+    maxX = maxY = -FLT_MAX;
+    for (size_t i = 0; i < nodeCount; ++i) {
+        const Node& node = *graph.nodes[i];
+        nodeX[i] = node.x;
+        nodeY[i] = node.y;
+        idText += node.id;
+        idEnd[i] = idText.size();
+        idHalfWidth[i] = textSize(node.id.data(), node.id.data() + node.id.size()).x * 0.5f;
+        if (analysis && analysis->isDeadEnd(i)) {
+            nodeStatus[i] = DeadEnd;
+        }
+        else if (analysis && analysis->isUnreachable(i)) {
+            nodeStatus[i] = Unreachable;
+        }
+        minX = std::min(minX, node.x - NODE_RADIUS);
+        minY = std::min(minY, node.y - NODE_RADIUS);
+        maxX = std::max(maxX, node.x + NODE_RADIUS);
+        maxY = std::max(maxY, node.y + NODE_RADIUS);
+    }
+    if (nodeCount == 0) {
+        minX = minY = maxX = maxY = 0.0f;
+    }
+
+    edgeFrom.assign(graph.edgeFromSlot.begin(), graph.edgeFromSlot.end());
+    edgeTo.assign(graph.edgeToSlot.begin(), graph.edgeToSlot.end());
+    edgeWeight.resize(edgeCount);
+    edgeFlags.assign(edgeCount, 0);
+    for (size_t i = 0; i < edgeCount; ++i) {
+        edgeWeight[i] = graph.edges[i]->weight;
+        if (analysis && analysis->isTrapEdge(i)) {
+            edgeFlags[i] |= Trap;
+        }
+        // Curved when the reverse edge exists; it is incident to the target node
+        uint32_t from = edgeFrom[i];
+        uint32_t to = edgeTo[i];
+        for (uint32_t other : graph.incidentEdges[to]) {
+            if (edgeFrom[other] == to && edgeTo[other] == from) {
+                edgeFlags[i] |= Curved;
+                break;
+            }
+        }
+        if (edgeFlags[i] & Curved) {
+            // The curve stays within the hull of its control points
+            ImVec2 control[4];
+            EdgeCurveCache::shape(nodeX[from], nodeY[from], nodeX[to], nodeY[to], NODE_RADIUS, CURVE_BULGE, control);
+            for (int k = 1; k < 3; ++k) {
+                minX = std::min(minX, control[k].x);
+                minY = std::min(minY, control[k].y);
+                maxX = std::max(maxX, control[k].x);
+                maxY = std::max(maxY, control[k].y);
+            }
+        }
+    }
+}
+
+GraphExport::Layout GraphExport::layoutFor(const ExportOptions& options) const {
+    Layout layout;
+    float scale = options.scale;
+    layout.scale = scale;
+    float left = minX * scale;
+    float right = maxX * scale;
+    float top = minY * scale;
+    float bottom = maxY * scale;
+
+    // Ids do not scale, so on small nodes they stick out of the disc
+    if (options.labels) {
+        float radius = NODE_RADIUS * scale;
+        for (size_t i = 0; i < nodeX.size(); ++i) {
+            if (idHalfWidth[i] > radius) {
+                left = std::min(left, nodeX[i] * scale - idHalfWidth[i]);
+                right = std::max(right, nodeX[i] * scale + idHalfWidth[i]);
+            }
+        }
+        float overhang = std::max(0.0f, labelFont().font->FontSize * 0.5f - radius);
+        top -= overhang;
+        bottom += overhang;
+    }
+
+    // Outlines are centred on the node boundary and do not scale either
+    float border = options.margin + STATUS_OUTLINE_THICKNESS;
+    layout.offsetX = border - left;
+    layout.offsetY = border - top;
+    double width = std::ceil(static_cast<double>(right) - left + 2.0 * border);
+    double height = std::ceil(static_cast<double>(bottom) - top + 2.0 * border);
+    layout.width = static_cast<uint32_t>(std::min<double>(std::max(width, 1.0), UINT32_MAX));
+    layout.height = static_cast<uint32_t>(std::min<double>(std::max(height, 1.0), UINT32_MAX));
+    return layout;
+}
+
+bool GraphExport::getImageSize(const ExportOptions& options, uint32_t& width, uint32_t& height) const {
+    Layout layout = layoutFor(options);
+    width = layout.width;
+    height = layout.height;
+    return options.scale > 0.0f && width <= PNG_MAX_SIZE && height <= PNG_MAX_SIZE;
+}
+
+ImU32 GraphExport::outlineColor(size_t slot) const {
+    switch (nodeStatus[slot]) {
+    case DeadEnd: return DEAD_END_COLOR;
+    case Unreachable: return UNREACHABLE_COLOR;
+    default: return NODE_OUTLINE_COLOR;
+    }
+}
+
+const char* GraphExport::nodeId(size_t slot, size_t& length) const {
+    size_t begin = slot > 0 ? idEnd[slot - 1] : 0;
+    length = idEnd[slot] - begin;
+    return idText.data() + begin;
+}
+
+void GraphExport::shapeEdge(size_t slot, const Layout& layout, EdgeShape& shape) const {
+    uint32_t from = edgeFrom[slot];
+    uint32_t to = edgeTo[slot];
+    ImVec2 fromPos = layout.toPixels(nodeX[from], nodeY[from]);
+    ImVec2 toPos = layout.toPixels(nodeX[to], nodeY[to]);
+    float radius = NODE_RADIUS * layout.scale;
+    float arrowSize = ARROW_SIZE * layout.scale;
+
+    // Same construction as GraphEditor::drawEdge
+    float angle = std::atan2(toPos.y - fromPos.y, toPos.x - fromPos.x);
+    ImVec2 fromAdjusted(fromPos.x + std::cos(angle) * radius, fromPos.y + std::sin(angle) * radius);
+    ImVec2 toAdjusted(toPos.x - std::cos(angle) * radius, toPos.y - std::sin(angle) * radius);
+    shape.labelCenter = ImVec2((fromAdjusted.x + toAdjusted.x) * 0.5f, (fromAdjusted.y + toAdjusted.y) * 0.5f);
+    shape.color = (edgeFlags[slot] & Trap) ? DEAD_END_COLOR : EDGE_COLOR;
+    shape.curved = (edgeFlags[slot] & Curved) != 0;
+    shape.points.clear();
+    shape.hasArrow = false;
+
+    ImVec2 tip = toAdjusted;
+    if (shape.curved) {
+        float flatness = EdgeCurveCache::shape(nodeX[from], nodeY[from], nodeX[to], nodeY[to], NODE_RADIUS,
+            CURVE_BULGE, shape.control);
+        if (flatness <= 0.0f) {
+            return;
+        }
+        for (auto& point : shape.control) {
+            point = layout.toPixels(point.x, point.y);
+        }
+        EdgeCurveCache::tessellate(shape.control,
+            EdgeCurveCache::segmentsFor(flatness, layout.scale, CURVE_TOLERANCE), shape.points);
+        tip = shape.points[shape.points.size() - 1];
+        const ImVec2& before = shape.points[shape.points.size() - 2];
+        angle = std::atan2(tip.y - before.y, tip.x - before.x);
+    }
+    else {
+        shape.points.push_back(fromAdjusted);
+        shape.points.push_back(toAdjusted);
+    }
+    shape.arrow[0] = tip;
+    shape.arrow[1] = ImVec2(tip.x - arrowSize * std::cos(angle - ARROW_ANGLE), tip.y - arrowSize * std::sin(angle - ARROW_ANGLE));
+    shape.arrow[2] = ImVec2(tip.x - arrowSize * std::cos(angle + ARROW_ANGLE), tip.y - arrowSize * std::sin(angle + ARROW_ANGLE));
+    shape.hasArrow = true;
+}
+
+void GraphExport::drawEdge(Band& band, size_t slot, const Layout& layout, const ExportOptions& options,
+    EdgeShape& shape) const {
+    shapeEdge(slot, layout, shape);
+    float thickness = EDGE_THICKNESS * layout.scale;
+    for (size_t i = 1; i < shape.points.size(); ++i) {
+        band.strokeSegment(shape.points[i - 1], shape.points[i], thickness, shape.color, shape.curved);
+    }
+    if (shape.hasArrow) {
+        band.fillTriangle(shape.arrow, shape.color);
+    }
+
+    if (options.labels) {
+        char text[64];
+        int length = formatWeight(edgeWeight[slot], text, sizeof(text));
+        ImVec2 size = textSize(text, text + length);
+        ImVec2 corner(shape.labelCenter.x - size.x * 0.5f, shape.labelCenter.y - size.y * 0.5f);
+        band.fillRect(ImVec2(corner.x - LABEL_PADDING, corner.y - LABEL_PADDING),
+            ImVec2(corner.x + size.x + LABEL_PADDING, corner.y + size.y + LABEL_PADDING), LABEL_BG_COLOR);
+        band.drawText(corner, text, text + length, LABEL_COLOR);
+    }
+}
+
+void GraphExport::drawNode(Band& band, size_t slot, const Layout& layout, const ExportOptions& options) const {
+    ImVec2 center = layout.toPixels(nodeX[slot], nodeY[slot]);
+    float radius = NODE_RADIUS * layout.scale;
+    band.fillCircle(center, radius, NODE_COLOR);
+    band.strokeCircle(center, radius, nodeStatus[slot] == Normal ? NODE_OUTLINE_THICKNESS : STATUS_OUTLINE_THICKNESS,
+        outlineColor(slot));
+
+    if (options.labels) {
+        size_t length;
+        const char* id = nodeId(slot, length);
+        ImVec2 size = textSize(id, id + length);
+        band.drawText(ImVec2(center.x - size.x * 0.5f, center.y - size.y * 0.5f), id, id + length, LABEL_COLOR);
+    }
+}
+
+bool GraphExport::writeSvg(const std::string& filename, const ExportOptions& options, ExportProgress* progress) const {
+    PROFILE_SCOPE("GraphExport::writeSvg");
+    Layout layout = layoutFor(options);
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        return false;
+    }
+
+    std::string out;
+    out.reserve(OUTPUT_BUFFER_SIZE * 2);
+    auto number = [](float value) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%g", value);
+        return std::string(buffer);
+    };
+    std::string thickness = number(EDGE_THICKNESS * layout.scale);
+    out += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    out += "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" + std::to_string(layout.width) + "\" height=\"" +
+        std::to_string(layout.height) + "\" viewBox=\"0 0 " + std::to_string(layout.width) + " " +
+        std::to_string(layout.height) + "\">\n";
+    out += "<style>\n";
+    out += ".e{fill:none;stroke:" + svgColor(EDGE_COLOR) + ";stroke-width:" + thickness + "}\n";
+    out += ".a{fill:" + svgColor(EDGE_COLOR) + "}\n";
+    out += ".e.t{stroke:" + svgColor(DEAD_END_COLOR) + "}\n";
+    out += ".a.t{fill:" + svgColor(DEAD_END_COLOR) + "}\n";
+    out += ".w{fill:" + svgColor(LABEL_BG_COLOR) + ";fill-opacity:" + svgOpacity(LABEL_BG_COLOR) + "}\n";
+    out += ".n{fill:" + svgColor(NODE_COLOR) + ";stroke:" + svgColor(NODE_OUTLINE_COLOR) + ";stroke-opacity:" +
+        svgOpacity(NODE_OUTLINE_COLOR) + ";stroke-width:" + number(NODE_OUTLINE_THICKNESS) + "}\n";
+    out += ".n.u{stroke:" + svgColor(UNREACHABLE_COLOR) + ";stroke-opacity:" + svgOpacity(UNREACHABLE_COLOR) +
+        ";stroke-width:" + number(STATUS_OUTLINE_THICKNESS) + "}\n";
+    out += ".n.d{stroke:" + svgColor(DEAD_END_COLOR) + ";stroke-opacity:" + svgOpacity(DEAD_END_COLOR) +
+        ";stroke-width:" + number(STATUS_OUTLINE_THICKNESS) + "}\n";
+    out += "text{font-family:monospace;font-size:13px;fill:" + svgColor(LABEL_COLOR) +
+        ";text-anchor:middle;dominant-baseline:central}\n";
+    out += "</style>\n";
+    out += "<rect width=\"100%\" height=\"100%\" fill=\"" + svgColor(CANVAS_BG_COLOR) + "\"/>\n";
+
+    size_t total = edgeFrom.size() + nodeX.size();
+    size_t done = 0;
+    auto step = [&]() {
+        if (out.size() >= OUTPUT_BUFFER_SIZE) {
+            file.write(out.data(), static_cast<std::streamsize>(out.size()));
+            out.clear();
+        }
+        if (++done % PROGRESS_INTERVAL == 0 && progress) {
+            progress->fraction = static_cast<float>(done) / total;
+            return !progress->cancel;
+        }
+        return true;
+    };
+
+    // Edges first, then nodes on top, as on the canvas
+    EdgeShape shape;
+    bool cancelled = false;
+    for (size_t i = 0; i < edgeFrom.size() && !cancelled; ++i) {
+        shapeEdge(i, layout, shape);
+        const char* trap = (edgeFlags[i] & Trap) ? " t" : "";
+        if (shape.curved && shape.hasArrow) {
+            out += "<path class=\"e";
+            out += trap;
+            out += "\" d=\"M";
+            appendPoint(out, shape.control[0]);
+            out += " C";
+            for (int k = 1; k < 4; ++k) {
+                appendPoint(out, shape.control[k]);
+                out += k < 3 ? " " : "\"/>\n";
+            }
+        }
+        else if (!shape.curved) {
+            out += "<path class=\"e";
+            out += trap;
+            out += "\" d=\"M";
+            appendPoint(out, shape.points[0]);
+            out += " L";
+            appendPoint(out, shape.points[1]);
+            out += "\"/>\n";
+        }
+        if (shape.hasArrow) {
+            out += "<path class=\"a";
+            out += trap;
+            out += "\" d=\"M";
+            appendPoint(out, shape.arrow[0]);
+            out += " L";
+            appendPoint(out, shape.arrow[1]);
+            out += " L";
+            appendPoint(out, shape.arrow[2]);
+            out += "Z\"/>\n";
+        }
+        if (options.labels) {
+            char text[64];
+            int length = formatWeight(edgeWeight[i], text, sizeof(text));
+            ImVec2 size = textSize(text, text + length);
+            out += "<rect class=\"w\" x=\"";
+            appendFloat(out, shape.labelCenter.x - size.x * 0.5f - LABEL_PADDING);
+            out += "\" y=\"";
+            appendFloat(out, shape.labelCenter.y - size.y * 0.5f - LABEL_PADDING);
+            out += "\" width=\"";
+            appendFloat(out, size.x + 2.0f * LABEL_PADDING);
+            out += "\" height=\"";
+            appendFloat(out, size.y + 2.0f * LABEL_PADDING);
+            out += "\"/>\n<text x=\"";
+            appendFloat(out, shape.labelCenter.x);
+            out += "\" y=\"";
+            appendFloat(out, shape.labelCenter.y);
+            out += "\">";
+            out.append(text, static_cast<size_t>(length));
+            out += "</text>\n";
+        }
+        cancelled = !step();
+    }
+
+    static const char* const NODE_CLASS[] = { "n", "n u", "n d" };
+    for (size_t i = 0; i < nodeX.size() && !cancelled; ++i) {
+        ImVec2 center = layout.toPixels(nodeX[i], nodeY[i]);
+        out += "<circle class=\"";
+        out += NODE_CLASS[nodeStatus[i]];
+        out += "\" cx=\"";
+        appendFloat(out, center.x);
+        out += "\" cy=\"";
+        appendFloat(out, center.y);
+        out += "\" r=\"";
+        appendFloat(out, NODE_RADIUS * layout.scale);
+        out += "\"/>\n";
+        if (options.labels) {
+            size_t length;
+            const char* id = nodeId(i, length);
+            out += "<text x=\"";
+            appendFloat(out, center.x);
+            out += "\" y=\"";
+            appendFloat(out, center.y);
+            out += "\">";
+            appendEscaped(out, id, length);
+            out += "</text>\n";
+        }
+        cancelled = !step();
+    }
+    out += "</svg>\n";
+    file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    file.close();
+
+    if (cancelled || file.fail()) {
+        if (!cancelled) {
+            std::cerr << "Failed to write SVG file: " << filename << std::endl;
+        }
+        std::remove(filename.c_str());
+        return false;
+    }
+    if (progress) {
+        progress->fraction = 1.0f;
+    }
+    return true;
+}
+
+bool GraphExport::writePng(const std::string& filename, const ExportOptions& options, ExportProgress* progress) const {
+    PROFILE_SCOPE("GraphExport::writePng");
+    Layout layout = layoutFor(options);
+    uint32_t width, height;
+    if (!getImageSize(options, width, height)) {
+        std::cerr << "Image too large for PNG: " << layout.width << " x " << layout.height << std::endl;
+        return false;
+    }
+
+    // Whole rows per band, as many as the budget allows
+    size_t stride = static_cast<size_t>(width) * 3;
+    size_t bandRows = std::max<size_t>(1, std::min<size_t>(height, options.memoryBudget / stride));
+    size_t bandCount = (height + bandRows - 1) / bandRows;
+    std::vector<uint8_t> pixels(bandRows * stride);
+
+    // Rows each edge and node may touch: the geometry's extent plus label boxes
+    float scale = layout.scale;
+    float labelReach = labelFont().font->FontSize * 0.5f + LABEL_PADDING + 1.0f;
+    float nodeReach = std::max(NODE_RADIUS * scale + STATUS_OUTLINE_THICKNESS * 0.5f, labelReach) + 1.0f;
+    float straightReach = (NODE_RADIUS + ARROW_SIZE + EDGE_THICKNESS) * scale + labelReach + 1.0f;
+    float curvedReach = straightReach + CURVE_BULGE * scale;
+    auto edgeReach = [&](size_t i) { return (edgeFlags[i] & Curved) ? curvedReach : straightReach; };
+
+    BandBuckets edgeBuckets;
+    edgeBuckets.build(edgeFrom.size(), bandCount, bandRows, height, [&](size_t i, float& top, float& bottom) {
+        float a = nodeY[edgeFrom[i]] * scale + layout.offsetY;
+        float b = nodeY[edgeTo[i]] * scale + layout.offsetY;
+        top = std::min(a, b) - edgeReach(i);
+        bottom = std::max(a, b) + edgeReach(i);
+    });
+    BandBuckets nodeBuckets;
+    nodeBuckets.build(nodeX.size(), bandCount, bandRows, height, [&](size_t i, float& top, float& bottom) {
+        float y = nodeY[i] * scale + layout.offsetY;
+        top = y - nodeReach;
+        bottom = y + nodeReach;
+    });
+
+    PngWriter png;
+    if (!png.open(filename, width, height)) {
+        return false;
+    }
+
+    std::vector<uint32_t> activeEdges;
+    std::vector<uint32_t> activeNodes;
+    std::vector<uint32_t> scratch;
+    size_t tileCount = (width + TILE_WIDTH - 1) / TILE_WIDTH;
+    bool cancelled = false;
+    for (size_t b = 0; b < bandCount && !cancelled; ++b) {
+        int top = static_cast<int>(b * bandRows);
+        int bottom = static_cast<int>(std::min<size_t>(height, top + bandRows));
+        edgeBuckets.enter(b, activeEdges, scratch);
+        nodeBuckets.enter(b, activeNodes, scratch);
+
+        // Background, then edges and nodes in canvas order, one column tile per thread
+        for (int y = top; y < bottom; ++y) {
+            uint8_t* row = pixels.data() + static_cast<size_t>(y - top) * stride;
+            for (uint32_t x = 0; x < width; ++x) {
+                row[x * 3] = (CANVAS_BG_COLOR >> IM_COL32_R_SHIFT) & 0xff;
+                row[x * 3 + 1] = (CANVAS_BG_COLOR >> IM_COL32_G_SHIFT) & 0xff;
+                row[x * 3 + 2] = (CANVAS_BG_COLOR >> IM_COL32_B_SHIFT) & 0xff;
+            }
+        }
+        auto drawTile = [&](size_t tile) {
+            Band band;
+            band.pixels = pixels.data();
+            band.stride = stride;
+            band.top = top;
+            band.bottom = bottom;
+            band.left = static_cast<int>(tile * TILE_WIDTH);
+            band.right = static_cast<int>(std::min<size_t>(width, (tile + 1) * TILE_WIDTH));
+            EdgeShape shape;
+            for (uint32_t i : activeEdges) {
+                float a = nodeX[edgeFrom[i]] * scale + layout.offsetX;
+                float c = nodeX[edgeTo[i]] * scale + layout.offsetX;
+                float reach = edgeReach(i) + LABEL_REACH;
+                if (std::max(a, c) + reach < band.left || std::min(a, c) - reach > band.right) {
+                    continue;
+                }
+                drawEdge(band, i, layout, options, shape);
+            }
+            for (uint32_t i : activeNodes) {
+                float x = nodeX[i] * scale + layout.offsetX;
+                float reach = std::max(nodeReach, LABEL_REACH);
+                if (x + reach < band.left || x - reach > band.right) {
+                    continue;
+                }
+                drawNode(band, i, layout, options);
+            }
+        };
+        if (tileCount > 1) {
+            ThreadPool::shared().parallelFor(tileCount, drawTile);
+        }
+        else {
+            drawTile(0);
+        }
+
+        for (int y = top; y < bottom; ++y) {
+            png.writeRow(pixels.data() + static_cast<size_t>(y - top) * stride);
+        }
+        edgeBuckets.leave(b, activeEdges);
+        nodeBuckets.leave(b, activeNodes);
+
+        if (progress) {
+            progress->fraction = static_cast<float>(b + 1) / bandCount;
+            cancelled = progress->cancel;
+        }
+    }
+
+    if (cancelled) {
+        png.finish();
+        std::remove(filename.c_str());
+        return false;
+    }
+    if (!png.finish()) {
+        std::cerr << "Failed to write PNG file: " << filename << std::endl;
+        std::remove(filename.c_str());
+        return false;
+    }
+    return true;
+}
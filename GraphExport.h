@@ -0,0 +1,109 @@
+#pragma once
+
+#include "GraphModel.h"
+#include "imgui.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class GraphAnalysis;
+
+struct ExportOptions {
+    float scale = 1.0f;                 // output pixels per graph unit, like the canvas zoom
+    float margin = 20.0f;               // pixels of background around the drawing
+    bool labels = true;                 // node ids and edge weights
+    size_t memoryBudget = 16u << 20;    // PNG: bytes of pixels rasterized at once
+};
+
+// Shared with the thread running an export
+struct ExportProgress {
+    std::atomic<float> fraction{ 0.0f };
+    std::atomic<bool> cancel{ false };
+};
+
+// Picture of a graph as the editor canvas draws it (CanvasStyle.h): nodes with their ids and
+// safety outlines, straight or curved (bidirectional) edges with arrow heads and weights.
+//
+// capture() copies what is drawn into a compact snapshot on the calling thread. Writing only
+// reads the snapshot, so it can run on a worker thread while the graph is being edited.
+// SVG is streamed one element at a time. PNG is rasterized in bands of whole rows that fit
+// the memory budget, with the columns of a band split across the shared thread pool, and
+// each band is filtered, compressed and written before the next is drawn; the image size
+// is only limited by the PNG format.
+class GraphExport {
+public:
+    // Snapshot of the graph; the analysis adds unreachable/dead-end colours (may be null)
+    void capture(Graph& graph, const GraphAnalysis* analysis);
+
+    // Pixel size of the picture for the options; false if it is too large for a PNG
+    bool getImageSize(const ExportOptions& options, uint32_t& width, uint32_t& height) const;
+
+    bool writeSvg(const std::string& filename, const ExportOptions& options, ExportProgress* progress = nullptr) const;
+    bool writePng(const std::string& filename, const ExportOptions& options, ExportProgress* progress = nullptr) const;
+
+    size_t getNodeCount() const { return nodeX.size(); }
+    size_t getEdgeCount() const { return edgeFrom.size(); }
+
+private:
+    enum NodeStatus : uint8_t {
+        Normal = 0,
+        Unreachable = 1,
+        DeadEnd = 2
+    };
+
+    enum EdgeFlags : uint8_t {
+        Curved = 1,                     // has a reverse edge
+        Trap = 2
+    };
+
+    // Graph space to pixels
+    struct Layout {
+        float scale = 1.0f;
+        float offsetX = 0.0f;
+        float offsetY = 0.0f;
+        uint32_t width = 0;
+        uint32_t height = 0;
+
+        ImVec2 toPixels(float x, float y) const { return ImVec2(x * scale + offsetX, y * scale + offsetY); }
+    };
+
+    // One edge in pixels: the shaft (two points, or the tessellated curve), the arrow head
+    // and the centre of the weight label
+    struct EdgeShape {
+        std::vector<ImVec2> points;
+        ImVec2 control[4];              // curved: the cubic the points follow
+        ImVec2 arrow[3];
+        ImVec2 labelCenter;
+        ImU32 color = 0;
+        bool curved = false;
+        bool hasArrow = false;
+    };
+
+    struct Band;
+
+    Layout layoutFor(const ExportOptions& options) const;
+    void shapeEdge(size_t slot, const Layout& layout, EdgeShape& shape) const;
+    ImU32 outlineColor(size_t slot) const;
+    const char* nodeId(size_t slot, size_t& length) const;
+    void drawEdge(Band& band, size_t slot, const Layout& layout, const ExportOptions& options, EdgeShape& shape) const;
+    void drawNode(Band& band, size_t slot, const Layout& layout, const ExportOptions& options) const;
+
+    std::vector<float> nodeX;
+    std::vector<float> nodeY;
+    std::vector<uint8_t> nodeStatus;
+    std::string idText;                 // node ids back to back
+    std::vector<size_t> idEnd;          // end of each node's id in idText
+    std::vector<float> idHalfWidth;     // pixels, independent of the scale
+    std::vector<uint32_t> edgeFrom;
+    std::vector<uint32_t> edgeTo;
+    std::vector<float> edgeWeight;
+    std::vector<uint8_t> edgeFlags;
+
+    // Graph-space bounds of the node discs and edge curves
+    float minX = 0.0f;
+    float minY = 0.0f;
+    float maxX = 0.0f;
+    float maxY = 0.0f;
+};
@@ -0,0 +1,279 @@
+#include "GraphGenerator.h"
+#include "Profiler.h"
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+namespace {
+
+const float PI = 3.14159265358979323846f;
+
+// SplitMix64: small, fast and identical everywhere
+class GeneratorRandom {
+public:
+    explicit GeneratorRandom(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, 1)
+    float uniform() {
+        return static_cast<float>(next() >> 40) * (1.0f / 16777216.0f);
+    }
+
+    // Uniform in [0, count)
+    size_t below(size_t count) {
+        return static_cast<size_t>(next() % count);
+    }
+
+private:
+    uint64_t state;
+};
+
+struct Point {
+    float x;
+    float y;
+};
+
+// Collects nodes and edges, then hands them to a GraphBatch in one commit
+class GraphBuilder {
+public:
+    GraphBuilder(const GeneratorOptions& generatorOptions) : options(generatorOptions) {
+        ids.reserve(options.nodeCount);
+        points.reserve(options.nodeCount);
+    }
+
+    size_t addNode(std::string id, float x, float y) {
+        ids.push_back(std::move(id));
+        points.push_back({ x, y });
+        return ids.size() - 1;
+    }
+
+    void addEdge(size_t from, size_t to) {
+        float dx = points[to].x - points[from].x;
+        float dy = points[to].y - points[from].y;
+        float weight = std::sqrt(dx * dx + dy * dy) / options.spacing;
+        edges.emplace_back(ids[from], ids[to], weight);
+        if (options.bidirectional) {
+            edges.emplace_back(ids[to], ids[from], weight);
+        }
+    }
+
+    const Point& position(size_t node) const { return points[node]; }
+    size_t nodeCount() const { return ids.size(); }
+
+    void commit(GraphModel& model, const std::string& graphName) {
+        GraphBatch batch = model.beginBatch(graphName);
+        for (size_t i = 0; i < ids.size(); ++i) {
+            batch.addNode(ids[i], points[i].x, points[i].y);
+        }
+        batch.addEdges(edges);
+        batch.commit();
+    }
+
+private:
+    const GeneratorOptions& options;
+    std::vector<std::string> ids;
+    std::vector<Point> points;
+    std::vector<Edge> edges;
+};
+
+void generateGrid(GraphBuilder& builder, const GeneratorOptions& options, GeneratorRandom& random) {
+    size_t width = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(options.nodeCount))));
+    float jitter = options.spacing * 0.25f;
+
+    for (size_t i = 0; i < options.nodeCount; ++i) {
+        size_t col = i % width;
+        size_t row = i / width;
+        builder.addNode("G" + std::to_string(col) + "_" + std::to_string(row),
+            col * options.spacing + (random.uniform() * 2.0f - 1.0f) * jitter,
+            row * options.spacing + (random.uniform() * 2.0f - 1.0f) * jitter);
+    }
+
+    for (size_t i = 0; i < options.nodeCount; ++i) {
+        if ((i + 1) % width != 0 && i + 1 < options.nodeCount) {
+            builder.addEdge(i, i + 1);
+        }
+        if (i + width < options.nodeCount) {
+            builder.addEdge(i, i + width);
+        }
+    }
+}
+
+void generateRandomGeometric(GraphBuilder& builder, const GeneratorOptions& options, GeneratorRandom& random) {
+    // One node per spacing^2 on average; the radius then gives the requested degree
+    float side = options.spacing * std::sqrt(static_cast<float>(options.nodeCount));
+    float degree = options.bidirectional ? options.averageDegree : options.averageDegree * 2.0f;
+    float radius = options.spacing * std::sqrt(degree / PI);
+
+    for (size_t i = 0; i < options.nodeCount; ++i) {
+        builder.addNode("R" + std::to_string(i), random.uniform() * side, random.uniform() * side);
+    }
+
+    // Bucket the points into radius-sized cells so only neighbouring cells are compared
+    size_t cells = std::max<size_t>(1, static_cast<size_t>(side / radius));
+    float cellSize = side / cells;
+    std::vector<size_t> cellStart(cells * cells + 1, 0);
+    std::vector<size_t> cellOf(options.nodeCount);
+    for (size_t i = 0; i < options.nodeCount; ++i) {
+        const Point& p = builder.position(i);
+        size_t cx = std::min(cells - 1, static_cast<size_t>(p.x / cellSize));
+        size_t cy = std::min(cells - 1, static_cast<size_t>(p.y / cellSize));
+        cellOf[i] = cy * cells + cx;
+        cellStart[cellOf[i] + 1]++;
+    }
+    for (size_t c = 0; c < cells * cells; ++c) {
+        cellStart[c + 1] += cellStart[c];
+    }
+    std::vector<size_t> cellNodes(options.nodeCount);
+    std::vector<size_t> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < options.nodeCount; ++i) {
+        cellNodes[fill[cellOf[i]]++] = i;
+    }
+
+    float radiusSquared = radius * radius;
+    for (size_t i = 0; i < options.nodeCount; ++i) {
+        const Point& p = builder.position(i);
+        size_t cx = cellOf[i] % cells;
+        size_t cy = cellOf[i] / cells;
+        for (size_t y = (cy > 0 ? cy - 1 : 0); y <= std::min(cells - 1, cy + 1); ++y) {
+            for (size_t x = (cx > 0 ? cx - 1 : 0); x <= std::min(cells - 1, cx + 1); ++x) {
+                size_t c = y * cells + x;
+                for (size_t k = cellStart[c]; k < cellStart[c + 1]; ++k) {
+                    size_t j = cellNodes[k];
+                    const Point& q = builder.position(j);
+                    // Each pair once; the reverse comes from 'bidirectional'
+                    if (j > i && (q.x - p.x) * (q.x - p.x) + (q.y - p.y) * (q.y - p.y) <= radiusSquared) {
+                        builder.addEdge(i, j);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void generateScaleFree(GraphBuilder& builder, const GeneratorOptions& options, GeneratorRandom& random) {
+    size_t links = std::max<size_t>(1, static_cast<size_t>(options.averageDegree * 0.5f + 0.5f));
+
+    // Every edge endpoint is listed once, so picking a uniform entry is picking a node
+    // with probability proportional to its degree
+    std::vector<size_t> endpoints;
+    endpoints.reserve(options.nodeCount * links * 2);
+    std::vector<size_t> targets;
+
+    builder.addNode("S0", 0.0f, 0.0f);
+    for (size_t i = 1; i < options.nodeCount; ++i) {
+        targets.clear();
+        size_t wanted = std::min(links, i);
+        while (targets.size() < wanted) {
+            size_t target = endpoints.empty() ? random.below(i) : endpoints[random.below(endpoints.size())];
+            if (std::find(targets.begin(), targets.end(), target) == targets.end()) {
+                targets.push_back(target);
+            }
+        }
+
+        // New nodes settle next to their first target, so hubs end up surrounded by their leaves
+        float angle = random.uniform() * 2.0f * PI;
+        float distance = options.spacing * (0.5f + random.uniform());
+        const Point& anchor = builder.position(targets[0]);
+        size_t node = builder.addNode("S" + std::to_string(i),
+            anchor.x + std::cos(angle) * distance, anchor.y + std::sin(angle) * distance);
+
+        for (size_t target : targets) {
+            builder.addEdge(node, target);
+            endpoints.push_back(node);
+            endpoints.push_back(target);
+        }
+    }
+}
+
+void generateHubAndSpoke(GraphBuilder& builder, const GeneratorOptions& options, GeneratorRandom& random) {
+    // About sqrt(n) hubs with sqrt(n) stations each, laid out along a corridor
+    size_t stations = options.nodeCount > 1 ? options.nodeCount - 1 : 0;
+    size_t hubs = std::max<size_t>(1, static_cast<size_t>(std::sqrt(static_cast<double>(stations))));
+    hubs = std::min(hubs, stations);
+    size_t perHub = hubs > 0 ? (stations - hubs) / hubs : 0;
+    size_t extra = hubs > 0 ? (stations - hubs) % hubs : 0;
+
+    float ring = options.spacing * std::max(2.0f, (perHub + 1) / (2.0f * PI));
+    size_t home = builder.addNode("Home", 0.0f, 0.0f);
+    size_t previous = home;
+    for (size_t h = 0; h < hubs; ++h) {
+        float hubX = (h + 1) * (2.0f * ring + options.spacing);
+        size_t hub = builder.addNode("Mid" + std::to_string(h), hubX, 0.0f);
+        builder.addEdge(previous, hub);
+        previous = hub;
+
+        size_t count = perHub + (h < extra ? 1 : 0);
+        float turn = random.uniform() * 2.0f * PI;
+        for (size_t s = 0; s < count; ++s) {
+            float angle = turn + 2.0f * PI * s / count;
+            size_t station = builder.addNode("See" + std::to_string(h) + "_" + std::to_string(s),
+                hubX + std::cos(angle) * ring, std::sin(angle) * ring);
+            builder.addEdge(hub, station);
+        }
+    }
+}
+
+} // namespace
+
+const char* generatorKindName(GeneratorOptions::Kind kind) {
+    switch (kind) {
+    case GeneratorOptions::Kind::Grid: return "grid";
+    case GeneratorOptions::Kind::RandomGeometric: return "geometric";
+    case GeneratorOptions::Kind::ScaleFree: return "scalefree";
+    case GeneratorOptions::Kind::HubAndSpoke: return "hub";
+    }
+    return "";
+}
+
+bool parseGeneratorKind(const std::string& name, GeneratorOptions::Kind& kind) {
+    const GeneratorOptions::Kind kinds[] = {
+        GeneratorOptions::Kind::Grid,
+        GeneratorOptions::Kind::RandomGeometric,
+        GeneratorOptions::Kind::ScaleFree,
+        GeneratorOptions::Kind::HubAndSpoke
+    };
+    for (auto candidate : kinds) {
+        if (name == generatorKindName(candidate)) {
+            kind = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool generateGraph(GraphModel& model, const std::string& graphName, const GeneratorOptions& options) {
+    PROFILE_SCOPE("generateGraph");
+    if (graphName.empty() || options.nodeCount == 0 || !(options.spacing > 0.0f) ||
+        !(options.averageDegree > 0.0f)) {
+        std::cerr << "Invalid generator options for graph: " << graphName << std::endl;
+        return false;
+    }
+
+    GraphBuilder builder(options);
+    GeneratorRandom random(options.seed);
+    switch (options.kind) {
+    case GeneratorOptions::Kind::Grid:
+        generateGrid(builder, options, random);
+        break;
+    case GeneratorOptions::Kind::RandomGeometric:
+        generateRandomGeometric(builder, options, random);
+        break;
+    case GeneratorOptions::Kind::ScaleFree:
+        generateScaleFree(builder, options, random);
+        break;
+    case GeneratorOptions::Kind::HubAndSpoke:
+        generateHubAndSpoke(builder, options, random);
+        break;
+    }
+
+    // Replace, not merge into, an existing graph of that name
+    model.removeGraph(graphName);
+    builder.commit(model, graphName);
+    return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "GraphModel.h"
+#include <cstdint>
+#include <string>
+
+// Synthetic graphs for load testing the loader, the canvas and the route queries.
+//
+// The same options and seed always produce the same graph on every platform (the
+// generator uses its own random source, not the implementation-defined std distributions).
+// Edge weights are the Euclidean length divided by the spacing, so neighbouring nodes
+// are about 1 apart, as in the hand-made graphs.
+struct GeneratorOptions {
+    enum class Kind {
+        Grid,               // jittered lattice with 4-neighbour edges
+        RandomGeometric,    // uniform points joined within a radius
+        ScaleFree,          // preferential attachment (Barabasi-Albert)
+        HubAndSpoke         // Home, a corridor of Mid hubs and See stations, like Gantry
+    };
+
+    Kind kind = Kind::Grid;
+    size_t nodeCount = 1000;
+    uint32_t seed = 1;
+    float spacing = 150.0f;     // typical distance between neighbouring nodes
+    float averageDegree = 4.0f; // target out-degree (RandomGeometric, ScaleFree)
+    bool bidirectional = true;  // add the reverse of every edge
+};
+
+const char* generatorKindName(GeneratorOptions::Kind kind);
+bool parseGeneratorKind(const std::string& name, GeneratorOptions::Kind& kind);
+
+// Replace (or create) the named graph of the model with a generated one
+bool generateGraph(GraphModel& model, const std::string& graphName, const GeneratorOptions& options);
@@ -0,0 +1,115 @@
+#include "GraphMinimap.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+// Empty space around the nodes, as a fraction of the larger graph extent
+const float BOUNDS_PADDING = 0.05f;
+
+// Smallest drawn point, in pixels
+const float MIN_POINT_SIZE = 2.0f;
+
+void GraphMinimap::update(const Graph& target) {
+    if (graph != &target || builtVersion != target.version || buildCount == 0) {
+        graph = &target;
+        builtVersion = target.version;
+        rebuild(target);
+    }
+}
+
+void GraphMinimap::rebuild(const Graph& target) {
+    PROFILE_SCOPE("GraphMinimap::rebuild");
+    points.clear();
+    ++buildCount;
+    if (target.nodes.empty()) {
+        return;
+    }
+
+    float maxX = target.nodes[0]->x;
+    float maxY = target.nodes[0]->y;
+    minX = maxX;
+    minY = maxY;
+    for (const auto& node : target.nodes) {
+        minX = std::min(minX, node->x);
+        minY = std::min(minY, node->y);
+        maxX = std::max(maxX, node->x);
+        maxY = std::max(maxY, node->y);
+    }
+    float padding = std::max(std::max(maxX - minX, maxY - minY) * BOUNDS_PADDING, 1.0f);
+    minX -= padding;
+    minY -= padding;
+    width = maxX - minX + padding;
+    height = maxY - minY + padding;
+
+    // Grid with roughly square cells and at most 'budget' of them
+    float aspect = width / height;
+    int columns = std::max(1, static_cast<int>(std::sqrt(static_cast<float>(budget) * aspect)));
+    int rows = std::max(1, static_cast<int>(budget / columns));
+    cellU = 1.0f / columns;
+    cellV = 1.0f / rows;
+
+    std::vector<uint32_t> counts(static_cast<size_t>(columns) * rows, 0);
+    uint32_t densest = 0;
+    for (const auto& node : target.nodes) {
+        int column = std::min(static_cast<int>((node->x - minX) / width * columns), columns - 1);
+        int row = std::min(static_cast<int>((node->y - minY) / height * rows), rows - 1);
+        uint32_t& count = counts[static_cast<size_t>(row) * columns + column];
+        densest = std::max(densest, ++count);
+    }
+
+    // Shade on a log scale so sparse areas still show next to dense ones
+    float shade = 1.0f / std::log2(static_cast<float>(densest) + 1.0f);
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            uint32_t count = counts[static_cast<size_t>(row) * columns + column];
+            if (count == 0) {
+                continue;
+            }
+            float level = std::log2(static_cast<float>(count) + 1.0f) * shade;
+            Point point;
+            point.u = (column + 0.5f) * cellU;
+            point.v = (row + 0.5f) * cellV;
+            point.alpha = static_cast<uint8_t>(90.0f + 165.0f * level);
+            points.push_back(point);
+        }
+    }
+}
+
+void GraphMinimap::fit(const ImVec2& min, const ImVec2& max, ImVec2& mapMin, ImVec2& mapMax) const {
+    float scale = std::min((max.x - min.x) / width, (max.y - min.y) / height);
+    float mapWidth = width * scale;
+    float mapHeight = height * scale;
+    mapMin = ImVec2(min.x + (max.x - min.x - mapWidth) * 0.5f, min.y + (max.y - min.y - mapHeight) * 0.5f);
+    mapMax = ImVec2(mapMin.x + mapWidth, mapMin.y + mapHeight);
+}
+
+void GraphMinimap::draw(ImDrawList* drawList, const ImVec2& mapMin, const ImVec2& mapMax, ImU32 color) const {
+    if (points.empty()) {
+        return;
+    }
+
+    float mapWidth = mapMax.x - mapMin.x;
+    float mapHeight = mapMax.y - mapMin.y;
+    float halfX = std::max(cellU * mapWidth, MIN_POINT_SIZE) * 0.5f;
+    float halfY = std::max(cellV * mapHeight, MIN_POINT_SIZE) * 0.5f;
+
+    // One quad per point, reserved up front
+    ImU32 rgb = color & ~IM_COL32_A_MASK;
+    drawList->PrimReserve(static_cast<int>(points.size()) * 6, static_cast<int>(points.size()) * 4);
+    for (const Point& point : points) {
+        float x = mapMin.x + point.u * mapWidth;
+        float y = mapMin.y + point.v * mapHeight;
+        drawList->PrimRect(ImVec2(x - halfX, y - halfY), ImVec2(x + halfX, y + halfY),
+            rgb | (static_cast<ImU32>(point.alpha) << IM_COL32_A_SHIFT));
+    }
+}
+
+ImVec2 GraphMinimap::toMap(const ImVec2& graphPos, const ImVec2& mapMin, const ImVec2& mapMax) const {
+    return ImVec2(mapMin.x + (graphPos.x - minX) / width * (mapMax.x - mapMin.x),
+        mapMin.y + (graphPos.y - minY) / height * (mapMax.y - mapMin.y));
+}
+
+ImVec2 GraphMinimap::toGraph(const ImVec2& mapPos, const ImVec2& mapMin, const ImVec2& mapMax) const {
+    return ImVec2(minX + (mapPos.x - mapMin.x) / (mapMax.x - mapMin.x) * width,
+        minY + (mapPos.y - mapMin.y) / (mapMax.y - mapMin.y) * height);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "GraphModel.h"
+#include "imgui.h"
+#include <cstdint>
+#include <vector>
+
+// Overview of a whole graph for the canvas minimap.
+//
+// The nodes are binned into a grid of at most 'pointBudget' cells fitted to the graph's
+// bounding box, and every occupied cell becomes one point shaded by its node count. The
+// points are kept in normalized [0, 1] coordinates and only rebuilt when the graph's
+// version changes, so drawing costs the same handful of vertices per frame however many
+// nodes the graph has.
+class GraphMinimap {
+public:
+    explicit GraphMinimap(size_t pointBudget) : budget(pointBudget) {}
+
+    // Rebuild the points if the graph changed since the last call
+    void update(const Graph& graph);
+
+    // Largest rectangle with the graph's aspect ratio centred in [min, max]
+    void fit(const ImVec2& min, const ImVec2& max, ImVec2& mapMin, ImVec2& mapMax) const;
+
+    // Draw the points into a rectangle returned by fit()
+    void draw(ImDrawList* drawList, const ImVec2& mapMin, const ImVec2& mapMax, ImU32 color) const;
+
+    // Map between graph space and a rectangle returned by fit()
+    ImVec2 toMap(const ImVec2& graphPos, const ImVec2& mapMin, const ImVec2& mapMax) const;
+    ImVec2 toGraph(const ImVec2& mapPos, const ImVec2& mapMin, const ImVec2& mapMax) const;
+
+    bool isEmpty() const { return points.empty(); }
+    size_t getPointCount() const { return points.size(); }
+    size_t getBuildCount() const { return buildCount; }
+
+private:
+    struct Point {
+        float u;
+        float v;
+        uint8_t alpha;
+    };
+
+    void rebuild(const Graph& graph);
+
+    size_t budget;
+    const Graph* graph = nullptr;
+    uint64_t builtVersion = 0;
+    size_t buildCount = 0;
+
+    // Graph-space bounds and grid cell size, as fractions of the bounds
+    float minX = 0.0f;
+    float minY = 0.0f;
+    float width = 1.0f;
+    float height = 1.0f;
+    float cellU = 1.0f;
+    float cellV = 1.0f;
+    std::vector<Point> points;
+};
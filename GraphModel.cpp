@@ -1,155 +1,1919 @@
 #include "GraphModel.h"
+#include "JsonWriter.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+#include "MappedFile.h"
 #include <fstream>
 #include <iostream>
+#include <unordered_set>
+#include <cmath>
+#include <numeric>
+#include <cstring>
+#include <cstdio>
+#include <charconv>
+#include <string_view>
+
+void computeEdgeCosts(const WeightModel& model, const float* dx, const float* dy, float* out, size_t count) {
+    if (model.mode == WeightModel::Mode::Distance) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = std::sqrt(dx[i] * dx[i] + dy[i] * dy[i]);
+        }
+        return;
+    }
+
+    // Trapezoidal profile with peak speed vp = min(v, sqrt(d * a)): t = d / vp + vp / a.
+    // This is d / v + v / a when the axis reaches full speed and 2 * sqrt(d / a) otherwise.
+    // Written with min/max only so the loop has no branches; the slower axis dominates.
+    const float velocity = std::max(model.velocity, 1e-6f);
+    const float acceleration = std::max(model.acceleration, 1e-6f);
+    const float invAcceleration = 1.0f / acceleration;
+
+    for (size_t i = 0; i < count; ++i) {
+        float distX = std::fabs(dx[i]);
+        float distY = std::fabs(dy[i]);
+        float peakX = std::max(std::min(velocity, std::sqrt(distX * acceleration)), 1e-6f);
+        float peakY = std::max(std::min(velocity, std::sqrt(distY * acceleration)), 1e-6f);
+        float timeX = distX / peakX + peakX * invAcceleration;
+        float timeY = distY / peakY + peakY * invAcceleration;
+        out[i] = std::max(timeX, timeY);
+    }
+}
+
+void Graph::rebuildIndex() {
+    nodeIndex.clear();
+    nodeIndex.reserve(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodeIndex.emplace(nodes[i]->id, i);
+    }
+
+    edgeIndex.clear();
+    edgeIndex.reserve(edges.size());
+    for (size_t i = 0; i < edges.size(); ++i) {
+        edgeIndex.emplace(std::make_pair(edges[i]->from, edges[i]->to), i);
+    }
+}
+
+namespace {
+
+uint64_t mixHash(uint64_t value) {
+    // SplitMix64 finalizer
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+uint64_t floatBits(float value) {
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+} // namespace
+
+uint64_t Graph::hashNode(const Node& node) {
+    uint64_t h = mixHash(std::hash<std::string>()(node.id));
+    return mixHash(h ^ (floatBits(node.x) << 32 | floatBits(node.y)));
+}
+
+uint64_t Graph::hashEdge(const Edge& edge) {
+    // Different seed from nodes, so an edge can not cancel a node out
+    uint64_t h = mixHash(std::hash<std::string>()(edge.from) + 0x9e3779b97f4a7c15ull);
+    h = mixHash(h ^ std::hash<std::string>()(edge.to));
+    return mixHash(h ^ floatBits(edge.weight));
+}
+
+void Graph::rehash() {
+    uint64_t h = mixHash(static_cast<uint64_t>(weightModel.mode) << 32 ^ floatBits(weightModel.velocity));
+    h = mixHash(h ^ floatBits(weightModel.acceleration));
+    for (const auto& node : nodes) {
+        h += hashNode(*node);
+    }
+    for (const auto& edge : edges) {
+        h += hashEdge(*edge);
+    }
+    stateHash = h;
+}
+
+void Graph::updateGeometryIndex() {
+    if (geometryIndexVersion == topologyVersion) {
+        return;
+    }
+
+    edgeFromSlot.resize(edges.size());
+    edgeToSlot.resize(edges.size());
+    incidentEdges.resize(nodes.size());
+    for (auto& incident : incidentEdges) {
+        incident.clear();
+    }
+
+    for (size_t i = 0; i < edges.size(); ++i) {
+        uint32_t from = static_cast<uint32_t>(nodeIndex[edges[i]->from]);
+        uint32_t to = static_cast<uint32_t>(nodeIndex[edges[i]->to]);
+        edgeFromSlot[i] = from;
+        edgeToSlot[i] = to;
+        incidentEdges[from].push_back(static_cast<uint32_t>(i));
+        if (to != from) {
+            incidentEdges[to].push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    geometryIndexVersion = topologyVersion;
+}
+
+GraphMemoryUsage Graph::getMemoryUsage() const {
+    GraphMemoryUsage usage;
+    usage.nodeCount = nodes.size();
+    usage.edgeCount = edges.size();
+    usage.arenaBytes = arena->getReservedBytes();
+    usage.arenaUsedBytes = arena->getUsedBytes();
+
+    // Large arena requests are the hash bucket arrays
+    usage.tableBytes = arena->getLargeBytes() + nodes.capacity() * sizeof(nodes[0]) +
+        edges.capacity() * sizeof(edges[0]) +
+        (edgeFromSlot.capacity() + edgeToSlot.capacity()) * sizeof(uint32_t) +
+        incidentEdges.capacity() * sizeof(incidentEdges[0]);
+    for (const auto& incident : incidentEdges) {
+        usage.tableBytes += incident.capacity() * sizeof(uint32_t);
+    }
+
+    // Ids are stored in the node or edge and again as index keys
+    const size_t inlineCapacity = std::string().capacity();
+    auto heapBytes = [inlineCapacity](const std::string& text) {
+        return text.capacity() > inlineCapacity ? text.capacity() + 1 : 0;
+    };
+    for (const auto& node : nodes) {
+        usage.stringBytes += 2 * heapBytes(node->id);
+    }
+    for (const auto& edge : edges) {
+        usage.stringBytes += 2 * (heapBytes(edge->from) + heapBytes(edge->to));
+    }
+    return usage;
+}
+
+float Graph::deriveWeight(const Node& from, const Node& to) const {
+    float dx = to.x - from.x;
+    float dy = to.y - from.y;
+    float weight = 0.0f;
+    computeEdgeCosts(weightModel, &dx, &dy, &weight, 1);
+    return weight;
+}
+
+void Graph::setNodePosition(const std::string& id, float x, float y) {
+    auto it = nodeIndex.find(id);
+    if (it == nodeIndex.end()) {
+        return;
+    }
+
+    Node& node = *nodes[it->second];
+    stateHash -= hashNode(node);
+    node.x = x;
+    node.y = y;
+    stateHash += hashNode(node);
+
+    if (weightModel.mode != WeightModel::Mode::Manual) {
+        updateGeometryIndex();
+        for (uint32_t e : incidentEdges[it->second]) {
+            Edge& edge = *edges[e];
+            stateHash -= hashEdge(edge);
+            edge.weight = deriveWeight(*nodes[edgeFromSlot[e]], *nodes[edgeToSlot[e]]);
+            stateHash += hashEdge(edge);
+        }
+    }
+
+    notifyChange(GraphChange::NodeMoved, id);
+}
+
+void Graph::moveNodes(const std::vector<uint32_t>& slots, float dx, float dy) {
+    if (slots.empty() || (dx == 0.0f && dy == 0.0f)) {
+        return;
+    }
+
+    for (uint32_t slot : slots) {
+        stateHash -= hashNode(*nodes[slot]);
+    }
+    for (uint32_t slot : slots) {
+        Node& node = *nodes[slot];
+        node.x += dx;
+        node.y += dy;
+    }
+    for (uint32_t slot : slots) {
+        stateHash += hashNode(*nodes[slot]);
+    }
+
+    if (weightModel.mode != WeightModel::Mode::Manual) {
+        // Edges inside the group keep their length. The ones leaving it are found once, from
+        // their moved end, and re-weighted in one cost pass.
+        updateGeometryIndex();
+        std::vector<char> moved(nodes.size(), 0);
+        for (uint32_t slot : slots) {
+            moved[slot] = 1;
+        }
+        std::vector<uint32_t> touched;
+        for (uint32_t slot : slots) {
+            for (uint32_t e : incidentEdges[slot]) {
+                if (!moved[edgeFromSlot[e]] || !moved[edgeToSlot[e]]) {
+                    touched.push_back(e);
+                }
+            }
+        }
+
+        const size_t count = touched.size();
+        std::vector<float> edgeDx(count);
+        std::vector<float> edgeDy(count);
+        std::vector<float> costs(count);
+        for (size_t i = 0; i < count; ++i) {
+            const Node& from = *nodes[edgeFromSlot[touched[i]]];
+            const Node& to = *nodes[edgeToSlot[touched[i]]];
+            edgeDx[i] = to.x - from.x;
+            edgeDy[i] = to.y - from.y;
+        }
+        computeEdgeCosts(weightModel, edgeDx.data(), edgeDy.data(), costs.data(), count);
+
+        for (size_t i = 0; i < count; ++i) {
+            Edge& edge = *edges[touched[i]];
+            stateHash -= hashEdge(edge);
+            edge.weight = costs[i];
+            stateHash += hashEdge(edge);
+        }
+    }
+
+    // Reported node by node, so listeners stay incremental (a bulk move would reset them)
+    for (uint32_t slot : slots) {
+        notifyChange(GraphChange::NodeMoved, nodes[slot]->id);
+    }
+}
+
+void Graph::setWeightModel(const WeightModel& model) {
+    weightModel = model;
+    if (weightModel.mode == WeightModel::Mode::Manual) {
+        notifyChange(GraphChange::WeightsChanged);
+    }
+    else {
+        recomputeWeights();
+    }
+}
+
+void Graph::recomputeWeights() {
+    if (weightModel.mode == WeightModel::Mode::Manual) {
+        return;
+    }
+
+    updateGeometryIndex();
+
+    // Gather endpoint deltas into flat arrays so the cost pass is a straight loop
+    const size_t count = edges.size();
+    std::vector<float> dx(count);
+    std::vector<float> dy(count);
+    std::vector<float> costs(count);
+    for (size_t i = 0; i < count; ++i) {
+        const Node& from = *nodes[edgeFromSlot[i]];
+        const Node& to = *nodes[edgeToSlot[i]];
+        dx[i] = to.x - from.x;
+        dy[i] = to.y - from.y;
+    }
+
+    computeEdgeCosts(weightModel, dx.data(), dy.data(), costs.data(), count);
+
+    for (size_t i = 0; i < count; ++i) {
+        edges[i]->weight = costs[i];
+    }
+
+    notifyChange(GraphChange::WeightsChanged);
+}
+
+void GraphBatch::addNode(const std::string& id) {
+    PendingNode pending;
+    pending.id = id;
+    pendingNodes.push_back(std::move(pending));
+}
+
+void GraphBatch::addNode(const std::string& id, float x, float y) {
+    PendingNode pending;
+    pending.id = id;
+    pending.x = x;
+    pending.y = y;
+    pending.hasPosition = true;
+    pendingNodes.push_back(std::move(pending));
+}
+
+void GraphBatch::addNodes(const std::vector<std::string>& ids) {
+    pendingNodes.reserve(pendingNodes.size() + ids.size());
+    for (const auto& id : ids) {
+        addNode(id);
+    }
+}
+
+void GraphBatch::addEdge(const std::string& from, const std::string& to, float weight) {
+    pendingEdges.emplace_back(from, to, weight);
+}
+
+void GraphBatch::addEdges(const std::vector<Edge>& edgeList) {
+    pendingEdges.insert(pendingEdges.end(), edgeList.begin(), edgeList.end());
+}
+
+void GraphBatch::removeNode(const std::string& id) {
+    pendingRemovals.push_back(id);
+}
+
+void GraphBatch::removeNodes(const std::vector<std::string>& ids) {
+    pendingRemovals.insert(pendingRemovals.end(), ids.begin(), ids.end());
+}
+
+void GraphBatch::removeEdge(const std::string& from, const std::string& to) {
+    pendingEdgeRemovals.emplace_back(from, to);
+}
+
+void GraphBatch::setEdgeWeight(const std::string& from, const std::string& to, float weight) {
+    pendingWeights.emplace_back(from, to, weight);
+}
+
+size_t GraphBatch::commit() {
+    size_t changes = 0;
+    bool touched = false;
+
+    // Removals: drop the nodes and every incident edge in a single pass each
+    if (!pendingRemovals.empty()) {
+        std::unordered_set<std::string> removed(pendingRemovals.begin(), pendingRemovals.end());
+        size_t nodeCount = graph.nodes.size();
+        size_t edgeCount = graph.edges.size();
+
+        graph.edges.erase(std::remove_if(graph.edges.begin(), graph.edges.end(),
+            [&removed](const std::shared_ptr<Edge>& e) {
+            return removed.count(e->from) > 0 || removed.count(e->to) > 0;
+        }), graph.edges.end());
+
+        graph.nodes.erase(std::remove_if(graph.nodes.begin(), graph.nodes.end(),
+            [&removed](const std::shared_ptr<Node>& n) { return removed.count(n->id) > 0; }),
+            graph.nodes.end());
+
+        changes += (nodeCount - graph.nodes.size()) + (edgeCount - graph.edges.size());
+        graph.rebuildIndex();
+    }
+
+    // Edge removals, also in one pass
+    if (!pendingEdgeRemovals.empty()) {
+        std::unordered_set<std::pair<std::string, std::string>, EdgeKeyHash> removed(
+            pendingEdgeRemovals.begin(), pendingEdgeRemovals.end());
+        size_t edgeCount = graph.edges.size();
+
+        graph.edges.erase(std::remove_if(graph.edges.begin(), graph.edges.end(),
+            [&removed](const std::shared_ptr<Edge>& e) {
+            return removed.count(std::make_pair(e->from, e->to)) > 0;
+        }), graph.edges.end());
+
+        if (graph.edges.size() != edgeCount) {
+            changes += edgeCount - graph.edges.size();
+            graph.rebuildIndex();
+        }
+    }
+
+    // Node additions: the index doubles as the dedup set
+    graph.nodes.reserve(graph.nodes.size() + pendingNodes.size());
+    graph.nodeIndex.reserve(graph.nodes.size() + pendingNodes.size());
+    for (const auto& pending : pendingNodes) {
+        auto inserted = graph.nodeIndex.emplace(pending.id, graph.nodes.size());
+        if (inserted.second) {
+            graph.nodes.push_back(graph.makeNode(pending.id));
+            ++changes;
+        }
+        if (pending.hasPosition) {
+            auto& node = graph.nodes[inserted.first->second];
+            node->x = pending.x;
+            node->y = pending.y;
+            touched = true;
+        }
+    }
+
+    // Edge additions: both endpoints must exist after the node pass
+    graph.edges.reserve(graph.edges.size() + pendingEdges.size());
+    graph.edgeIndex.reserve(graph.edges.size() + pendingEdges.size());
+    for (const auto& pending : pendingEdges) {
+        if (graph.nodeIndex.find(pending.from) == graph.nodeIndex.end() ||
+            graph.nodeIndex.find(pending.to) == graph.nodeIndex.end()) {
+            continue;
+        }
+        if (graph.edgeIndex.emplace(std::make_pair(pending.from, pending.to), graph.edges.size()).second) {
+            graph.edges.push_back(graph.makeEdge(pending.from, pending.to, pending.weight));
+            ++changes;
+        }
+    }
+
+    // Weight updates of existing edges
+    for (const auto& pending : pendingWeights) {
+        auto edge = graph.findEdge(pending.from, pending.to);
+        if (edge && edge->weight != pending.weight) {
+            edge->weight = pending.weight;
+            touched = true;
+        }
+    }
+
+    pendingNodes.clear();
+    pendingEdges.clear();
+    pendingRemovals.clear();
+    pendingEdgeRemovals.clear();
+    pendingWeights.clear();
+
+    if (changes > 0 || touched) {
+        graph.notifyChange(GraphChange::Reset);
+
+        // Derived weights are refreshed in one pass after the index is up to date
+        graph.recomputeWeights();
+    }
+    return changes;
+}
+
+namespace {
+
+// Byte range of one value in a JSON document, [begin, end)
+struct JsonSpan {
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+// Minimal structural scanner: finds value boundaries without building anything
+class JsonScanner {
+public:
+    explicit JsonScanner(const std::string& source) : text(source) {}
+
+    void skipSpace() {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\n' || text[pos] == '\r' || text[pos] == '\t')) {
+            ++pos;
+        }
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (pos < text.size() && text[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool peek(char c) {
+        skipSpace();
+        return pos < text.size() && text[pos] == c;
+    }
+
+    // A UTF-8 byte order mark at the start, which nlohmann accepts too
+    void skipByteOrderMark() {
+        if (pos == 0 && text.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+            pos = 3;
+        }
+    }
+
+    // Reads a string token and decodes it only when it contains escapes
+    bool readString(std::string& value) {
+        skipSpace();
+        size_t begin = pos;
+        if (!skipString()) {
+            return false;
+        }
+        if (std::find(text.begin() + begin, text.begin() + pos, '\\') == text.begin() + pos) {
+            value.assign(text, begin + 1, pos - begin - 2);
+        }
+        else {
+            value = nlohmann::json::parse(text.begin() + begin, text.begin() + pos).get<std::string>();
+        }
+        return true;
+    }
+
+    bool skipValue(JsonSpan& span) {
+        skipSpace();
+        span.begin = pos;
+        if (pos >= text.size()) {
+            return false;
+        }
+
+        if (text[pos] == '"') {
+            if (!skipString()) {
+                return false;
+            }
+        }
+        else if (text[pos] == '{' || text[pos] == '[') {
+            // Strings are skipped as a whole, so brackets inside them are not counted
+            int depth = 0;
+            while (pos < text.size()) {
+                char c = text[pos];
+                if (c == '"') {
+                    if (!skipString()) {
+                        return false;
+                    }
+                    continue;
+                }
+                ++pos;
+                if (c == '{' || c == '[') {
+                    ++depth;
+                }
+                else if (c == '}' || c == ']') {
+                    if (--depth == 0) {
+                        break;
+                    }
+                }
+            }
+            if (depth != 0) {
+                return false;
+            }
+        }
+        else {
+            // Number, true, false or null
+            while (pos < text.size() && text[pos] != ',' && text[pos] != '}' && text[pos] != ']' &&
+                text[pos] != ' ' && text[pos] != '\n' && text[pos] != '\r' && text[pos] != '\t') {
+                ++pos;
+            }
+        }
+
+        span.end = pos;
+        return span.end > span.begin;
+    }
+
+private:
+    bool skipString() {
+        if (pos >= text.size() || text[pos] != '"') {
+            return false;
+        }
+        for (++pos; pos < text.size(); ++pos) {
+            if (text[pos] == '\\') {
+                ++pos;
+            }
+            else if (text[pos] == '"') {
+                ++pos;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const std::string& text;
+    size_t pos = 0;
+};
+
+// Finds the span of every graph under "graphs" and of the optional "transfers" array
+bool indexGraphFile(const std::string& text, std::vector<std::pair<std::string, JsonSpan>>& graphSpans,
+    JsonSpan& transfersSpan, bool& hasGraphs) {
+    JsonScanner scanner(text);
+    hasGraphs = false;
+    transfersSpan = JsonSpan();
+
+    // Spans stay offsets into the whole text, mark included
+    scanner.skipByteOrderMark();
+    if (!scanner.consume('{')) {
+        return false;
+    }
+    if (scanner.consume('}')) {
+        return true;
+    }
+
+    do {
+        std::string key;
+        if (!scanner.readString(key) || !scanner.consume(':')) {
+            return false;
+        }
+
+        if (key == "graphs" && scanner.peek('{')) {
+            hasGraphs = true;
+            scanner.consume('{');
+            if (!scanner.consume('}')) {
+                do {
+                    std::string name;
+                    JsonSpan span;
+                    if (!scanner.readString(name) || !scanner.consume(':') || !scanner.skipValue(span)) {
+                        return false;
+                    }
+                    graphSpans.emplace_back(std::move(name), span);
+                } while (scanner.consume(','));
+
+                if (!scanner.consume('}')) {
+                    return false;
+                }
+            }
+        }
+        else {
+            JsonSpan span;
+            if (!scanner.skipValue(span)) {
+                return false;
+            }
+            if (key == "transfers") {
+                transfersSpan = span;
+            }
+        }
+    } while (scanner.consume(','));
+
+    return scanner.consume('}');
+}
+
+// Node as stored in a file; old files have ids only
+struct NodeRecord {
+    std::string id;
+    float x = 0.0f;
+    float y = 0.0f;
+    bool hasPosition = false;
+};
+
+// Decoded content of one graph value, in file order
+struct GraphContent {
+    std::vector<NodeRecord> nodes;
+    std::unordered_map<std::string, size_t> nodeIndex;
+    std::vector<Edge> edges;
+    std::unordered_map<std::pair<std::string, std::string>, size_t, EdgeKeyHash> edgeIndex;
+    bool hasWeightModel = false;
+    WeightModel weightModel;
+};
+
+GraphContent readGraphContent(const nlohmann::json& graphData) {
+    GraphContent content;
+    if (!graphData.is_object()) {
+        return content;
+    }
+
+    // Nodes: either an array of id strings (old format) or of objects with positions.
+    // A repeated id keeps its first slot and takes the last position.
+    if (graphData.contains("nodes") && graphData["nodes"].is_array()) {
+        for (const auto& nodeData : graphData["nodes"]) {
+            NodeRecord record;
+            if (nodeData.is_string()) {
+                record.id = nodeData.get<std::string>();
+            }
+            else if (nodeData.is_object() && nodeData.contains("id") && nodeData["id"].is_string()) {
+                record.id = nodeData["id"].get<std::string>();
+                record.hasPosition = true;
+
+                // Load position if available
+                if (nodeData.contains("x") && nodeData["x"].is_number()) {
+                    record.x = nodeData["x"];
+                }
+                if (nodeData.contains("y") && nodeData["y"].is_number()) {
+                    record.y = nodeData["y"];
+                }
+            }
+            else {
+                continue;
+            }
+
+            auto inserted = content.nodeIndex.emplace(record.id, content.nodes.size());
+            if (inserted.second) {
+                content.nodes.push_back(std::move(record));
+            }
+            else if (record.hasPosition) {
+                content.nodes[inserted.first->second] = std::move(record);
+            }
+        }
+    }
+
+    // Edges: the first of repeated (from, to) pairs wins
+    if (graphData.contains("edges") && graphData["edges"].is_array()) {
+        for (const auto& edgeData : graphData["edges"]) {
+            if (edgeData.contains("from") && edgeData.contains("to") &&
+                edgeData["from"].is_string() && edgeData["to"].is_string()) {
+
+                float weight = 1.0f;
+                if (edgeData.contains("weight") && edgeData["weight"].is_number()) {
+                    weight = edgeData["weight"];
+                }
+
+                Edge edge(edgeData["from"].get<std::string>(), edgeData["to"].get<std::string>(), weight);
+                if (content.edgeIndex.emplace(std::make_pair(edge.from, edge.to), content.edges.size()).second) {
+                    content.edges.push_back(std::move(edge));
+                }
+            }
+        }
+    }
+
+    // Optional geometry-derived weight model
+    if (graphData.contains("weightModel") && graphData["weightModel"].is_object()) {
+        const auto& modelData = graphData["weightModel"];
+        content.hasWeightModel = true;
+        std::string mode = modelData.value("mode", std::string("manual"));
+        if (mode == "distance") {
+            content.weightModel.mode = WeightModel::Mode::Distance;
+        }
+        else if (mode == "moveTime") {
+            content.weightModel.mode = WeightModel::Mode::MoveTime;
+        }
+        content.weightModel.velocity = modelData.value("velocity", content.weightModel.velocity);
+        content.weightModel.acceleration = modelData.value("acceleration", content.weightModel.acceleration);
+    }
+
+    return content;
+}
+
+bool sameWeightModel(const WeightModel& a, const WeightModel& b) {
+    return a.mode == b.mode && a.velocity == b.velocity && a.acceleration == b.acceleration;
+}
+
+// Compact output has no line breaks; pretty output breaks inside every non-empty value
+bool isCompactText(const char* data, size_t size) {
+    return std::memchr(data, '\n', size) == nullptr;
+}
+
+} // namespace
+
+uint64_t contentHash(const char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i) {
+        if (data[i] != '\r') {
+            hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+bool GraphFileIndex::build(std::shared_ptr<const std::string> source, GraphFileIndex& index, bool hashGraphs) {
+    PROFILE_SCOPE("GraphFileIndex::build");
+    std::vector<std::pair<std::string, JsonSpan>> graphSpans;
+    JsonSpan transfersSpan;
+    bool hasGraphs = false;
+    if (!indexGraphFile(*source, graphSpans, transfersSpan, hasGraphs)) {
+        std::cerr << "Invalid JSON structure: could not scan the file" << std::endl;
+        return false;
+    }
+    if (!hasGraphs) {
+        std::cerr << "Invalid JSON structure: 'graphs' object not found" << std::endl;
+        return false;
+    }
+
+    index.graphs.clear();
+    index.graphs.reserve(graphSpans.size());
+    for (auto& pair : graphSpans) {
+        Entry entry;
+        entry.name = std::move(pair.first);
+        entry.begin = pair.second.begin;
+        entry.end = pair.second.end;
+        index.graphs.push_back(std::move(entry));
+    }
+
+    // Hashing touches every byte, so the graphs are hashed in parallel
+    if (hashGraphs) {
+        ThreadPool::shared().parallelFor(index.graphs.size(), [&](size_t i) {
+            Entry& entry = index.graphs[i];
+            entry.hash = contentHash(source->data() + entry.begin, entry.end - entry.begin);
+        });
+    }
+    index.hashed = hashGraphs;
+
+    index.transfersBegin = transfersSpan.begin;
+    index.transfersEnd = transfersSpan.end;
+    index.transfersHash = contentHash(source->data() + transfersSpan.begin, transfersSpan.end - transfersSpan.begin);
+    index.text = std::move(source);
+    return true;
+}
+
+bool GraphFileIndex::read(const std::string& filename, GraphFileIndex& index, bool hashGraphs) {
+    PROFILE_SCOPE("GraphFileIndex::read");
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        return false;
+    }
+
+    auto text = std::make_shared<std::string>();
+    file.seekg(0, std::ios::end);
+    text->resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0, std::ios::beg);
+    if (!text->empty()) {
+        file.read(&(*text)[0], static_cast<std::streamsize>(text->size()));
+    }
+    file.close();
+
+    return build(std::move(text), index, hashGraphs);
+}
+
+std::shared_ptr<Graph> GraphModel::getGraph(const std::string& name) {
+    auto it = graphs.find(name);
+    if (it != graphs.end()) {
+        return it->second;
+    }
+
+    // Materialize a lazily loaded graph on first access
+    auto sourceIt = sources.find(name);
+    if (sourceIt == sources.end() || !sourceIt->second.text) {
+        return nullptr;
+    }
+
+    PROFILE_SCOPE("GraphModel::materializeGraph");
+    GraphSource& source = sourceIt->second;
+    try {
+        nlohmann::json graphData = nlohmann::json::parse(
+            source.text->begin() + source.begin, source.text->begin() + source.end);
+        loadGraph(name, graphData);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error loading graph " << name << ": " << e.what() << std::endl;
+        sources.erase(sourceIt);
+        return nullptr;
+    }
+
+    auto graph = graphs[name];
+    markMatched(*graph, source);
+    return graph;
+}
+
+std::vector<std::string> GraphModel::getGraphNames() const {
+    std::vector<std::string> names;
+    for (const auto& pair : graphs) {
+        names.push_back(pair.first);
+    }
+
+    // Graphs that are still only byte ranges in the source file
+    for (const auto& pair : sources) {
+        if (graphs.find(pair.first) == graphs.end()) {
+            names.push_back(pair.first);
+        }
+    }
+    return names;
+}
+
+bool GraphModel::hasGraph(const std::string& name) const {
+    return graphs.find(name) != graphs.end() || sources.find(name) != sources.end();
+}
+
+size_t GraphModel::getLoadedGraphCount() const {
+    return graphs.size();
+}
+
+bool GraphModel::getMemoryUsage(const std::string& name, GraphMemoryUsage& usage) const {
+    auto it = graphs.find(name);
+    if (it == graphs.end()) {
+        return false;
+    }
+    usage = it->second->getMemoryUsage();
+    return true;
+}
+
+void GraphModel::createGraph(const std::string& name) {
+    if (!getGraph(name)) {
+        graphs[name] = std::make_shared<Graph>(name);
+        removedGraphs.erase(name);
+    }
+}
+
+void GraphModel::removeGraph(const std::string& name) {
+    // Graphs that are in the saved file are remembered until the next save
+    auto sourceIt = sources.find(name);
+    if (sourceIt != sources.end()) {
+        GraphSource& source = sourceIt->second;
+        if (!source.hashed) {
+            source.hash = contentHash(source.text->data() + source.begin, source.end - source.begin);
+            source.hashed = true;
+        }
+        removedGraphs[name] = source.hash;
+    }
+    graphs.erase(name);
+    sources.erase(name);
+
+    // Links into or out of the removed graph go with it
+    auto it = std::remove_if(transfers.begin(), transfers.end(), [&name](const TransferLink& link) {
+        return link.fromGraph == name || link.toGraph == name;
+    });
+    if (it != transfers.end()) {
+        transfers.erase(it, transfers.end());
+        ++transferVersion;
+    }
+}
+
+void GraphModel::loadGraph(const std::string& graphName, const nlohmann::json& graphData) {
+    // Created directly: going through createGraph would materialize the same graph again
+    auto graph = std::make_shared<Graph>(graphName);
+    graphs[graphName] = graph;
+
+    // Loading is a merge into an empty graph
+    mergeGraph(*graph, nlohmann::json::object(), graphData);
+}
+
+size_t GraphModel::mergeGraph(Graph& graph, const nlohmann::json& oldData, const nlohmann::json& newData) {
+    PROFILE_SCOPE("GraphModel::mergeGraph");
+    GraphContent before = readGraphContent(oldData);
+    GraphContent after = readGraphContent(newData);
+    GraphBatch batch = graph.beginBatch();
+    size_t differences = 0;
+
+    // Only what changed between the two file versions is applied, so local edits to
+    // anything else survive
+    for (const auto& node : before.nodes) {
+        if (after.nodeIndex.find(node.id) == after.nodeIndex.end()) {
+            batch.removeNode(node.id);
+            ++differences;
+        }
+    }
+    for (const auto& edge : before.edges) {
+        if (after.edgeIndex.find(std::make_pair(edge.from, edge.to)) == after.edgeIndex.end()) {
+            batch.removeEdge(edge.from, edge.to);
+            ++differences;
+        }
+    }
+
+    for (const auto& node : after.nodes) {
+        auto oldIt = before.nodeIndex.find(node.id);
+        if (oldIt == before.nodeIndex.end()) {
+            if (node.hasPosition) {
+                batch.addNode(node.id, node.x, node.y);
+            }
+            else {
+                batch.addNode(node.id);
+            }
+            ++differences;
+        }
+        else {
+            const NodeRecord& old = before.nodes[oldIt->second];
+            bool moved = node.hasPosition && (!old.hasPosition || old.x != node.x || old.y != node.y);
+            if (moved && graph.findNode(node.id)) {
+                batch.addNode(node.id, node.x, node.y);
+                ++differences;
+            }
+        }
+    }
+
+    for (const auto& edge : after.edges) {
+        auto oldIt = before.edgeIndex.find(std::make_pair(edge.from, edge.to));
+        if (oldIt == before.edgeIndex.end()) {
+            batch.addEdge(edge.from, edge.to, edge.weight);
+            ++differences;
+        }
+        else if (before.edges[oldIt->second].weight != edge.weight) {
+            batch.setEdgeWeight(edge.from, edge.to, edge.weight);
+            ++differences;
+        }
+    }
+
+    batch.commit();
+
+    WeightModel oldModel = before.hasWeightModel ? before.weightModel : WeightModel();
+    WeightModel newModel = after.hasWeightModel ? after.weightModel : WeightModel();
+    if (!sameWeightModel(oldModel, newModel)) {
+        graph.setWeightModel(newModel);
+        ++differences;
+    }
+
+    return differences;
+}
+
+void GraphModel::loadTransfers(const nlohmann::json& transfersData) {
+    transfers.clear();
+    ++transferVersion;
+    if (!transfersData.is_array()) {
+        return;
+    }
+
+    // Node ids are not checked here so lazily loaded graphs stay unparsed
+    for (const auto& linkData : transfersData) {
+        if (!linkData.is_object()) {
+            continue;
+        }
+
+        TransferLink link;
+        link.fromGraph = linkData.value("fromGraph", std::string());
+        link.fromNode = linkData.value("fromNode", std::string());
+        link.toGraph = linkData.value("toGraph", std::string());
+        link.toNode = linkData.value("toNode", std::string());
+        link.cost = linkData.value("cost", 0.0f);
+        if (hasGraph(link.fromGraph) && hasGraph(link.toGraph) && link.fromGraph != link.toGraph) {
+            transfers.push_back(link);
+        }
+    }
+}
+
+nlohmann::json GraphModel::parseTransfers(const GraphFileIndex& index) const {
+    if (index.transfersEnd <= index.transfersBegin) {
+        return nlohmann::json::array();
+    }
+    return nlohmann::json::parse(index.text->begin() + index.transfersBegin, index.text->begin() + index.transfersEnd);
+}
+
+void GraphModel::clear() {
+    graphs.clear();
+    sources.clear();
+    transfers.clear();
+    transfersHash = 0;
+    ++transferVersion;
+    savedFile.clear();
+    savedCompact = false;
+    savedTransferVersion = transferVersion;
+    removedGraphs.clear();
+}
 
 // Modify the loadFromFile method in GraphModel.cpp to load node positions:
 
-bool GraphModel::loadFromFile(const std::string& filename) {
+bool GraphModel::loadFromFile(const std::string& filename, bool lazy) {
+    PROFILE_SCOPE("GraphModel::loadFromFile");
     try {
         // Clear existing data
-        graphs.clear();
+        clear();
 
-        // Open JSON file
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open file: " << filename << std::endl;
+        // Only the structure is scanned here; hashes are only needed once the file changes
+        GraphFileIndex index;
+        if (!GraphFileIndex::read(filename, index, false)) {
             return false;
         }
 
-        // Parse JSON
-        nlohmann::json jsonData;
-        file >> jsonData;
-        file.close();
+        for (const auto& entry : index.graphs) {
+            GraphSource source;
+            source.text = index.text;
+            source.begin = entry.begin;
+            source.end = entry.end;
+            source.hash = entry.hash;
+            source.hashed = index.hashed;
+            sources[entry.name] = source;
+        }
 
-        // Check if the JSON has the expected structure
-        if (!jsonData.contains("graphs") || !jsonData["graphs"].is_object()) {
-            std::cerr << "Invalid JSON structure: 'graphs' object not found" << std::endl;
-            return false;
+        // Optional inter-graph transfer links
+        loadTransfers(parseTransfers(index));
+        transfersHash = index.transfersHash;
+        savedFile = filename;
+        savedCompact = isCompactText(index.text->data(), index.text->size());
+        savedTransferVersion = transferVersion;
+
+        if (lazy) {
+            return true;
         }
 
-        // Process each graph
-        for (auto it = jsonData["graphs"].begin(); it != jsonData["graphs"].end(); ++it) {
-            std::string graphName = it.key();
-            auto& graphData = it.value();
+        // Eager load: graphs are independent, so each one is parsed and built on the pool.
+        // Largest first, so a big graph does not start last and hold up the whole load.
+        struct LoadResult {
+            std::shared_ptr<Graph> graph;
+            std::string error;
+        };
+        std::vector<LoadResult> results(index.graphs.size());
+        std::vector<size_t> order(index.graphs.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&index](size_t a, size_t b) {
+            return index.graphs[a].end - index.graphs[a].begin > index.graphs[b].end - index.graphs[b].begin;
+        });
 
-            createGraph(graphName);
-            auto graph = getGraph(graphName);
+        ThreadPool::shared().parallelFor(order.size(), [&](size_t k) {
+            const GraphFileIndex::Entry& entry = index.graphs[order[k]];
+            LoadResult& result = results[order[k]];
+            try {
+                nlohmann::json graphData = nlohmann::json::parse(
+                    index.text->begin() + entry.begin, index.text->begin() + entry.end);
+                auto graph = std::make_shared<Graph>(entry.name);
+                mergeGraph(*graph, nlohmann::json::object(), graphData);
+                result.graph = graph;
+            }
+            catch (const std::exception& e) {
+                result.error = e.what();
+            }
+        });
 
-            // Add nodes
-            if (graphData.contains("nodes")) {
-                // Check if nodes is an array of objects or just an array of strings
-                if (graphData["nodes"].is_array()) {
-                    if (graphData["nodes"].empty()) {
-                        // Empty array, nothing to do
-                    }
-                    else if (graphData["nodes"][0].is_string()) {
-                        // Old format: array of strings
-                        for (const auto& nodeId : graphData["nodes"]) {
-                            if (nodeId.is_string()) {
-                                graph->addNode(nodeId);
-                            }
-                        }
-                    }
-                    else if (graphData["nodes"][0].is_object()) {
-                        // New format: array of objects with position information
-                        for (const auto& nodeData : graphData["nodes"]) {
-                            if (nodeData.contains("id") && nodeData["id"].is_string()) {
-                                std::string nodeId = nodeData["id"];
-                                graph->addNode(nodeId);
-
-                                auto node = graph->findNode(nodeId);
-                                if (node) {
-                                    // Load position if available
-                                    if (nodeData.contains("x") && nodeData["x"].is_number()) {
-                                        node->x = nodeData["x"];
-                                    }
-                                    if (nodeData.contains("y") && nodeData["y"].is_number()) {
-                                        node->y = nodeData["y"];
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
+        // Inserted and reported in file order, independent of which worker finished first
+        bool complete = true;
+        for (size_t i = 0; i < results.size(); ++i) {
+            const std::string& graphName = index.graphs[i].name;
+            if (results[i].graph) {
+                graphs[graphName] = results[i].graph;
+                markMatched(*results[i].graph, sources[graphName]);
             }
+            else {
+                std::cerr << "Error loading graph " << graphName << ": " << results[i].error << std::endl;
+                sources.erase(graphName);
+                complete = false;
+            }
+        }
 
-            // Add edges
-            if (graphData.contains("edges") && graphData["edges"].is_array()) {
-                for (const auto& edgeData : graphData["edges"]) {
-                    if (edgeData.contains("from") && edgeData.contains("to") &&
-                        edgeData["from"].is_string() && edgeData["to"].is_string()) {
+        return complete;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error loading graph data: " << e.what() << std::endl;
+        clear();
+        return false;
+    }
+}
 
-                        float weight = 1.0f;
-                        if (edgeData.contains("weight") && edgeData["weight"].is_number()) {
-                            weight = edgeData["weight"];
-                        }
+size_t GraphModel::reloadChanged(const GraphFileIndex& index) {
+    PROFILE_SCOPE("GraphModel::reloadChanged");
+    size_t changedGraphs = 0;
+    std::unordered_map<std::string, GraphSource> oldSources;
+    oldSources.swap(sources);
+    std::vector<std::string> stillRemoved;
 
-                        graph->addEdge(edgeData["from"], edgeData["to"], weight);
-                    }
-                }
+    for (const auto& entry : index.graphs) {
+        GraphSource source;
+        source.text = index.text;
+        source.begin = entry.begin;
+        source.end = entry.end;
+        source.hash = entry.hash;
+        source.hashed = true;
+
+        // Removed locally: stays removed unless the file's content for it changed
+        auto removedIt = removedGraphs.find(entry.name);
+        if (removedIt != removedGraphs.end()) {
+            if (removedIt->second == entry.hash) {
+                stillRemoved.push_back(entry.name);
+                continue;
             }
+            removedGraphs.erase(removedIt);
         }
 
-        return true;
+        auto oldIt = oldSources.find(entry.name);
+        auto graphIt = graphs.find(entry.name);
+        bool known = oldIt != oldSources.end();
+
+        // Sources from a load are hashed on their first comparison
+        if (known && !oldIt->second.hashed) {
+            GraphSource& old = oldIt->second;
+            old.hash = contentHash(old.text->data() + old.begin, old.end - old.begin);
+            old.hashed = true;
+        }
+
+        // Same content hash: only the byte range may have moved
+        if (known && oldIt->second.hash == entry.hash) {
+            source.matched = oldIt->second.matched;
+            source.loadedVersion = oldIt->second.loadedVersion;
+            source.loadedHash = oldIt->second.loadedHash;
+            sources[entry.name] = source;
+            oldSources.erase(oldIt);
+            continue;
+        }
+
+        // Replaced locally (created, imported or generated under a file graph's name): the
+        // file's graph is not its base, so it is kept as is and stays unsaved
+        if (!known && graphIt != graphs.end()) {
+            std::cerr << "Graph " << entry.name << " in the file was replaced locally; keeping the local one" << std::endl;
+            sources[entry.name] = source;
+            continue;
+        }
+
+        ++changedGraphs;
+        if (graphIt == graphs.end()) {
+            // Not materialized yet: the new byte range is all there is to update
+            sources[entry.name] = source;
+            if (known) {
+                oldSources.erase(oldIt);
+            }
+            continue;
+        }
+
+        // Materialized: merge the difference between the old and new file content
+        Graph& graph = *graphIt->second;
+        bool clean = matchesSource(graph, oldIt->second);
+        try {
+            nlohmann::json oldData = nlohmann::json::object();
+            if (oldIt->second.text) {
+                const GraphSource& old = oldIt->second;
+                oldData = nlohmann::json::parse(old.text->begin() + old.begin, old.text->begin() + old.end);
+            }
+            nlohmann::json newData = nlohmann::json::parse(index.text->begin() + entry.begin, index.text->begin() + entry.end);
+            mergeGraph(graph, oldData, newData);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error reloading graph " << entry.name << ": " << e.what() << std::endl;
+            clean = false;
+        }
+
+        // A graph without local edits matches the new file again and can be written verbatim
+        if (clean) {
+            markMatched(graph, source);
+        }
+        sources[entry.name] = source;
+        oldSources.erase(oldIt);
     }
-    catch (const std::exception& e) {
-        std::cerr << "Error loading graph data: " << e.what() << std::endl;
+
+    // Graphs gone from the file are dropped unless they have local edits
+    for (const auto& pair : oldSources) {
+        auto graphIt = graphs.find(pair.first);
+        if (graphIt != graphs.end() && !matchesSource(*graphIt->second, pair.second)) {
+            std::cerr << "Graph " << pair.first << " was removed from the file but has local changes; keeping it" << std::endl;
+            continue;
+        }
+        graphs.erase(pair.first);
+        ++changedGraphs;
+    }
+
+    if (index.transfersHash != transfersHash) {
+        try {
+            loadTransfers(parseTransfers(index));
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error reloading transfers: " << e.what() << std::endl;
+        }
+        transfersHash = index.transfersHash;
+        savedTransferVersion = transferVersion;
+    }
+
+    // Graphs removed locally that the file no longer has either are in sync again
+    for (auto it = removedGraphs.begin(); it != removedGraphs.end();) {
+        if (std::find(stillRemoved.begin(), stillRemoved.end(), it->first) == stillRemoved.end()) {
+            it = removedGraphs.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    return changedGraphs;
+}
+
+bool GraphModel::addTransfer(const TransferLink& link) {
+    auto fromGraph = getGraph(link.fromGraph);
+    auto toGraph = getGraph(link.toGraph);
+    if (!fromGraph || !toGraph || !fromGraph->findNode(link.fromNode) || !toGraph->findNode(link.toNode)) {
+        std::cerr << "Invalid transfer: " << link.fromGraph << "/" << link.fromNode
+            << " -> " << link.toGraph << "/" << link.toNode << std::endl;
+        return false;
+    }
+    if (link.fromGraph == link.toGraph) {
+        std::cerr << "Transfer must connect two different graphs: " << link.fromGraph << std::endl;
+        return false;
+    }
+    if (link.cost < 0.0f) {
+        std::cerr << "Transfer cost must not be negative" << std::endl;
+        return false;
+    }
+
+    // One link per ordered pair of endpoints; re-adding updates the cost
+    for (auto& existing : transfers) {
+        if (existing.fromGraph == link.fromGraph && existing.fromNode == link.fromNode &&
+            existing.toGraph == link.toGraph && existing.toNode == link.toNode) {
+            existing.cost = link.cost;
+            ++transferVersion;
+            return true;
+        }
+    }
+
+    transfers.push_back(link);
+    ++transferVersion;
+    return true;
+}
+
+bool GraphModel::removeTransfer(size_t index) {
+    if (index >= transfers.size()) {
         return false;
     }
+    transfers.erase(transfers.begin() + index);
+    ++transferVersion;
+    return true;
+}
+
+void GraphModel::writeGraph(JsonWriter& writer, const Graph& graph) const {
+    PROFILE_SCOPE("GraphModel::writeGraph");
+    // Keys in sorted order, as the json object map kept them
+    writer.beginObject();
+
+    // Add edges
+    writer.key("edges");
+    writer.beginArray();
+    for (const auto& edge : graph.edges) {
+        writer.beginObject();
+        writer.key("from");
+        writer.value(edge->from);
+        writer.key("to");
+        writer.value(edge->to);
+        writer.key("weight");
+        writer.value(edge->weight);
+        writer.endObject();
+    }
+    writer.endArray();
+
+    // Add nodes with position information
+    writer.key("nodes");
+    writer.beginArray();
+    for (const auto& node : graph.nodes) {
+        writer.beginObject();
+        writer.key("id");
+        writer.value(node->id);
+        writer.key("x");
+        writer.value(node->x);
+        writer.key("y");
+        writer.value(node->y);
+        writer.endObject();
+    }
+    writer.endArray();
+
+    // Only non-manual weight models are written, so existing files keep their format
+    if (graph.weightModel.mode != WeightModel::Mode::Manual) {
+        writer.key("weightModel");
+        writer.beginObject();
+        writer.key("acceleration");
+        writer.value(graph.weightModel.acceleration);
+        writer.key("mode");
+        writer.value(graph.weightModel.mode == WeightModel::Mode::Distance ? "distance" : "moveTime");
+        writer.key("velocity");
+        writer.value(graph.weightModel.velocity);
+        writer.endObject();
+    }
+
+    writer.endObject();
 }
 
+void GraphModel::writeTransfers(JsonWriter& writer) const {
+    writer.beginArray();
+    for (const auto& link : transfers) {
+        writer.beginObject();
+        writer.key("cost");
+        writer.value(link.cost);
+        writer.key("fromGraph");
+        writer.value(link.fromGraph);
+        writer.key("fromNode");
+        writer.value(link.fromNode);
+        writer.key("toGraph");
+        writer.value(link.toGraph);
+        writer.key("toNode");
+        writer.value(link.toNode);
+        writer.endObject();
+    }
+    writer.endArray();
+}
 
 // Modify the saveToFile method in GraphModel.cpp to include node positions:
 
-bool GraphModel::saveToFile(const std::string& filename) {
+bool GraphModel::saveToFile(const std::string& filename, bool compact) {
+    PROFILE_SCOPE("GraphModel::saveToFile");
     try {
-        nlohmann::json jsonData;
-        jsonData["graphs"] = nlohmann::json::object();
+        // Nothing changed since this file was last loaded or written in this format
+        if (filename == savedFile && compact == savedCompact && !isDirty() && std::ifstream(filename).good()) {
+            return true;
+        }
+
+        // Written next to the target and moved over it, so a failed save keeps the last one
+        std::string tempFile = filename + ".tmp";
+        std::ofstream file(tempFile);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open file for writing: " << tempFile << std::endl;
+            return false;
+        }
+
+        // Graphs are streamed in name order; those untouched since they were read are copied
+        // from their source text when it is in the requested format, the rest are serialized
+        // from the model
+        std::vector<std::string> names = getGraphNames();
+        std::sort(names.begin(), names.end());
 
-        // Convert graphs to JSON
-        for (auto it = graphs.begin(); it != graphs.end(); ++it) {
-            const std::string& graphName = it->first;
-            const auto& graph = it->second;
+        std::unordered_map<std::string, GraphSource> written;
+        uint64_t writtenTransfersHash = contentHash(nullptr, 0);
+        {
+            JsonWriter writer(file, !compact);
+            writer.beginObject();
+            writer.key("graphs");
+            writer.beginObject();
+
+            for (const auto& graphName : names) {
+                auto sourceIt = sources.find(graphName);
+                auto graphIt = graphs.find(graphName);
+                bool untouched = sourceIt != sources.end() && sourceIt->second.text &&
+                    (graphIt == graphs.end() || matchesSource(*graphIt->second, sourceIt->second)) &&
+                    isCompactText(sourceIt->second.text->data() + sourceIt->second.begin,
+                        sourceIt->second.end - sourceIt->second.begin) == compact;
+                if (!untouched && graphIt == graphs.end()) {
+                    // Changing the format of a graph that was never parsed
+                    if (!getGraph(graphName)) {
+                        continue;
+                    }
+                    sourceIt = sources.find(graphName);
+                    graphIt = graphs.find(graphName);
+                }
+                writer.key(graphName);
 
-            nlohmann::json graphJson;
+                GraphSource source;
+                writer.beginHash();
+                if (untouched) {
+                    source = sourceIt->second;
+                    writer.rawValue(source.text->data() + source.begin, source.end - source.begin);
+                }
+                else {
+                    // Keep the written text of changed graphs as the base for verbatim saves and reload
+                    auto text = std::make_shared<std::string>();
+                    writer.setCapture(text.get());
+                    writeGraph(writer, *graphIt->second);
+                    writer.setCapture(nullptr);
 
-            // Add nodes with position information
-            graphJson["nodes"] = nlohmann::json::array();
-            for (const auto& node : graph->nodes) {
-                nlohmann::json nodeJson;
-                nodeJson["id"] = node->id;
-                nodeJson["x"] = node->x;
-                nodeJson["y"] = node->y;
-                graphJson["nodes"].push_back(nodeJson);
+                    source.text = text;
+                    source.begin = 0;
+                    source.end = text->size();
+                    markMatched(*graphIt->second, source);
+                }
+                source.hash = writer.endHash();
+                source.hashed = true;
+                written[graphName] = source;
             }
+            writer.endObject();
 
-            // Add edges
-            graphJson["edges"] = nlohmann::json::array();
-            for (const auto& edge : graph->edges) {
-                nlohmann::json edgeJson;
-                edgeJson["from"] = edge->from;
-                edgeJson["to"] = edge->to;
-                edgeJson["weight"] = edge->weight;
-                graphJson["edges"].push_back(edgeJson);
+            // Only written when present, so files without links keep their format
+            if (!transfers.empty()) {
+                writer.key("transfers");
+                writer.beginHash();
+                writeTransfers(writer);
+                writtenTransfersHash = writer.endHash();
             }
 
-            jsonData["graphs"][graphName] = graphJson;
+            writer.endObject();
+            writer.flush();
         }
 
-        // Write to file
-        std::ofstream file(filename);
-        if (!file.is_open()) {
-            std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        if (!file.good()) {
+            std::cerr << "Failed to write file: " << tempFile << std::endl;
             return false;
         }
-
-        file << jsonData.dump(2); // Pretty print with 2 spaces
         file.close();
 
+        // rename() does not replace an existing file everywhere
+        std::remove(filename.c_str());
+        if (std::rename(tempFile.c_str(), filename.c_str()) != 0) {
+            std::cerr << "Failed to replace file: " << filename << std::endl;
+            return false;
+        }
+
+        // The written content becomes the base for the next save and hot reload
+        sources.swap(written);
+        transfersHash = writtenTransfersHash;
+        savedFile = filename;
+        savedCompact = compact;
+        savedTransferVersion = transferVersion;
+        removedGraphs.clear();
         return true;
     }
     catch (const std::exception& e) {
         std::cerr << "Error saving graph data: " << e.what() << std::endl;
         return false;
     }
-}
\ No newline at end of file
+}
+
+bool GraphModel::isDirty(const std::string& name) const {
+    auto graphIt = graphs.find(name);
+    if (graphIt == graphs.end()) {
+        // Still only in the source text, or not there at all
+        return false;
+    }
+    auto sourceIt = sources.find(name);
+    return sourceIt == sources.end() || !matchesSource(*graphIt->second, sourceIt->second);
+}
+
+bool GraphModel::isDirty() const {
+    if (transferVersion != savedTransferVersion || !removedGraphs.empty()) {
+        return true;
+    }
+    for (const auto& pair : graphs) {
+        if (isDirty(pair.first)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<std::string> GraphModel::getDirtyGraphNames() const {
+    std::vector<std::string> names;
+    for (const auto& pair : graphs) {
+        if (isDirty(pair.first)) {
+            names.push_back(pair.first);
+        }
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+uint64_t GraphModel::recoveryDigest(const std::vector<std::string>& changed) const {
+    // Names and content hashes of what a recovery file would hold, hashed together
+    std::string key;
+    for (const auto& name : changed) {
+        uint64_t hash = graphs.at(name)->stateHash;
+        key.append(name).push_back('\0');
+        key.append(reinterpret_cast<const char*>(&hash), sizeof(hash));
+    }
+    std::vector<std::string> removed;
+    for (const auto& pair : removedGraphs) {
+        removed.push_back(pair.first);
+    }
+    std::sort(removed.begin(), removed.end());
+    for (const auto& name : removed) {
+        key.append("-").append(name).push_back('\0');
+    }
+    if (transferVersion != savedTransferVersion) {
+        key.append(reinterpret_cast<const char*>(&transferVersion), sizeof(transferVersion));
+    }
+    return contentHash(key.data(), key.size());
+}
+
+bool GraphModel::saveRecovery(const std::string& filename) {
+    PROFILE_SCOPE("GraphModel::saveRecovery");
+    std::vector<std::string> changed = getDirtyGraphNames();
+    bool transfersChanged = transferVersion != savedTransferVersion;
+
+    // Everything is saved: an old recovery file would only undo that on the next start
+    if (changed.empty() && removedGraphs.empty() && !transfersChanged) {
+        if (writtenRecovery != 0 || std::ifstream(filename).good()) {
+            std::remove(filename.c_str());
+        }
+        writtenRecovery = 0;
+        return true;
+    }
+
+    uint64_t digest = recoveryDigest(changed);
+    if (digest == writtenRecovery) {
+        return true;
+    }
+
+    // Written next to the target and moved over it, so a crash mid-write keeps the last one
+    std::string tempFile = filename + ".tmp";
+    try {
+        std::ofstream file(tempFile);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open file for writing: " << tempFile << std::endl;
+            return false;
+        }
+
+        JsonWriter writer(file, false);
+        writer.beginObject();
+        writer.key("graphs");
+        writer.beginObject();
+        for (const auto& name : changed) {
+            writer.key(name);
+            writeGraph(writer, *graphs.at(name));
+        }
+        writer.endObject();
+
+        std::vector<std::string> removed;
+        for (const auto& pair : removedGraphs) {
+            removed.push_back(pair.first);
+        }
+        std::sort(removed.begin(), removed.end());
+        writer.key("removed");
+        writer.beginArray();
+        for (const auto& name : removed) {
+            writer.value(name);
+        }
+        writer.endArray();
+
+        if (transfersChanged) {
+            writer.key("transfers");
+            writeTransfers(writer);
+        }
+        writer.endObject();
+        writer.flush();
+
+        if (!file.good()) {
+            std::cerr << "Failed to write file: " << tempFile << std::endl;
+            return false;
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error saving recovery data: " << e.what() << std::endl;
+        return false;
+    }
+
+    // rename() does not replace an existing file everywhere
+    std::remove(filename.c_str());
+    if (std::rename(tempFile.c_str(), filename.c_str()) != 0) {
+        std::cerr << "Failed to replace recovery file: " << filename << std::endl;
+        return false;
+    }
+    writtenRecovery = digest;
+    return true;
+}
+
+size_t GraphModel::loadRecovery(const std::string& filename) {
+    PROFILE_SCOPE("GraphModel::loadRecovery");
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        return 0;
+    }
+
+    size_t restored = 0;
+    try {
+        nlohmann::json data = nlohmann::json::parse(file);
+
+        if (data.contains("removed")) {
+            for (const auto& name : data["removed"]) {
+                if (hasGraph(name.get<std::string>())) {
+                    removeGraph(name.get<std::string>());
+                    ++restored;
+                }
+            }
+        }
+
+        if (data.contains("graphs")) {
+            for (const auto& item : data["graphs"].items()) {
+                // Applied as the difference to the file version, so the graph object and
+                // its source stay, and the graph shows as changed against the file
+                auto graph = getGraph(item.key());
+                auto sourceIt = sources.find(item.key());
+                if (graph && sourceIt != sources.end() && sourceIt->second.text) {
+                    const GraphSource& source = sourceIt->second;
+                    nlohmann::json fileData = nlohmann::json::parse(
+                        source.text->begin() + source.begin, source.text->begin() + source.end);
+                    mergeGraph(*graph, fileData, item.value());
+                }
+                else {
+                    sources.erase(item.key());
+                    loadGraph(item.key(), item.value());
+                }
+                ++restored;
+            }
+        }
+
+        if (data.contains("transfers")) {
+            loadTransfers(data["transfers"]);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error loading recovery data " << filename << ": " << e.what() << std::endl;
+    }
+
+    // What was restored is exactly what the file holds already
+    writtenRecovery = restored > 0 ? recoveryDigest(getDirtyGraphNames()) : 0;
+    return restored;
+}
+
+namespace {
+
+const size_t CSV_CHUNK_SIZE = 1 << 20;     // bytes of rows parsed per task
+
+struct NodeRow {
+    std::string_view id;
+    float x;
+    float y;
+};
+
+struct EdgeRow {
+    std::string_view from;
+    std::string_view to;
+    float weight;
+};
+
+// Rows of one chunk, and the line (counted from 1 within the chunk) of the first bad row
+template <typename Row>
+struct CsvChunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    std::vector<Row> rows;
+    size_t lines = 0;
+    size_t errorLine = 0;
+};
+
+// Linear-probing table sized once for the rows of an import, so filling it allocates nothing.
+// Entries are 64-bit values the caller packs (a key, or a hash and a slot); empty ones are
+// UINT64_MAX, which no packed value can be.
+class ImportTable {
+public:
+    static constexpr uint64_t EMPTY = UINT64_MAX;
+
+    explicit ImportTable(size_t count) {
+        size_t capacity = 16;
+        while (capacity < count * 2) {
+            capacity <<= 1;
+        }
+        entries.assign(capacity, EMPTY);
+        mask = capacity - 1;
+    }
+
+    // Index of the entry 'matches' accepts in the probe sequence of hash, or of the empty
+    // entry that ends it
+    template <typename Matches>
+    size_t probe(uint64_t hash, Matches matches) const {
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            if (entries[i] == EMPTY || matches(entries[i])) {
+                return i;
+            }
+        }
+    }
+
+    uint64_t& operator[](size_t index) { return entries[index]; }
+    uint64_t operator[](size_t index) const { return entries[index]; }
+
+private:
+    std::vector<uint64_t> entries;
+    size_t mask = 0;
+};
+
+// Splits the next field off a row; cursor becomes null after the last one. Surrounding
+// blanks and one pair of double quotes are dropped.
+bool nextField(const char*& cursor, const char* end, std::string_view& field) {
+    if (!cursor) {
+        return false;
+    }
+    const char* comma = static_cast<const char*>(std::memchr(cursor, ',', end - cursor));
+    const char* begin = cursor;
+    const char* fieldEnd = comma ? comma : end;
+    cursor = comma ? comma + 1 : nullptr;
+
+    while (begin < fieldEnd && (*begin == ' ' || *begin == '\t')) {
+        ++begin;
+    }
+    while (fieldEnd > begin && (fieldEnd[-1] == ' ' || fieldEnd[-1] == '\t')) {
+        --fieldEnd;
+    }
+    if (fieldEnd - begin >= 2 && *begin == '"' && fieldEnd[-1] == '"') {
+        ++begin;
+        --fieldEnd;
+    }
+    field = std::string_view(begin, static_cast<size_t>(fieldEnd - begin));
+    return true;
+}
+
+bool parseNumber(std::string_view field, float& value) {
+    const char* begin = field.data();
+    const char* end = begin + field.size();
+    if (begin != end && *begin == '+') {
+        ++begin;
+    }
+    auto result = std::from_chars(begin, end, value);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+bool parseNodeRow(const char* begin, const char* end, NodeRow& row) {
+    std::string_view x, y;
+    return nextField(begin, end, row.id) && !row.id.empty() &&
+        nextField(begin, end, x) && parseNumber(x, row.x) &&
+        nextField(begin, end, y) && parseNumber(y, row.y);
+}
+
+bool parseEdgeRow(const char* begin, const char* end, EdgeRow& row) {
+    std::string_view weight;
+    if (!nextField(begin, end, row.from) || row.from.empty() || !nextField(begin, end, row.to) || row.to.empty()) {
+        return false;
+    }
+    row.weight = 1.0f;
+    return !nextField(begin, end, weight) || parseNumber(weight, row.weight);
+}
+
+// A node header names all three columns and has no number where x and y go
+bool isNodeHeader(const char* begin, const char* end) {
+    std::string_view id, x, y;
+    float value;
+    return nextField(begin, end, id) && !id.empty() && nextField(begin, end, x) && nextField(begin, end, y) &&
+        !x.empty() && !y.empty() && !parseNumber(x, value) && !parseNumber(y, value);
+}
+
+// "from,to" has no number to fail on, so it would pass for an edge
+bool isEdgeHeader(const char* begin, const char* end) {
+    std::string_view from, to;
+    return nextField(begin, end, from) && nextField(begin, end, to) && from == "from" && to == "to";
+}
+
+// Cuts the file into chunks of about CSV_CHUNK_SIZE that end after a newline
+template <typename Row>
+std::vector<CsvChunk<Row>> splitChunks(const MappedFile& file) {
+    std::vector<CsvChunk<Row>> chunks;
+    const char* cursor = file.data();
+    const char* end = cursor + file.size();
+    while (cursor < end) {
+        const char* chunkEnd = end;
+        if (static_cast<size_t>(end - cursor) > CSV_CHUNK_SIZE) {
+            const char* newline = static_cast<const char*>(
+                std::memchr(cursor + CSV_CHUNK_SIZE, '\n', end - cursor - CSV_CHUNK_SIZE));
+            chunkEnd = newline ? newline + 1 : end;
+        }
+        CsvChunk<Row> chunk;
+        chunk.begin = cursor;
+        chunk.end = chunkEnd;
+        chunks.push_back(std::move(chunk));
+        cursor = chunkEnd;
+    }
+    return chunks;
+}
+
+// Parses every row of a chunk; blank lines are skipped and parsing stops at the first bad row
+template <typename Row, typename Parse, typename IsHeader>
+void parseChunk(CsvChunk<Row>& chunk, bool firstChunk, Parse parse, IsHeader isHeader) {
+    // Rows are at least a few bytes each; the estimate saves most reallocations
+    chunk.rows.reserve(static_cast<size_t>(chunk.end - chunk.begin) / 16);
+    const char* cursor = chunk.begin;
+    while (cursor < chunk.end) {
+        const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', chunk.end - cursor));
+        const char* lineEnd = newline ? newline : chunk.end;
+        const char* next = newline ? newline + 1 : chunk.end;
+        ++chunk.lines;
+        if (lineEnd > cursor && lineEnd[-1] == '\r') {
+            --lineEnd;
+        }
+
+        // Only a first line that looks like a header is skipped; any other bad line is an error
+        Row row;
+        bool firstLine = firstChunk && chunk.lines == 1;
+        if (lineEnd > cursor && !(firstLine && isHeader(cursor, lineEnd))) {
+            if (!parse(cursor, lineEnd, row)) {
+                chunk.errorLine = chunk.lines;
+                return;
+            }
+            chunk.rows.push_back(row);
+        }
+        cursor = next;
+    }
+}
+
+// Parses a mapped file in chunks on the thread pool; false with a message on the first bad row
+template <typename Row, typename Parse, typename IsHeader>
+bool parseCsvFile(const std::string& filename, const MappedFile& file, Parse parse, IsHeader isHeader,
+    const char* expected, std::vector<CsvChunk<Row>>& chunks) {
+    chunks = splitChunks<Row>(file);
+    ThreadPool::shared().parallelFor(chunks.size(), [&](size_t i) {
+        parseChunk(chunks[i], i == 0, parse, isHeader);
+    });
+
+    size_t line = 0;
+    for (const auto& chunk : chunks) {
+        if (chunk.errorLine > 0) {
+            std::cerr << filename << ":" << line + chunk.errorLine << ": expected " << expected << std::endl;
+            return false;
+        }
+        line += chunk.lines;
+    }
+    return true;
+}
+
+} // namespace
+
+bool GraphModel::importCsv(const std::string& graphName, const std::string& nodesFile, const std::string& edgesFile) {
+    PROFILE_SCOPE("GraphModel::importCsv");
+    MappedFile nodesData;
+    MappedFile edgesData;
+    if (!nodesData.open(nodesFile) || (!edgesFile.empty() && !edgesData.open(edgesFile))) {
+        return false;
+    }
+
+    std::vector<CsvChunk<NodeRow>> nodeChunks;
+    std::vector<CsvChunk<EdgeRow>> edgeChunks;
+    if (!parseCsvFile(nodesFile, nodesData, parseNodeRow, isNodeHeader, "id,x,y", nodeChunks) ||
+        !parseCsvFile(edgesFile, edgesData, parseEdgeRow, isEdgeHeader, "from,to[,weight]", edgeChunks)) {
+        return false;
+    }
+
+    // Slots in order of first appearance; a repeated id moves the node. Ids stay in the
+    // mapped file: the table holds the upper half of an id's hash and its slot.
+    size_t nodeRowCount = 0;
+    for (const auto& chunk : nodeChunks) {
+        nodeRowCount += chunk.rows.size();
+    }
+    std::vector<const NodeRow*> nodeRows;
+    nodeRows.reserve(nodeRowCount);
+    ImportTable slots(nodeRowCount);
+    std::hash<std::string_view> hashId;
+    auto findSlot = [&](std::string_view id, uint64_t hash) {
+        return slots.probe(hash, [&](uint64_t entry) {
+            return (entry >> 32) == (hash >> 32) && nodeRows[entry & 0xffffffffu]->id == id;
+        });
+    };
+    for (const auto& chunk : nodeChunks) {
+        for (const auto& row : chunk.rows) {
+            uint64_t hash = hashId(row.id);
+            size_t index = findSlot(row.id, hash);
+            if (slots[index] == ImportTable::EMPTY) {
+                slots[index] = (hash >> 32) << 32 | nodeRows.size();
+                nodeRows.push_back(&row);
+            }
+            else {
+                nodeRows[slots[index] & 0xffffffffu] = &row;
+            }
+        }
+    }
+
+    // Endpoint slots of every edge row, looked up in parallel; EMPTY for an unknown node
+    std::vector<std::vector<uint64_t>> edgeKeys(edgeChunks.size());
+    ThreadPool::shared().parallelFor(edgeChunks.size(), [&](size_t i) {
+        edgeKeys[i].reserve(edgeChunks[i].rows.size());
+        for (const auto& row : edgeChunks[i].rows) {
+            uint64_t from = slots[findSlot(row.from, hashId(row.from))];
+            uint64_t to = slots[findSlot(row.to, hashId(row.to))];
+            edgeKeys[i].push_back(from == ImportTable::EMPTY || to == ImportTable::EMPTY ? ImportTable::EMPTY
+                : (from & 0xffffffffu) << 32 | (to & 0xffffffffu));
+        }
+    });
+
+    // The first row of each (from, to) pair wins
+    size_t edgeRowCount = 0;
+    for (const auto& keys : edgeKeys) {
+        edgeRowCount += keys.size();
+    }
+    ImportTable seen(edgeRowCount);
+    std::vector<std::pair<uint64_t, float>> edgeList;
+    edgeList.reserve(edgeRowCount);
+    size_t skipped = 0;
+    for (size_t i = 0; i < edgeChunks.size(); ++i) {
+        for (size_t j = 0; j < edgeKeys[i].size(); ++j) {
+            uint64_t key = edgeKeys[i][j];
+            if (key == ImportTable::EMPTY) {
+                ++skipped;
+                continue;
+            }
+            size_t index = seen.probe(mixHash(key), [key](uint64_t entry) { return entry == key; });
+            if (seen[index] == ImportTable::EMPTY) {
+                seen[index] = key;
+                edgeList.emplace_back(key, edgeChunks[i].rows[j].weight);
+            }
+        }
+    }
+    if (skipped > 0) {
+        std::cerr << "Skipped " << skipped << " edge(s) with an unknown node in " << edgesFile << std::endl;
+    }
+
+    // Built directly: the rows are already unique, so there is nothing for a batch to check
+    auto graph = std::make_shared<Graph>(graphName);
+    graph->nodes.reserve(nodeRows.size());
+    for (const NodeRow* row : nodeRows) {
+        auto node = graph->makeNode(std::string(row->id));
+        node->x = row->x;
+        node->y = row->y;
+        graph->nodes.push_back(std::move(node));
+    }
+    graph->edges.reserve(edgeList.size());
+    for (const auto& edge : edgeList) {
+        const std::string& from = graph->nodes[edge.first >> 32]->id;
+        const std::string& to = graph->nodes[edge.first & 0xffffffffu]->id;
+        graph->edges.push_back(graph->makeEdge(from, to, edge.second));
+    }
+    graph->rebuildIndex();
+    graph->notifyChange(GraphChange::Reset);
+
+    // A new graph as far as saving goes, even if the file has one of the same name
+    graphs[graphName] = graph;
+    sources.erase(graphName);
+    removedGraphs.erase(graphName);
+    return true;
+}
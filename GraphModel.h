@@ -1,11 +1,15 @@
 #pragma once
 
 #include <string>
+#include <utility>
+#include <algorithm>
 #include <vector>
 #include <unordered_map>
 #include <memory>
 #include <functional>
+#include <cstdint>
 #include <nlohmann/json.hpp>
+#include "GraphArena.h"
 
 // Forward declarations
 struct Node;
@@ -38,82 +42,338 @@ struct Edge {
     }
 };
 
+// Hash for (from, to) edge keys
+struct EdgeKeyHash {
+    size_t operator()(const std::pair<std::string, std::string>& key) const {
+        size_t h = std::hash<std::string>()(key.first);
+        return h ^ (std::hash<std::string>()(key.second) + 0x9e3779b9 + (h << 6) + (h >> 2));
+    }
+};
+
+// Kinds of mutation reported to Graph change listeners
+enum class GraphChange {
+    NodeAdded,
+    NodeRemoved,    // incident edges are removed together with the node
+    EdgeAdded,
+    EdgeRemoved,
+    NodeMoved,      // position change (empty id: several nodes, written directly); incident weights may have changed
+    WeightsChanged, // all edge weights were recomputed
+    Reset           // bulk change (GraphBatch commit), listeners should rebuild
+};
+
+// How edge weights are derived from the node geometry
+struct WeightModel {
+    enum class Mode {
+        Manual,     // weights are edited by hand
+        Distance,   // Euclidean distance between the endpoints
+        MoveTime    // per-axis trapezoidal move time, axes moving simultaneously
+    };
+
+    Mode mode = Mode::Manual;
+    float velocity = 200.0f;        // max axis velocity, units/s
+    float acceleration = 1000.0f;   // axis acceleration and deceleration, units/s^2
+};
+
+// Compute edge costs for 'count' endpoint deltas in one branch-free pass
+void computeEdgeCosts(const WeightModel& model, const float* dx, const float* dy, float* out, size_t count);
+
+// Change listener: node changes pass the node id in 'a', edge changes pass from/to in 'a'/'b'
+using GraphListener = std::function<void(GraphChange change, const std::string& a, const std::string& b)>;
+
+// Approximate memory held by one graph
+struct GraphMemoryUsage {
+    size_t arenaBytes = 0;      // arena blocks: nodes, edges and index entries
+    size_t arenaUsedBytes = 0;  // of those, in live objects (the rest is recycled or unused)
+    size_t tableBytes = 0;      // node/edge vectors, hash buckets and the geometry index
+    size_t stringBytes = 0;     // heap buffers of ids too long for the inline string buffer
+    size_t nodeCount = 0;
+    size_t edgeCount = 0;
+
+    size_t total() const { return arenaBytes + tableBytes + stringBytes; }
+};
+
+class GraphBatch;
+class RouteCache;
+class JsonWriter;
+
 // Data structure for a graph
 struct Graph {
+    using NodeIndex = std::unordered_map<std::string, size_t, std::hash<std::string>, std::equal_to<std::string>,
+        ArenaAllocator<std::pair<const std::string, size_t>>>;
+    using EdgeIndex = std::unordered_map<std::pair<std::string, std::string>, size_t, EdgeKeyHash,
+        std::equal_to<std::pair<std::string, std::string>>,
+        ArenaAllocator<std::pair<const std::pair<std::string, std::string>, size_t>>>;
+
     std::string name;
+
+    // Storage of the nodes, edges and index entries below, released in one go with the graph
+    std::shared_ptr<GraphArena> arena;
+
     std::vector<std::shared_ptr<Node>> nodes;
     std::vector<std::shared_ptr<Edge>> edges;
 
-    Graph(const std::string& graphName) : name(graphName) {}
+    // Lookup indexes: id -> slot in nodes, (from, to) -> slot in edges.
+    // Maintained by the mutation methods below; GraphBatch rebuilds them once on commit.
+    NodeIndex nodeIndex;
+    EdgeIndex edgeIndex;
+
+    // Bumped on every mutation / on every change to the node or edge set
+    uint64_t version = 0;
+    uint64_t topologyVersion = 0;
+
+    // Content hash: the sum of per-node, per-edge and weight model hashes, so it returns to
+    // the same value when an edit is undone. Single edits update it in O(1) (O(degree) for a
+    // move with derived weights); bulk changes recompute it. Node and edge order is not part
+    // of it.
+    uint64_t stateHash = 0;
+
+    // Edge weight derivation; Manual leaves weights alone
+    WeightModel weightModel;
+
+    // Route query cache (GraphRouting.h), created on first query
+    std::shared_ptr<RouteCache> routeCache;
+
+    Graph(const std::string& graphName)
+        : name(graphName), arena(std::make_shared<GraphArena>()),
+        nodeIndex(NodeIndex::allocator_type(arena)), edgeIndex(EdgeIndex::allocator_type(arena)) {
+        rehash();
+    }
+
+    // The arena's blocks go once the last node or edge is released, without recycling each
+    ~Graph() {
+        arena->release();
+    }
+
+    Graph(const Graph&) = delete;
+    Graph& operator=(const Graph&) = delete;
+
+    // Nodes and edges are allocated from the graph's arena
+    std::shared_ptr<Node> makeNode(const std::string& id) const {
+        return std::allocate_shared<Node>(ArenaAllocator<Node>(arena), id);
+    }
+    std::shared_ptr<Edge> makeEdge(const std::string& from, const std::string& to, float weight) const {
+        return std::allocate_shared<Edge>(ArenaAllocator<Edge>(arena), from, to, weight);
+    }
+
+    GraphMemoryUsage getMemoryUsage() const;
 
     std::shared_ptr<Node> findNode(const std::string& id) {
-        for (auto& node : nodes) {
-            if (node->id == id) {
-                return node;
-            }
+        auto it = nodeIndex.find(id);
+        if (it != nodeIndex.end()) {
+            return nodes[it->second];
         }
         return nullptr;
     }
 
     std::shared_ptr<Edge> findEdge(const std::string& from, const std::string& to) {
-        for (auto& edge : edges) {
-            if (edge->from == from && edge->to == to) {
-                return edge;
-            }
+        auto it = edgeIndex.find(std::make_pair(from, to));
+        if (it != edgeIndex.end()) {
+            return edges[it->second];
         }
         return nullptr;
     }
 
     void addNode(const std::string& id) {
-        if (!findNode(id)) {
-            nodes.push_back(std::make_shared<Node>(id));
+        if (nodeIndex.emplace(id, nodes.size()).second) {
+            nodes.push_back(makeNode(id));
+            stateHash += hashNode(*nodes.back());
+            notifyChange(GraphChange::NodeAdded, id);
         }
     }
 
     void removeNode(const std::string& id) {
+        if (nodeIndex.find(id) == nodeIndex.end()) {
+            return;
+        }
+
         // First remove all edges associated with this node
-        auto edgeIt = edges.begin();
-        while (edgeIt != edges.end()) {
-            if ((*edgeIt)->from == id || (*edgeIt)->to == id) {
-                edgeIt = edges.erase(edgeIt);
-            }
-            else {
-                ++edgeIt;
+        edges.erase(std::remove_if(edges.begin(), edges.end(),
+            [this, &id](const std::shared_ptr<Edge>& e) {
+            if (e->from != id && e->to != id) {
+                return false;
             }
-        }
+            stateHash -= hashEdge(*e);
+            return true;
+        }), edges.end());
 
         // Then remove the node
-        auto nodeIt = std::find_if(nodes.begin(), nodes.end(),
-            [&id](const std::shared_ptr<Node>& n) { return n->id == id; });
-        if (nodeIt != nodes.end()) {
-            nodes.erase(nodeIt);
-        }
+        stateHash -= hashNode(*nodes[nodeIndex[id]]);
+        nodes.erase(std::remove_if(nodes.begin(), nodes.end(),
+            [&id](const std::shared_ptr<Node>& n) { return n->id == id; }),
+            nodes.end());
+
+        rebuildIndex();
+        notifyChange(GraphChange::NodeRemoved, id);
     }
 
     void addEdge(const std::string& from, const std::string& to, float weight = 1.0f) {
         // Make sure both nodes exist
-        if (!findNode(from) || !findNode(to)) {
+        if (nodeIndex.find(from) == nodeIndex.end() || nodeIndex.find(to) == nodeIndex.end()) {
             return;
         }
 
-        // Check if edge already exists
-        if (!findEdge(from, to)) {
-            edges.push_back(std::make_shared<Edge>(from, to, weight));
+        // Only add the edge if it does not exist yet
+        if (edgeIndex.emplace(std::make_pair(from, to), edges.size()).second) {
+            if (weightModel.mode != WeightModel::Mode::Manual) {
+                weight = deriveWeight(*nodes[nodeIndex[from]], *nodes[nodeIndex[to]]);
+            }
+            edges.push_back(makeEdge(from, to, weight));
+            stateHash += hashEdge(*edges.back());
+            notifyChange(GraphChange::EdgeAdded, from, to);
         }
     }
 
     void removeEdge(const std::string& from, const std::string& to) {
-        auto it = std::find_if(edges.begin(), edges.end(),
-            [&from, &to](const std::shared_ptr<Edge>& e) {
-            return e->from == from && e->to == to;
-        });
-        if (it != edges.end()) {
-            edges.erase(it);
+        auto it = edgeIndex.find(std::make_pair(from, to));
+        if (it == edgeIndex.end()) {
+            return;
         }
+
+        stateHash -= hashEdge(*edges[it->second]);
+        edges.erase(edges.begin() + it->second);
+        rebuildIndex();
+        notifyChange(GraphChange::EdgeRemoved, from, to);
     }
 
+    // Move a node; with a derived weight model only the incident edges are re-weighted
+    void setNodePosition(const std::string& id, float x, float y);
+
+    // Offset the nodes at the given slots by (dx, dy) in one pass; with a derived weight model
+    // only the edges between a moved and an unmoved node are re-weighted
+    void moveNodes(const std::vector<uint32_t>& slots, float dx, float dy);
+
+    // Switch the weight model and re-weight every edge if it is not Manual
+    void setWeightModel(const WeightModel& model);
+
+    // Re-weight all edges from the current geometry in one vectorizable pass
+    void recomputeWeights();
+
+    // Weight of an edge between two nodes under the current model
+    float deriveWeight(const Node& from, const Node& to) const;
+
+    // Start a batch of mutations that is applied in one pass on commit()
+    GraphBatch beginBatch();
+
+    // Rebuild nodeIndex/edgeIndex from the node and edge vectors
+    void rebuildIndex();
 
+    // Recompute stateHash from scratch
+    void rehash();
+    static uint64_t hashNode(const Node& node);
+    static uint64_t hashEdge(const Edge& edge);
 
+    // Change listeners, called after the mutation has been applied
+    size_t addListener(GraphListener listener) {
+        listeners.emplace_back(++nextListenerId, std::move(listener));
+        return nextListenerId;
+    }
+
+    void removeListener(size_t listenerId) {
+        listeners.erase(std::remove_if(listeners.begin(), listeners.end(),
+            [listenerId](const std::pair<size_t, GraphListener>& l) { return l.first == listenerId; }),
+            listeners.end());
+    }
+
+    void notifyChange(GraphChange change, const std::string& a = std::string(), const std::string& b = std::string()) {
+        ++version;
+        if (change == GraphChange::Reset || change == GraphChange::WeightsChanged ||
+            (change == GraphChange::NodeMoved && a.empty())) {
+            rehash();
+        }
+        if (change != GraphChange::NodeMoved && change != GraphChange::WeightsChanged) {
+            ++topologyVersion;
+        }
+        for (auto& listener : listeners) {
+            listener.second(change, a, b);
+        }
+    }
+
+    std::vector<std::pair<size_t, GraphListener>> listeners;
+    size_t nextListenerId = 0;
+
+    // Endpoint slots per edge and incident edges per node, rebuilt lazily when the topology changes
+    void updateGeometryIndex();
+    std::vector<uint32_t> edgeFromSlot;
+    std::vector<uint32_t> edgeToSlot;
+    std::vector<std::vector<uint32_t>> incidentEdges;
+    uint64_t geometryIndexVersion = UINT64_MAX;
+};
+
+// Accumulates node/edge mutations for a graph and applies them in one pass.
+// On commit() removals are applied first, then node additions, then edge additions.
+// Duplicates are dropped (first edge wins, last node position wins), edges whose
+// endpoints do not exist after the node pass are skipped, and the indexes are
+// rebuilt at most once.
+class GraphBatch {
+public:
+    explicit GraphBatch(Graph& targetGraph) : graph(targetGraph) {}
+
+    void addNode(const std::string& id);
+    void addNode(const std::string& id, float x, float y);
+    void addNodes(const std::vector<std::string>& ids);
+    void addEdge(const std::string& from, const std::string& to, float weight = 1.0f);
+    void addEdges(const std::vector<Edge>& edgeList);
+    void removeNode(const std::string& id);
+    void removeNodes(const std::vector<std::string>& ids);
+    void removeEdge(const std::string& from, const std::string& to);
+    void setEdgeWeight(const std::string& from, const std::string& to, float weight);
+
+    // Apply all pending changes; returns the number of nodes and edges added or removed
+    size_t commit();
+
+private:
+    struct PendingNode {
+        std::string id;
+        float x = 0.0f;
+        float y = 0.0f;
+        bool hasPosition = false;
+    };
+
+    Graph& graph;
+    std::vector<PendingNode> pendingNodes;
+    std::vector<Edge> pendingEdges;
+    std::vector<std::string> pendingRemovals;
+    std::vector<std::pair<std::string, std::string>> pendingEdgeRemovals;
+    std::vector<Edge> pendingWeights;
+};
+
+inline GraphBatch Graph::beginBatch() {
+    return GraphBatch(*this);
+}
+
+// FNV-1a over the bytes, ignoring '\r' so line-ending conversions do not count as changes
+uint64_t contentHash(const char* data, size_t size);
+
+// Byte ranges and content hashes of the graphs in a model file, found by scanning the
+// structure without parsing the graphs. Uses no model state, so it can run on a worker thread.
+struct GraphFileIndex {
+    struct Entry {
+        std::string name;
+        size_t begin = 0;
+        size_t end = 0;
+        uint64_t hash = 0;
+    };
+
+    std::shared_ptr<const std::string> text;
+    std::vector<Entry> graphs;
+    size_t transfersBegin = 0;
+    size_t transfersEnd = 0;
+    uint64_t transfersHash = 0;
+    bool hashed = false;
+
+    // Without hashGraphs the per-graph hashes are left at 0 and computed when first needed
+    static bool build(std::shared_ptr<const std::string> source, GraphFileIndex& index, bool hashGraphs = true);
+    static bool read(const std::string& filename, GraphFileIndex& index, bool hashGraphs = true);
+};
+
+// Directed link between a node of one graph and a node of another, e.g. a tool transfer
+// that needs the gantry at one station and a hexapod at another
+struct TransferLink {
+    std::string fromGraph;
+    std::string fromNode;
+    std::string toGraph;
+    std::string toNode;
+    float cost = 0.0f;
 };
 
 // Class to manage all graph data
@@ -122,34 +382,114 @@ public:
     GraphModel() = default;
     ~GraphModel() = default;
 
-    bool loadFromFile(const std::string& filename);
-    bool saveToFile(const std::string& filename);
+    // With lazy set, only the graph names and their byte ranges are read; each graph is
+    // parsed on its first getGraph() and written back verbatim on save until it changes.
+    // Otherwise all graphs are built in parallel on the shared thread pool.
+    bool loadFromFile(const std::string& filename, bool lazy = false);
+    // Pretty output matches dump(2) of the whole model; compact output has no whitespace.
+    // Nothing is written when the model has no changes since this file was last loaded or
+    // saved in the same format. The file is replaced only once the new content is written.
+    bool saveToFile(const std::string& filename, bool compact = false);
 
-    std::shared_ptr<Graph> getGraph(const std::string& name) {
-        if (graphs.find(name) != graphs.end()) {
-            return graphs[name];
-        }
-        return nullptr;
-    }
+    // Build a graph from CAD exports: a CSV of id,x,y node rows and one of from,to[,weight]
+    // edge rows (weight 1 when absent), each with an optional header line; further columns
+    // are ignored and ids may not contain commas. Both files are memory-mapped and parsed
+    // in parallel chunks. Duplicate nodes keep the last position, duplicate edges the first
+    // weight, and edges to unknown nodes are skipped. Replaces a graph of the same name; an
+    // empty edgesFile imports nodes only. Nothing changes if a row is malformed.
+    bool importCsv(const std::string& graphName, const std::string& nodesFile, const std::string& edgesFile);
 
-    std::vector<std::string> getGraphNames() const {
-        std::vector<std::string> names;
-        for (const auto& pair : graphs) {
-            names.push_back(pair.first);
-        }
-        return names;
-    }
+    // Unsaved changes since the last load or save: of one graph, or anywhere in the model
+    bool isDirty(const std::string& name) const;
+    bool isDirty() const;
+    std::vector<std::string> getDirtyGraphNames() const;
 
-    void createGraph(const std::string& name) {
-        if (graphs.find(name) == graphs.end()) {
-            graphs[name] = std::make_shared<Graph>(name);
-        }
-    }
+    // Write only the unsaved graphs, the names of removed graphs and changed transfer links
+    // to a recovery file. Skipped when the same changes were already written; without any
+    // unsaved changes the recovery file is deleted instead.
+    bool saveRecovery(const std::string& filename);
+
+    // Apply a recovery file on top of the freshly loaded file it was written against;
+    // returns the number of graphs restored or removed
+    size_t loadRecovery(const std::string& filename);
+
+    // Merge a newer version of the loaded file into the live model. Only graphs whose
+    // content hash changed are parsed, and only the node/edge differences between the
+    // old and new file content are applied. Returns the number of graphs that changed.
+    // The index must have been built with hashGraphs set.
+    size_t reloadChanged(const GraphFileIndex& index);
+
+    std::shared_ptr<Graph> getGraph(const std::string& name);
+    std::vector<std::string> getGraphNames() const;
+    bool hasGraph(const std::string& name) const;
 
-    void removeGraph(const std::string& name) {
-        graphs.erase(name);
+    // Graphs materialized so far; with a lazy load this can be fewer than getGraphNames()
+    size_t getLoadedGraphCount() const;
+
+    // Memory held by a materialized graph; false if the graph is unknown or not parsed yet
+    bool getMemoryUsage(const std::string& name, GraphMemoryUsage& usage) const;
+
+    void createGraph(const std::string& name);
+    void removeGraph(const std::string& name);
+    void clear();
+
+    // Start a batch of mutations on the named graph, creating the graph if needed
+    GraphBatch beginBatch(const std::string& name) {
+        createGraph(name);
+        return graphs[name]->beginBatch();
     }
 
+    // Inter-graph transfer links
+    bool addTransfer(const TransferLink& link);
+    bool removeTransfer(size_t index);
+    const std::vector<TransferLink>& getTransfers() const { return transfers; }
+
+    // Bumped whenever the transfer links change
+    uint64_t getTransferVersion() const { return transferVersion; }
+
 private:
+    // Where the file version of a graph lives: a range of the loaded file text, or the
+    // text written for it by the last save
+    struct GraphSource {
+        std::shared_ptr<const std::string> text;
+        size_t begin = 0;
+        size_t end = 0;
+        uint64_t hash = 0;
+        bool hashed = false;
+        bool matched = false;         // the graph matched the source at loadedVersion/loadedHash
+        uint64_t loadedVersion = 0;   // graph version when it last matched the source
+        uint64_t loadedHash = 0;      // graph content hash when it last matched the source
+    };
+
+    // The graph's content is still the source's: same version, or edited back to the same content
+    static bool matchesSource(const Graph& graph, const GraphSource& source) {
+        return source.matched && (graph.version == source.loadedVersion || graph.stateHash == source.loadedHash);
+    }
+    static void markMatched(const Graph& graph, GraphSource& source) {
+        source.matched = true;
+        source.loadedVersion = graph.version;
+        source.loadedHash = graph.stateHash;
+    }
+
+    void loadGraph(const std::string& graphName, const nlohmann::json& graphData);
+    static size_t mergeGraph(Graph& graph, const nlohmann::json& oldData, const nlohmann::json& newData);
+    void loadTransfers(const nlohmann::json& transfersData);
+    nlohmann::json parseTransfers(const GraphFileIndex& index) const;
+    void writeGraph(JsonWriter& writer, const Graph& graph) const;
+    void writeTransfers(JsonWriter& writer) const;
+    uint64_t recoveryDigest(const std::vector<std::string>& changed) const;
+
     std::unordered_map<std::string, std::shared_ptr<Graph>> graphs;
+    std::unordered_map<std::string, GraphSource> sources;
+    std::vector<TransferLink> transfers;
+    uint64_t transfersHash = 0;
+    uint64_t transferVersion = 0;
+
+    // Save state: the file last loaded or written, graphs removed since (with the content
+    // hash the file had for them), and the content last written to a recovery file
+    std::string savedFile;
+    bool savedCompact = false;
+    uint64_t savedTransferVersion = 0;
+    std::unordered_map<std::string, uint64_t> removedGraphs;
+    uint64_t writtenRecovery = 0;
 };
\ No newline at end of file
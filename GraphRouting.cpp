@@ -0,0 +1,511 @@
+#include "GraphRouting.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <set>
+#include <tuple>
+#include <unordered_set>
+
+namespace {
+
+const float INF = std::numeric_limits<float>::infinity();
+
+uint64_t edgeKey(uint32_t from, uint32_t to) {
+    return (static_cast<uint64_t>(from) << 32) | to;
+}
+
+// Canonical cache key: exclusions are sorted so equivalent queries share an entry
+std::string makeQueryKey(const std::string& source, const std::string& target, size_t k,
+    const RouteExclusions& exclusions) {
+    std::string key = source;
+    key += '\x1f';
+    key += target;
+    key += '\x1f';
+    key += std::to_string(k);
+
+    if (!exclusions.empty()) {
+        std::vector<std::string> nodes = exclusions.nodes;
+        std::vector<std::pair<std::string, std::string>> edges = exclusions.edges;
+        std::sort(nodes.begin(), nodes.end());
+        std::sort(edges.begin(), edges.end());
+        for (const auto& node : nodes) {
+            key += '\x1e';
+            key += node;
+        }
+        for (const auto& edge : edges) {
+            key += '\x1d';
+            key += edge.first;
+            key += '\x1f';
+            key += edge.second;
+        }
+    }
+    return key;
+}
+
+// Search state for one k-shortest-paths query over a snapshot
+class YenSearch {
+public:
+    YenSearch(const RoutingSnapshot& snap, std::vector<char> excludedNodes, std::unordered_set<uint64_t> excludedEdges)
+        : snapshot(snap),
+          nodeCount(snap.offsets.size() - 1),
+          excluded(std::move(excludedNodes)),
+          excludedEdgeSet(std::move(excludedEdges)),
+          distToTarget(nodeCount, INF),
+          nextHop(nodeCount, UINT32_MAX),
+          score(nodeCount, INF),
+          parent(nodeCount, UINT32_MAX),
+          visitStamp(nodeCount, 0),
+          blockStamp(nodeCount, 0) {
+    }
+
+    std::vector<std::vector<uint32_t>> run(uint32_t source, uint32_t target, size_t k);
+
+    float edgeWeight(uint32_t from, uint32_t to) const {
+        for (uint32_t e = snapshot.offsets[from]; e < snapshot.offsets[from + 1]; ++e) {
+            if (snapshot.targets[e] == to) {
+                return snapshot.weights[e];
+            }
+        }
+        return INF;
+    }
+
+private:
+    bool isExcludedEdge(uint32_t from, uint32_t to) const {
+        return !excludedEdgeSet.empty() && excludedEdgeSet.count(edgeKey(from, to)) > 0;
+    }
+
+    void buildTree(uint32_t target);
+    bool treePathIsFree(uint32_t spur, uint32_t target, const std::vector<uint32_t>& blockedFirstHops) const;
+    bool searchSpur(uint32_t spur, uint32_t target, const std::vector<uint32_t>& blockedFirstHops,
+        std::vector<uint32_t>& path, float& cost);
+
+    const RoutingSnapshot& snapshot;
+    size_t nodeCount;
+    std::vector<char> excluded;
+    std::unordered_set<uint64_t> excludedEdgeSet;
+
+    // Reverse shortest-path tree: cost to the target and next hop toward it
+    std::vector<float> distToTarget;
+    std::vector<uint32_t> nextHop;
+
+    // Spur search state, invalidated by bumping the stamps instead of clearing
+    std::vector<float> score;
+    std::vector<uint32_t> parent;
+    std::vector<uint32_t> visitStamp;
+    std::vector<uint32_t> blockStamp;
+    uint32_t visitGeneration = 0;
+    uint32_t blockGeneration = 0;
+};
+
+void YenSearch::buildTree(uint32_t target) {
+    using Item = std::pair<float, uint32_t>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+
+    distToTarget[target] = 0.0f;
+    queue.emplace(0.0f, target);
+
+    while (!queue.empty()) {
+        Item item = queue.top();
+        queue.pop();
+        uint32_t v = item.second;
+        if (item.first > distToTarget[v]) {
+            continue;
+        }
+
+        for (uint32_t e = snapshot.reverseOffsets[v]; e < snapshot.reverseOffsets[v + 1]; ++e) {
+            uint32_t u = snapshot.reverseSources[e];
+            if (excluded[u] || isExcludedEdge(u, v)) {
+                continue;
+            }
+            float candidate = item.first + snapshot.reverseWeights[e];
+            if (candidate < distToTarget[u]) {
+                distToTarget[u] = candidate;
+                nextHop[u] = v;
+                queue.emplace(candidate, u);
+            }
+        }
+    }
+}
+
+bool YenSearch::treePathIsFree(uint32_t spur, uint32_t target, const std::vector<uint32_t>& blockedFirstHops) const {
+    if (distToTarget[spur] == INF) {
+        return false;
+    }
+    if (spur != target &&
+        std::find(blockedFirstHops.begin(), blockedFirstHops.end(), nextHop[spur]) != blockedFirstHops.end()) {
+        return false;
+    }
+    for (uint32_t v = nextHop[spur]; v != UINT32_MAX; v = nextHop[v]) {
+        if (blockStamp[v] == blockGeneration) {
+            return false;
+        }
+        if (v == target) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool YenSearch::searchSpur(uint32_t spur, uint32_t target, const std::vector<uint32_t>& blockedFirstHops,
+    std::vector<uint32_t>& path, float& cost) {
+    path.clear();
+
+    // Blocking only removes options, so the unblocked tree path is optimal whenever it survives
+    if (treePathIsFree(spur, target, blockedFirstHops)) {
+        for (uint32_t v = spur; v != UINT32_MAX; v = nextHop[v]) {
+            path.push_back(v);
+            if (v == target) {
+                break;
+            }
+        }
+        cost = distToTarget[spur];
+        return true;
+    }
+
+    // A* with the tree distances as a consistent heuristic. Ties on f are broken toward
+    // the smaller remaining distance, which keeps equal-cost plateaus from being flooded.
+    ++visitGeneration;
+    using Item = std::tuple<float, float, uint32_t>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+
+    visitStamp[spur] = visitGeneration;
+    score[spur] = 0.0f;
+    parent[spur] = UINT32_MAX;
+    queue.emplace(distToTarget[spur], distToTarget[spur], spur);
+
+    while (!queue.empty()) {
+        Item item = queue.top();
+        queue.pop();
+        uint32_t v = std::get<2>(item);
+        float g = score[v];
+        if (std::get<0>(item) > g + distToTarget[v]) {
+            continue;
+        }
+
+        if (v == target) {
+            for (uint32_t p = target; p != UINT32_MAX; p = parent[p]) {
+                path.push_back(p);
+            }
+            std::reverse(path.begin(), path.end());
+            cost = g;
+            return true;
+        }
+
+        for (uint32_t e = snapshot.offsets[v]; e < snapshot.offsets[v + 1]; ++e) {
+            uint32_t w = snapshot.targets[e];
+            if (excluded[w] || blockStamp[w] == blockGeneration || distToTarget[w] == INF || isExcludedEdge(v, w)) {
+                continue;
+            }
+            if (v == spur && std::find(blockedFirstHops.begin(), blockedFirstHops.end(), w) != blockedFirstHops.end()) {
+                continue;
+            }
+
+            float candidate = g + snapshot.weights[e];
+            if (visitStamp[w] != visitGeneration || candidate < score[w]) {
+                visitStamp[w] = visitGeneration;
+                score[w] = candidate;
+                parent[w] = v;
+                queue.emplace(candidate + distToTarget[w], distToTarget[w], w);
+            }
+        }
+    }
+
+    return false;
+}
+
+std::vector<std::vector<uint32_t>> YenSearch::run(uint32_t source, uint32_t target, size_t k) {
+    std::vector<std::vector<uint32_t>> accepted;
+    if (k == 0 || excluded[source] || excluded[target]) {
+        return accepted;
+    }
+
+    buildTree(target);
+    if (distToTarget[source] == INF) {
+        return accepted;
+    }
+
+    // First route straight from the tree
+    std::vector<uint32_t> first;
+    for (uint32_t v = source; v != UINT32_MAX; v = nextHop[v]) {
+        first.push_back(v);
+        if (v == target) {
+            break;
+        }
+    }
+    accepted.push_back(first);
+
+    // Candidates ordered by (cost, path) so ties resolve deterministically
+    std::set<std::pair<float, std::vector<uint32_t>>> candidates;
+    std::set<std::vector<uint32_t>> seen;
+    seen.insert(first);
+
+    std::vector<uint32_t> spurPath;
+    std::vector<uint32_t> blockedFirstHops;
+
+    while (accepted.size() < k) {
+        const std::vector<uint32_t> previous = accepted.back();
+
+        float rootCost = 0.0f;
+        for (size_t i = 0; i + 1 < previous.size(); ++i) {
+            uint32_t spur = previous[i];
+
+            // Block the next hop of every accepted route sharing this root
+            blockedFirstHops.clear();
+            for (const auto& route : accepted) {
+                if (route.size() > i + 1 && std::equal(previous.begin(), previous.begin() + i + 1, route.begin())) {
+                    blockedFirstHops.push_back(route[i + 1]);
+                }
+            }
+
+            // Block the root path itself (except the spur node) to keep routes loopless
+            ++blockGeneration;
+            for (size_t j = 0; j < i; ++j) {
+                blockStamp[previous[j]] = blockGeneration;
+            }
+
+            float spurCost = 0.0f;
+            if (searchSpur(spur, target, blockedFirstHops, spurPath, spurCost)) {
+                std::vector<uint32_t> candidate(previous.begin(), previous.begin() + i);
+                candidate.insert(candidate.end(), spurPath.begin(), spurPath.end());
+                if (seen.insert(candidate).second) {
+                    candidates.emplace(rootCost + spurCost, std::move(candidate));
+                }
+            }
+
+            rootCost += edgeWeight(previous[i], previous[i + 1]);
+        }
+
+        if (candidates.empty()) {
+            break;
+        }
+
+        accepted.push_back(candidates.begin()->second);
+        candidates.erase(candidates.begin());
+    }
+
+    return accepted;
+}
+
+} // namespace
+
+void RouteCache::resetIfStale(uint64_t version) {
+    if (version != cacheVersion) {
+        entries.clear();
+        lookupTable.clear();
+        cacheVersion = version;
+    }
+}
+
+bool RouteCache::lookup(uint64_t version, const std::string& key, std::vector<Route>& routes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    resetIfStale(version);
+
+    auto it = lookupTable.find(key);
+    if (it == lookupTable.end()) {
+        ++misses;
+        return false;
+    }
+
+    entries.splice(entries.begin(), entries, it->second);
+    routes = it->second->second;
+    ++hits;
+    return true;
+}
+
+void RouteCache::store(uint64_t version, const std::string& key, const std::vector<Route>& routes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    resetIfStale(version);
+
+    auto it = lookupTable.find(key);
+    if (it != lookupTable.end()) {
+        it->second->second = routes;
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+
+    entries.emplace_front(key, routes);
+    lookupTable[key] = entries.begin();
+
+    // Evict the least recently used entry
+    if (entries.size() > capacity) {
+        lookupTable.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
+
+void RouteCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    lookupTable.clear();
+    currentSnapshot = nullptr;
+}
+
+std::shared_ptr<const RoutingSnapshot> RouteCache::snapshot(Graph& graph) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (currentSnapshot && currentSnapshot->version == graph.version) {
+        return currentSnapshot;
+    }
+
+    graph.updateGeometryIndex();
+
+    auto snap = std::make_shared<RoutingSnapshot>();
+    const size_t nodeCount = graph.nodes.size();
+    const size_t edgeCount = graph.edges.size();
+    snap->version = graph.version;
+    snap->offsets.assign(nodeCount + 1, 0);
+    snap->reverseOffsets.assign(nodeCount + 1, 0);
+    snap->targets.resize(edgeCount);
+    snap->weights.resize(edgeCount);
+    snap->reverseSources.resize(edgeCount);
+    snap->reverseWeights.resize(edgeCount);
+
+    // Counting sort of the edges by source and by target
+    for (size_t i = 0; i < edgeCount; ++i) {
+        ++snap->offsets[graph.edgeFromSlot[i] + 1];
+        ++snap->reverseOffsets[graph.edgeToSlot[i] + 1];
+    }
+    for (size_t v = 0; v < nodeCount; ++v) {
+        snap->offsets[v + 1] += snap->offsets[v];
+        snap->reverseOffsets[v + 1] += snap->reverseOffsets[v];
+    }
+
+    std::vector<uint32_t> forwardFill(snap->offsets.begin(), snap->offsets.end() - 1);
+    std::vector<uint32_t> reverseFill(snap->reverseOffsets.begin(), snap->reverseOffsets.end() - 1);
+    for (size_t i = 0; i < edgeCount; ++i) {
+        uint32_t from = graph.edgeFromSlot[i];
+        uint32_t to = graph.edgeToSlot[i];
+        float weight = std::max(graph.edges[i]->weight, 0.0f);
+
+        uint32_t f = forwardFill[from]++;
+        snap->targets[f] = to;
+        snap->weights[f] = weight;
+
+        uint32_t r = reverseFill[to]++;
+        snap->reverseSources[r] = from;
+        snap->reverseWeights[r] = weight;
+    }
+
+    currentSnapshot = snap;
+    return currentSnapshot;
+}
+
+RouteCache& routeCacheOf(Graph& graph) {
+    if (!graph.routeCache) {
+        graph.routeCache = std::make_shared<RouteCache>();
+    }
+    return *graph.routeCache;
+}
+
+std::vector<Route> findKShortestPaths(Graph& graph, const std::string& source, const std::string& target,
+    size_t k, const RouteExclusions& exclusions) {
+    RouteCache& cache = routeCacheOf(graph);
+
+    std::vector<Route> routes;
+    const std::string key = makeQueryKey(source, target, k, exclusions);
+    if (cache.lookup(graph.version, key, routes)) {
+        return routes;
+    }
+
+    auto sourceIt = graph.nodeIndex.find(source);
+    auto targetIt = graph.nodeIndex.find(target);
+    if (sourceIt != graph.nodeIndex.end() && targetIt != graph.nodeIndex.end()) {
+        auto snap = cache.snapshot(graph);
+
+        // Resolve exclusions to slots for this query only
+        std::vector<char> excludedNodes(graph.nodes.size(), 0);
+        for (const auto& id : exclusions.nodes) {
+            auto it = graph.nodeIndex.find(id);
+            if (it != graph.nodeIndex.end()) {
+                excludedNodes[it->second] = 1;
+            }
+        }
+        std::unordered_set<uint64_t> excludedEdges;
+        for (const auto& edge : exclusions.edges) {
+            auto fromIt = graph.nodeIndex.find(edge.first);
+            auto toIt = graph.nodeIndex.find(edge.second);
+            if (fromIt != graph.nodeIndex.end() && toIt != graph.nodeIndex.end()) {
+                excludedEdges.insert(edgeKey(static_cast<uint32_t>(fromIt->second), static_cast<uint32_t>(toIt->second)));
+            }
+        }
+
+        YenSearch search(*snap, std::move(excludedNodes), std::move(excludedEdges));
+        auto paths = search.run(static_cast<uint32_t>(sourceIt->second), static_cast<uint32_t>(targetIt->second), k);
+
+        for (const auto& path : paths) {
+            Route route;
+            route.nodes.reserve(path.size());
+            for (size_t i = 0; i < path.size(); ++i) {
+                route.nodes.push_back(graph.nodes[path[i]]->id);
+                if (i > 0) {
+                    route.cost += search.edgeWeight(path[i - 1], path[i]);
+                }
+            }
+            routes.push_back(std::move(route));
+        }
+    }
+
+    cache.store(graph.version, key, routes);
+    return routes;
+}
+
+Route findShortestPath(Graph& graph, const std::string& source, const std::string& target,
+    const RouteExclusions& exclusions) {
+    auto routes = findKShortestPaths(graph, source, target, 1, exclusions);
+    return routes.empty() ? Route() : routes.front();
+}
+
+void computeDistances(const RoutingSnapshot& snapshot, uint32_t origin, bool reverse,
+    const std::vector<uint32_t>& stopAfter, std::vector<float>& dist) {
+    const size_t nodeCount = snapshot.offsets.size() - 1;
+    dist.assign(nodeCount, INF);
+    if (origin >= nodeCount) {
+        return;
+    }
+
+    const std::vector<uint32_t>& offsets = reverse ? snapshot.reverseOffsets : snapshot.offsets;
+    const std::vector<uint32_t>& neighbours = reverse ? snapshot.reverseSources : snapshot.targets;
+    const std::vector<float>& weights = reverse ? snapshot.reverseWeights : snapshot.weights;
+
+    std::vector<char> pending;
+    size_t remaining = 0;
+    if (!stopAfter.empty()) {
+        pending.assign(nodeCount, 0);
+        for (uint32_t slot : stopAfter) {
+            if (slot < nodeCount && !pending[slot]) {
+                pending[slot] = 1;
+                ++remaining;
+            }
+        }
+    }
+
+    using Item = std::pair<float, uint32_t>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+    dist[origin] = 0.0f;
+    queue.emplace(0.0f, origin);
+
+    while (!queue.empty()) {
+        Item item = queue.top();
+        queue.pop();
+        uint32_t v = item.second;
+        if (item.first > dist[v]) {
+            continue;
+        }
+
+        if (!pending.empty() && pending[v]) {
+            pending[v] = 0;
+            if (--remaining == 0) {
+                return;
+            }
+        }
+
+        for (uint32_t e = offsets[v]; e < offsets[v + 1]; ++e) {
+            uint32_t w = neighbours[e];
+            float candidate = item.first + weights[e];
+            if (candidate < dist[w]) {
+                dist[w] = candidate;
+                queue.emplace(candidate, w);
+            }
+        }
+    }
+}
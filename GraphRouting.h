@@ -0,0 +1,86 @@
+#pragma once
+
+#include "GraphModel.h"
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// A route through a graph as a sequence of node ids, with its total weight
+struct Route {
+    std::vector<std::string> nodes;
+    float cost = 0.0f;
+};
+
+// Nodes and edges to treat as absent for a single query, without touching the graph
+struct RouteExclusions {
+    std::vector<std::string> nodes;
+    std::vector<std::pair<std::string, std::string>> edges;
+
+    bool empty() const { return nodes.empty() && edges.empty(); }
+};
+
+// Compressed adjacency of a graph by node slot, forward and reverse.
+// Built once per graph version and shared by all queries at that version.
+struct RoutingSnapshot {
+    uint64_t version = 0;
+    std::vector<uint32_t> offsets;          // out-edges of v: [offsets[v], offsets[v + 1])
+    std::vector<uint32_t> targets;
+    std::vector<float> weights;
+    std::vector<uint32_t> reverseOffsets;   // in-edges of v, same layout
+    std::vector<uint32_t> reverseSources;
+    std::vector<float> reverseWeights;
+};
+
+// Per-graph LRU cache of route queries, keyed by (graph version, source, target, k, exclusions).
+// Entries from an older graph version are dropped as soon as the version changes.
+class RouteCache {
+public:
+    explicit RouteCache(size_t cacheCapacity = 256) : capacity(cacheCapacity) {}
+
+    bool lookup(uint64_t version, const std::string& key, std::vector<Route>& routes);
+    void store(uint64_t version, const std::string& key, const std::vector<Route>& routes);
+    void clear();
+
+    // Adjacency snapshot for the given graph, rebuilt when the graph version changed
+    std::shared_ptr<const RoutingSnapshot> snapshot(Graph& graph);
+
+    size_t getHits() const { return hits; }
+    size_t getMisses() const { return misses; }
+
+private:
+    using Entry = std::pair<std::string, std::vector<Route>>;
+
+    void resetIfStale(uint64_t version);
+
+    std::mutex mutex;
+    size_t capacity;
+    uint64_t cacheVersion = 0;
+    std::list<Entry> entries;   // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> lookupTable;
+    std::shared_ptr<const RoutingSnapshot> currentSnapshot;
+    size_t hits = 0;
+    size_t misses = 0;
+};
+
+// The graph's route cache, created on first use
+RouteCache& routeCacheOf(Graph& graph);
+
+// Up to k shortest loopless routes from source to target in increasing cost order (Yen's
+// algorithm). A reverse shortest-path tree to the target is computed once per query and
+// reused by every spur search, both as an exact A* heuristic and as a shortcut when the
+// tree path from the spur node is not blocked. Results are cached on the graph.
+std::vector<Route> findKShortestPaths(Graph& graph, const std::string& source, const std::string& target,
+    size_t k, const RouteExclusions& exclusions = RouteExclusions());
+
+// Cheapest route, or an empty route if the target cannot be reached
+Route findShortestPath(Graph& graph, const std::string& source, const std::string& target,
+    const RouteExclusions& exclusions = RouteExclusions());
+
+// Dijkstra over a snapshot from the given slot; with reverse set, the distances are to the
+// slot instead of from it. Unreached slots stay at infinity. When stopAfter is not empty
+// the search ends as soon as all of those slots are settled, and only they are final.
+void computeDistances(const RoutingSnapshot& snapshot, uint32_t origin, bool reverse,
+    const std::vector<uint32_t>& stopAfter, std::vector<float>& dist);
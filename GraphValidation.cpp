@@ -0,0 +1,282 @@
+#include "GraphValidation.h"
+#include "GraphAnalysis.h"
+#include "Profiler.h"
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+// Longest list of node ids quoted in one issue
+const size_t MAX_LISTED_IDS = 5;
+
+class IssueList {
+public:
+    IssueList(ValidationResult& validationResult, const std::string& graphName)
+        : result(validationResult), graph(graphName) {}
+
+    void error(const std::string& message) { add(true, message); }
+    void warning(const std::string& message) { add(false, message); }
+
+private:
+    void add(bool isError, const std::string& message) {
+        ValidationIssue issue;
+        issue.error = isError;
+        issue.graph = graph;
+        issue.message = message;
+        result.issues.push_back(std::move(issue));
+    }
+
+    ValidationResult& result;
+    std::string graph;
+};
+
+std::string listIds(const std::vector<std::string>& ids) {
+    std::string text;
+    for (size_t i = 0; i < ids.size() && i < MAX_LISTED_IDS; ++i) {
+        text += (i > 0 ? ", " : "") + ids[i];
+    }
+    if (ids.size() > MAX_LISTED_IDS) {
+        text += " and " + std::to_string(ids.size() - MAX_LISTED_IDS) + " more";
+    }
+    return text;
+}
+
+bool isFiniteNumber(const nlohmann::json& value) {
+    return value.is_number() && std::isfinite(value.get<double>());
+}
+
+// Checks one graph value; returns the node ids it defines (empty if unusable)
+std::unordered_set<std::string> validateGraph(const std::string& name, const nlohmann::json& graphData,
+    const std::string& rootId, ValidationResult& result) {
+    IssueList issues(result, name);
+    std::unordered_set<std::string> nodeIds;
+    if (!graphData.is_object()) {
+        issues.error("graph is not an object");
+        return nodeIds;
+    }
+
+    Graph graph(name);
+    GraphBatch batch = graph.beginBatch();
+
+    // Nodes
+    std::vector<std::string> duplicates;
+    if (!graphData.contains("nodes") || !graphData["nodes"].is_array()) {
+        issues.error("missing \"nodes\" array");
+    }
+    else {
+        size_t position = 0;
+        for (const auto& nodeData : graphData["nodes"]) {
+            std::string id;
+            if (nodeData.is_string()) {
+                id = nodeData.get<std::string>();
+            }
+            else if (nodeData.is_object() && nodeData.contains("id") && nodeData["id"].is_string()) {
+                id = nodeData["id"].get<std::string>();
+                for (const char* axis : { "x", "y" }) {
+                    if (nodeData.contains(axis) && !isFiniteNumber(nodeData[axis])) {
+                        issues.error("node " + id + ": " + axis + " is not a finite number");
+                    }
+                }
+            }
+            else {
+                issues.error("node #" + std::to_string(position) + " has no string id");
+                ++position;
+                continue;
+            }
+            ++position;
+
+            if (id.empty()) {
+                issues.error("node #" + std::to_string(position - 1) + " has an empty id");
+            }
+            if (!nodeIds.insert(id).second) {
+                duplicates.push_back(id);
+                continue;
+            }
+            batch.addNode(id);
+        }
+    }
+    if (!duplicates.empty()) {
+        issues.error("repeated node ids: " + listIds(duplicates));
+    }
+
+    // Edges
+    std::vector<std::string> dangling;
+    std::vector<std::string> repeated;
+    std::vector<std::string> selfLoops;
+    size_t edgeCount = 0;
+    if (graphData.contains("edges") && !graphData["edges"].is_array()) {
+        issues.error("\"edges\" is not an array");
+    }
+    else if (graphData.contains("edges")) {
+        std::unordered_set<std::pair<std::string, std::string>, EdgeKeyHash> seen;
+        size_t position = 0;
+        for (const auto& edgeData : graphData["edges"]) {
+            if (!edgeData.is_object() || !edgeData.contains("from") || !edgeData.contains("to") ||
+                !edgeData["from"].is_string() || !edgeData["to"].is_string()) {
+                issues.error("edge #" + std::to_string(position++) + " has no string from/to");
+                continue;
+            }
+            ++position;
+
+            std::string from = edgeData["from"].get<std::string>();
+            std::string to = edgeData["to"].get<std::string>();
+            std::string label = from + " -> " + to;
+            if (edgeData.contains("weight")) {
+                const auto& weight = edgeData["weight"];
+                if (!isFiniteNumber(weight)) {
+                    issues.error("edge " + label + ": weight is not a finite number");
+                }
+                else if (weight.get<double>() < 0.0) {
+                    issues.error("edge " + label + ": negative weight");
+                }
+            }
+            if (nodeIds.find(from) == nodeIds.end() || nodeIds.find(to) == nodeIds.end()) {
+                dangling.push_back(label);
+                continue;
+            }
+            if (!seen.emplace(from, to).second) {
+                repeated.push_back(label);
+                continue;
+            }
+            if (from == to) {
+                selfLoops.push_back(from);
+            }
+            batch.addEdge(from, to);
+            ++edgeCount;
+        }
+    }
+    if (!dangling.empty()) {
+        issues.error("edges to undefined nodes: " + listIds(dangling));
+    }
+    if (!repeated.empty()) {
+        issues.error("repeated edges: " + listIds(repeated));
+    }
+    if (!selfLoops.empty()) {
+        issues.warning("self-loops at " + listIds(selfLoops));
+    }
+
+    // Weight model
+    if (graphData.contains("weightModel")) {
+        const auto& modelData = graphData["weightModel"];
+        if (!modelData.is_object()) {
+            issues.error("\"weightModel\" is not an object");
+        }
+        else {
+            std::string mode = modelData.value("mode", std::string("manual"));
+            if (mode != "manual" && mode != "distance" && mode != "moveTime") {
+                issues.error("unknown weight model mode \"" + mode + "\"");
+            }
+            for (const char* key : { "velocity", "acceleration" }) {
+                if (modelData.contains(key) && (!isFiniteNumber(modelData[key]) || modelData[key].get<double>() <= 0.0)) {
+                    issues.error(std::string("weight model ") + key + " must be a positive number");
+                }
+            }
+        }
+    }
+
+    // Reachability from and back to the root, when the graph has one
+    batch.commit();
+    result.nodeCount += graph.nodes.size();
+    result.edgeCount += edgeCount;
+    if (nodeIds.find(rootId) != nodeIds.end()) {
+        auto shared = std::shared_ptr<Graph>(&graph, [](Graph*) {});
+        GraphAnalysis analysis;
+        analysis.setRoot(rootId);
+        analysis.update(shared);
+
+        std::vector<std::string> unreachable;
+        std::vector<std::string> deadEnds;
+        for (size_t slot = 0; slot < graph.nodes.size(); ++slot) {
+            if (analysis.isUnreachable(slot)) {
+                unreachable.push_back(graph.nodes[slot]->id);
+            }
+            else if (analysis.isDeadEnd(slot)) {
+                deadEnds.push_back(graph.nodes[slot]->id);
+            }
+        }
+        if (!unreachable.empty()) {
+            issues.warning("not reachable from " + rootId + ": " + listIds(unreachable));
+        }
+        if (!deadEnds.empty()) {
+            issues.warning("cannot return to " + rootId + ": " + listIds(deadEnds));
+        }
+    }
+    return nodeIds;
+}
+
+} // namespace
+
+size_t ValidationResult::errorCount() const {
+    size_t count = 0;
+    for (const auto& issue : issues) {
+        count += issue.error ? 1 : 0;
+    }
+    return count;
+}
+
+ValidationResult validateGraphFile(const GraphFileIndex& index, const std::string& rootId) {
+    PROFILE_SCOPE("validateGraphFile");
+    ValidationResult result;
+    result.graphCount = index.graphs.size();
+    IssueList fileIssues(result, std::string());
+
+    std::unordered_map<std::string, std::unordered_set<std::string>> nodeIds;
+    for (const auto& entry : index.graphs) {
+        if (nodeIds.find(entry.name) != nodeIds.end()) {
+            fileIssues.error("graph " + entry.name + " is defined more than once");
+            continue;
+        }
+        try {
+            nlohmann::json graphData = nlohmann::json::parse(
+                index.text->begin() + entry.begin, index.text->begin() + entry.end);
+            nodeIds[entry.name] = validateGraph(entry.name, graphData, rootId, result);
+        }
+        catch (const std::exception& e) {
+            IssueList(result, entry.name).error(std::string("invalid JSON: ") + e.what());
+            nodeIds[entry.name];
+        }
+    }
+
+    // Transfer links must join existing nodes of two different graphs
+    if (index.transfersEnd > index.transfersBegin) {
+        try {
+            nlohmann::json transfersData = nlohmann::json::parse(
+                index.text->begin() + index.transfersBegin, index.text->begin() + index.transfersEnd);
+            if (!transfersData.is_array()) {
+                fileIssues.error("\"transfers\" is not an array");
+                return result;
+            }
+            size_t position = 0;
+            for (const auto& linkData : transfersData) {
+                std::string label = "transfer #" + std::to_string(position++);
+                if (!linkData.is_object()) {
+                    fileIssues.error(label + " is not an object");
+                    continue;
+                }
+                std::string ends[2][2] = {
+                    { linkData.value("fromGraph", std::string()), linkData.value("fromNode", std::string()) },
+                    { linkData.value("toGraph", std::string()), linkData.value("toNode", std::string()) } };
+                for (const auto& end : ends) {
+                    auto graphIt = nodeIds.find(end[0]);
+                    if (graphIt == nodeIds.end()) {
+                        fileIssues.error(label + ": unknown graph \"" + end[0] + "\"");
+                    }
+                    else if (graphIt->second.find(end[1]) == graphIt->second.end()) {
+                        fileIssues.error(label + ": unknown node \"" + end[1] + "\" in " + end[0]);
+                    }
+                }
+                if (ends[0][0] == ends[1][0]) {
+                    fileIssues.error(label + " links a graph to itself");
+                }
+                if (linkData.contains("cost") && (!isFiniteNumber(linkData["cost"]) || linkData["cost"].get<double>() < 0.0)) {
+                    fileIssues.error(label + ": cost must be a non-negative number");
+                }
+            }
+        }
+        catch (const std::exception& e) {
+            fileIssues.error(std::string("invalid transfers: ") + e.what());
+        }
+    }
+    return result;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "GraphModel.h"
+#include <string>
+#include <vector>
+
+// Structural checks of a model file, for CI and commissioning scripts.
+//
+// The loader quietly repairs what it can (repeated ids, edges to missing nodes, malformed
+// entries are skipped), so the checks run on the file text rather than on a loaded model.
+// Errors are content the loader drops or cannot use; warnings are legal but suspicious
+// (self-loops, nodes the root cannot reach or that cannot return to it).
+struct ValidationIssue {
+    bool error = true;
+    std::string graph;      // empty for file-level issues
+    std::string message;
+};
+
+struct ValidationResult {
+    std::vector<ValidationIssue> issues;
+    size_t graphCount = 0;
+    size_t nodeCount = 0;
+    size_t edgeCount = 0;
+
+    size_t errorCount() const;
+    bool ok() const { return errorCount() == 0; }
+};
+
+// Check every graph of an indexed file and its transfer links; rootId is the node every
+// other node should be reachable from and able to return to (skipped if a graph lacks it)
+ValidationResult validateGraphFile(const GraphFileIndex& index, const std::string& rootId = "Home");
@@ -0,0 +1,212 @@
+#include "InputRecording.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+// Bumped when the file layout changes
+const int RECORDING_FORMAT = 1;
+
+namespace {
+
+// Mouse buttons and modifiers are recorded separately from the keys
+bool isRecordedKey(ImGuiKey key) {
+    return !(key >= ImGuiKey_MouseLeft && key <= ImGuiKey_MouseWheelY) &&
+        !(key >= ImGuiKey_ReservedForModCtrl && key <= ImGuiKey_ReservedForModSuper);
+}
+
+// Keys of a loaded frame as replay needs them: named keys that are recorded, sorted, each
+// once. Files may be hand-edited or come from another ImGui version.
+void sanitizeKeys(std::vector<int>& keys) {
+    keys.erase(std::remove_if(keys.begin(), keys.end(), [](int key) {
+        return key < ImGuiKey_NamedKey_BEGIN || key >= ImGuiKey_NamedKey_END ||
+            !isRecordedKey(static_cast<ImGuiKey>(key));
+    }), keys.end());
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+} // namespace
+
+bool InputRecording::save(const std::string& filename) const {
+    nlohmann::json data;
+    data["format"] = RECORDING_FORMAT;
+    data["imgui"] = IMGUI_VERSION_NUM;
+    data["graph"] = graphName;
+    data["view"] = { canvasOffset.x, canvasOffset.y, canvasScale };
+
+    nlohmann::json frameData = nlohmann::json::array();
+    for (const auto& frame : frames) {
+        nlohmann::json item;
+        item["dt"] = frame.deltaTime;
+        item["size"] = { frame.displaySize.x, frame.displaySize.y };
+        item["mouse"] = { frame.mousePos.x, frame.mousePos.y };
+        item["buttons"] = frame.mouseButtons;
+        if (frame.mouseWheel != 0.0f || frame.mouseWheelH != 0.0f) {
+            item["wheel"] = { frame.mouseWheel, frame.mouseWheelH };
+        }
+        if (frame.modifiers != 0) {
+            item["mods"] = frame.modifiers;
+        }
+        if (!frame.keys.empty()) {
+            item["keys"] = frame.keys;
+        }
+        if (!frame.characters.empty()) {
+            item["chars"] = frame.characters;
+        }
+        frameData.push_back(std::move(item));
+    }
+    data["frames"] = std::move(frameData);
+
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        return false;
+    }
+    file << data.dump();
+    if (!file.good()) {
+        std::cerr << "Failed to write file: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool InputRecording::load(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        return false;
+    }
+
+    try {
+        nlohmann::json data = nlohmann::json::parse(file);
+        if (data.value("format", 0) != RECORDING_FORMAT) {
+            std::cerr << "Unsupported recording format in " << filename << std::endl;
+            return false;
+        }
+        if (data.value("imgui", 0) != IMGUI_VERSION_NUM) {
+            std::cerr << "Recording " << filename << " was made with another ImGui version; key codes may differ" << std::endl;
+        }
+
+        graphName = data.value("graph", std::string());
+        const auto& view = data.at("view");
+        canvasOffset = ImVec2(view.at(0).get<float>(), view.at(1).get<float>());
+        canvasScale = view.at(2).get<float>();
+
+        frames.clear();
+        for (const auto& item : data.at("frames")) {
+            InputFrame frame;
+            frame.deltaTime = item.value("dt", 0.0f);
+            frame.displaySize = ImVec2(item.at("size").at(0).get<float>(), item.at("size").at(1).get<float>());
+            frame.mousePos = ImVec2(item.at("mouse").at(0).get<float>(), item.at("mouse").at(1).get<float>());
+            frame.mouseButtons = item.value("buttons", 0u);
+            if (item.contains("wheel")) {
+                frame.mouseWheel = item["wheel"].at(0).get<float>();
+                frame.mouseWheelH = item["wheel"].at(1).get<float>();
+            }
+            frame.modifiers = item.value("mods", 0u);
+            if (item.contains("keys")) {
+                frame.keys = item["keys"].get<std::vector<int>>();
+                sanitizeKeys(frame.keys);
+            }
+            if (item.contains("chars")) {
+                frame.characters = item["chars"].get<std::vector<unsigned int>>();
+            }
+            frames.push_back(std::move(frame));
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error loading recording " << filename << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+InputFrame captureInputFrame() {
+    const ImGuiIO& io = ImGui::GetIO();
+    InputFrame frame;
+    frame.deltaTime = io.DeltaTime;
+    frame.displaySize = io.DisplaySize;
+    frame.mousePos = io.MousePos;
+    for (int button = 0; button < ImGuiMouseButton_COUNT; ++button) {
+        if (io.MouseDown[button]) {
+            frame.mouseButtons |= 1u << button;
+        }
+    }
+    frame.mouseWheel = io.MouseWheel;
+    frame.mouseWheelH = io.MouseWheelH;
+    frame.modifiers = static_cast<uint32_t>(io.KeyMods);
+
+    for (int key = ImGuiKey_NamedKey_BEGIN; key < ImGuiKey_NamedKey_END; ++key) {
+        if (isRecordedKey(static_cast<ImGuiKey>(key)) && ImGui::IsKeyDown(static_cast<ImGuiKey>(key))) {
+            frame.keys.push_back(key);
+        }
+    }
+
+    // Characters stay queued until the end of the frame
+    for (ImWchar c : io.InputQueueCharacters) {
+        frame.characters.push_back(c);
+    }
+    return frame;
+}
+
+void applyInputFrame(const InputFrame& frame, const InputFrame* previous) {
+    ImGuiIO& io = ImGui::GetIO();
+    io.DeltaTime = frame.deltaTime > 0.0f ? frame.deltaTime : 1.0f / 60.0f;
+    io.DisplaySize = frame.displaySize;
+
+    io.AddKeyEvent(ImGuiMod_Ctrl, (frame.modifiers & ImGuiMod_Ctrl) != 0);
+    io.AddKeyEvent(ImGuiMod_Shift, (frame.modifiers & ImGuiMod_Shift) != 0);
+    io.AddKeyEvent(ImGuiMod_Alt, (frame.modifiers & ImGuiMod_Alt) != 0);
+    io.AddKeyEvent(ImGuiMod_Super, (frame.modifiers & ImGuiMod_Super) != 0);
+
+    // Both key lists are sorted
+    static const std::vector<int> none;
+    const std::vector<int>& before = previous ? previous->keys : none;
+    std::vector<int> released;
+    std::vector<int> pressed;
+    std::set_difference(before.begin(), before.end(), frame.keys.begin(), frame.keys.end(), std::back_inserter(released));
+    std::set_difference(frame.keys.begin(), frame.keys.end(), before.begin(), before.end(), std::back_inserter(pressed));
+    for (int key : released) {
+        io.AddKeyEvent(static_cast<ImGuiKey>(key), false);
+    }
+    for (int key : pressed) {
+        io.AddKeyEvent(static_cast<ImGuiKey>(key), true);
+    }
+
+    io.AddMousePosEvent(frame.mousePos.x, frame.mousePos.y);
+    for (int button = 0; button < ImGuiMouseButton_COUNT; ++button) {
+        io.AddMouseButtonEvent(button, (frame.mouseButtons & (1u << button)) != 0);
+    }
+    if (frame.mouseWheel != 0.0f || frame.mouseWheelH != 0.0f) {
+        io.AddMouseWheelEvent(frame.mouseWheelH, frame.mouseWheel);
+    }
+    for (unsigned int c : frame.characters) {
+        io.AddInputCharacter(c);
+    }
+}
+
+FrameTimeStats summarizeFrameTimes(std::vector<double> frameMs) {
+    FrameTimeStats stats;
+    stats.frames = frameMs.size();
+    if (frameMs.empty()) {
+        return stats;
+    }
+
+    // Nearest-rank percentiles
+    std::sort(frameMs.begin(), frameMs.end());
+    auto percentile = [&frameMs](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p * frameMs.size()));
+        return frameMs[std::max<size_t>(rank, 1) - 1];
+    };
+    for (double ms : frameMs) {
+        stats.mean += ms;
+    }
+    stats.mean /= frameMs.size();
+    stats.p50 = percentile(0.50);
+    stats.p99 = percentile(0.99);
+    stats.max = frameMs.back();
+    return stats;
+}
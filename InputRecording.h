@@ -0,0 +1,53 @@
+#pragma once
+
+#include "imgui.h"
+#include <cfloat>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ImGui input of one frame, as it stood after ImGui::NewFrame()
+struct InputFrame {
+    float deltaTime = 0.0f;
+    ImVec2 displaySize = ImVec2(0.0f, 0.0f);
+    ImVec2 mousePos = ImVec2(-FLT_MAX, -FLT_MAX);
+    uint32_t mouseButtons = 0;          // bit per ImGuiMouseButton
+    float mouseWheel = 0.0f;
+    float mouseWheelH = 0.0f;
+    uint32_t modifiers = 0;             // ImGuiMod_Ctrl/Shift/Alt/Super, as in io.KeyMods
+    std::vector<int> keys;              // ImGuiKey values held down, sorted
+    std::vector<unsigned int> characters;
+};
+
+// A captured session: the editor view it started from and the input of every frame.
+//
+// Frames hold input state, not events, so replaying them with the event queue trickling
+// off reproduces what the editor saw frame by frame. Key codes are ImGuiKey values, so a
+// recording only replays with the ImGui version it was made with.
+struct InputRecording {
+    std::string graphName;
+    ImVec2 canvasOffset = ImVec2(0.0f, 0.0f);
+    float canvasScale = 1.0f;
+    std::vector<InputFrame> frames;
+
+    bool save(const std::string& filename) const;
+    bool load(const std::string& filename);
+};
+
+// Read the current frame's input; call after ImGui::NewFrame()
+InputFrame captureInputFrame();
+
+// Queue a recorded frame as input events; call before ImGui::NewFrame(). Keys are sent as
+// transitions from the previous frame (nullptr for the first one).
+void applyInputFrame(const InputFrame& frame, const InputFrame* previous);
+
+// Frame time distribution of a replay, in milliseconds
+struct FrameTimeStats {
+    size_t frames = 0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+FrameTimeStats summarizeFrameTimes(std::vector<double> frameMs);
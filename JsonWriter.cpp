@@ -0,0 +1,224 @@
+#include "JsonWriter.h"
+#include <cmath>
+#include <cstring>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+const uint64_t FNV_OFFSET = 14695981039346656037ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+} // namespace
+
+JsonWriter::JsonWriter(std::ostream& out, bool prettyPrint)
+    : output(out), pretty(prettyPrint), buffer(BUFFER_SIZE) {
+}
+
+JsonWriter::~JsonWriter() {
+    flush();
+}
+
+void JsonWriter::flush() {
+    if (used > 0) {
+        output.write(buffer.data(), static_cast<std::streamsize>(used));
+        used = 0;
+    }
+}
+
+void JsonWriter::beginHash() {
+    hash = FNV_OFFSET;
+    hashing = true;
+}
+
+uint64_t JsonWriter::endHash() {
+    hashing = false;
+    return hash;
+}
+
+void JsonWriter::write(const char* data, size_t size) {
+    if (hashing) {
+        for (size_t i = 0; i < size; ++i) {
+            if (data[i] != '\r') {
+                hash = (hash ^ static_cast<unsigned char>(data[i])) * FNV_PRIME;
+            }
+        }
+    }
+    if (capture) {
+        capture->append(data, size);
+    }
+
+    if (size > BUFFER_SIZE - used) {
+        flush();
+        if (size >= BUFFER_SIZE) {
+            output.write(data, static_cast<std::streamsize>(size));
+            return;
+        }
+    }
+    std::memcpy(buffer.data() + used, data, size);
+    used += size;
+}
+
+void JsonWriter::newline() {
+    // dump(2): every element on its own line, indented two spaces per level
+    static const char spaces[] = "                                                                ";
+    write('\n');
+    size_t indent = scopes.size() * 2;
+    while (indent > 0) {
+        size_t chunk = indent < sizeof(spaces) - 1 ? indent : sizeof(spaces) - 1;
+        write(spaces, chunk);
+        indent -= chunk;
+    }
+}
+
+void JsonWriter::beforeValue() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (scopes.empty()) {
+        return;
+    }
+
+    Scope& scope = scopes.back();
+    if (!scope.empty) {
+        write(',');
+    }
+    scope.empty = false;
+    if (pretty) {
+        newline();
+    }
+}
+
+void JsonWriter::beginObject() {
+    beforeValue();
+    write('{');
+    scopes.push_back({ false, true });
+}
+
+void JsonWriter::endObject() {
+    bool empty = scopes.back().empty;
+    scopes.pop_back();
+    if (pretty && !empty) {
+        newline();
+    }
+    write('}');
+}
+
+void JsonWriter::beginArray() {
+    beforeValue();
+    write('[');
+    scopes.push_back({ true, true });
+}
+
+void JsonWriter::endArray() {
+    bool empty = scopes.back().empty;
+    scopes.pop_back();
+    if (pretty && !empty) {
+        newline();
+    }
+    write(']');
+}
+
+void JsonWriter::key(const std::string& name) {
+    beforeValue();
+    writeEscaped(name);
+    if (pretty) {
+        write(": ", 2);
+    }
+    else {
+        write(':');
+    }
+    afterKey = true;
+}
+
+void JsonWriter::value(const std::string& text) {
+    beforeValue();
+    writeEscaped(text);
+}
+
+void JsonWriter::value(const char* text) {
+    value(std::string(text));
+}
+
+void JsonWriter::value(double number) {
+    beforeValue();
+
+    // Same shortest round-trip formatting as nlohmann's serializer
+    if (!std::isfinite(number)) {
+        write("null", 4);
+        return;
+    }
+    char digits[64];
+    char* end = nlohmann::detail::to_chars(digits, digits + sizeof(digits), number);
+    write(digits, static_cast<size_t>(end - digits));
+}
+
+void JsonWriter::value(bool flag) {
+    beforeValue();
+    if (flag) {
+        write("true", 4);
+    }
+    else {
+        write("false", 5);
+    }
+}
+
+void JsonWriter::rawValue(const char* text, size_t size) {
+    beforeValue();
+
+    // Line endings are left to the stream; compact mode also drops whitespace outside strings
+    size_t start = 0;
+    bool inString = false;
+    for (size_t i = 0; i < size; ++i) {
+        char c = text[i];
+        if (inString) {
+            if (c == '\\') {
+                ++i;
+            }
+            else if (c == '"') {
+                inString = false;
+            }
+        }
+        else if (c == '"') {
+            inString = true;
+        }
+        else if (c == '\r' || (!pretty && (c == ' ' || c == '\n' || c == '\t'))) {
+            write(text + start, i - start);
+            start = i + 1;
+        }
+    }
+    write(text + start, size - start);
+}
+
+void JsonWriter::writeEscaped(const std::string& text) {
+    static const char hexDigits[] = "0123456789abcdef";
+    write('"');
+
+    // Runs of plain bytes are copied in one go; bytes >= 0x80 pass through as UTF-8
+    size_t start = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        write(text.data() + start, i - start);
+        start = i + 1;
+        switch (c) {
+        case '"': write("\\\"", 2); break;
+        case '\\': write("\\\\", 2); break;
+        case '\b': write("\\b", 2); break;
+        case '\f': write("\\f", 2); break;
+        case '\n': write("\\n", 2); break;
+        case '\r': write("\\r", 2); break;
+        case '\t': write("\\t", 2); break;
+        default: {
+            char escape[6] = { '\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 0xF] };
+            write(escape, 6);
+            break;
+        }
+        }
+    }
+    write(text.data() + start, text.size() - start);
+    write('"');
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Streaming JSON writer with its own output buffer.
+//
+// Values are written straight to the stream as they are produced, so no document is
+// built in memory. Pretty mode produces exactly what nlohmann::json::dump(2) produces
+// for the same values (keys must be written in sorted order, as std::map would keep
+// them); compact mode matches dump() without indentation.
+class JsonWriter {
+public:
+    JsonWriter(std::ostream& output, bool prettyPrint);
+    ~JsonWriter();
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+    void key(const std::string& name);
+
+    void value(const std::string& text);
+    void value(const char* text);
+    void value(double number);
+    void value(bool flag);
+
+    // Pre-serialized JSON value copied without '\r'; compact mode also strips its whitespace
+    void rawValue(const char* text, size_t size);
+
+    // FNV-1a hash of the bytes written between the two calls, as contentHash() computes it
+    void beginHash();
+    uint64_t endHash();
+
+    // Also append written bytes to the given string until the capture is cleared
+    void setCapture(std::string* target) { capture = target; }
+
+    void flush();
+    bool good() const { return output.good(); }
+
+private:
+    struct Scope {
+        bool isArray;
+        bool empty;
+    };
+
+    void beforeValue();
+    void newline();
+    void write(const char* data, size_t size);
+    void write(char c) { write(&c, 1); }
+    void writeEscaped(const std::string& text);
+
+    std::ostream& output;
+    bool pretty;
+    std::vector<Scope> scopes;
+    bool afterKey = false;
+
+    std::vector<char> buffer;
+    size_t used = 0;
+    uint64_t hash = 0;
+    bool hashing = false;
+    std::string* capture = nullptr;
+
+    static const size_t BUFFER_SIZE = 1 << 16;
+};
@@ -0,0 +1,176 @@
+#include "MachineFeed.h"
+#include <iostream>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+const uint32_t RING_MAGIC = 0x4d464431;     // "MFD1"
+const uint32_t RING_VERSION = 1;
+
+MachineFeed::~MachineFeed() {
+    close();
+}
+
+bool MachineFeed::create(const std::string& name) {
+    close();
+    if (!map(name, true)) {
+        return false;
+    }
+
+    // Fresh ring; the magic is published last so a consumer never sees a half-built header
+    new (ring) Ring();
+    ring->version = RING_VERSION;
+    ring->capacity = CAPACITY;
+    ring->sampleSize = sizeof(MachineSample);
+    ring->magic.store(RING_MAGIC, std::memory_order_release);
+    owner = true;
+    return true;
+}
+
+bool MachineFeed::open(const std::string& name) {
+    close();
+    if (!map(name, false)) {
+        return false;
+    }
+
+    if (ring->magic.load(std::memory_order_acquire) != RING_MAGIC) {
+        // Producer still setting up
+        close();
+        return false;
+    }
+    if (ring->version != RING_VERSION || ring->capacity != CAPACITY || ring->sampleSize != sizeof(MachineSample)) {
+        std::cerr << "Machine feed " << name << " has an incompatible layout" << std::endl;
+        close();
+        return false;
+    }
+
+    // Start with what the producer publishes from now on
+    ring->tail.store(ring->head.load(std::memory_order_acquire), std::memory_order_release);
+    return true;
+}
+
+bool MachineFeed::push(const MachineSample& sample) {
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    uint64_t tail = ring->tail.load(std::memory_order_acquire);
+    if (head - tail >= CAPACITY) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    ring->samples[head & (CAPACITY - 1)] = sample;
+    ring->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+#ifdef _WIN32
+
+bool MachineFeed::map(const std::string& name, bool creating) {
+    std::string objectName = "Local\\" + name;
+    HANDLE handle = creating
+        ? CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(Ring), objectName.c_str())
+        : OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, objectName.c_str());
+    if (!handle) {
+        if (creating) {
+            std::cerr << "Failed to create machine feed " << name << ": error " << GetLastError() << std::endl;
+        }
+        return false;
+    }
+
+    void* view = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(Ring));
+    if (!view) {
+        std::cerr << "Failed to map machine feed " << name << ": error " << GetLastError() << std::endl;
+        CloseHandle(handle);
+        return false;
+    }
+    mapping = handle;
+    ring = static_cast<Ring*>(view);
+    sharedName = name;
+    return true;
+}
+
+void MachineFeed::close() {
+    if (ring) {
+        UnmapViewOfFile(ring);
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+    }
+    ring = nullptr;
+    mapping = nullptr;
+    owner = false;
+    sharedName.clear();
+}
+
+#else
+
+bool MachineFeed::map(const std::string& name, bool creating) {
+    std::string objectName = "/" + name;
+    if (creating) {
+        // A crashed producer leaves its segment behind; consumers still attached keep theirs
+        shm_unlink(objectName.c_str());
+        fd = shm_open(objectName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd >= 0 && ftruncate(fd, sizeof(Ring)) != 0) {
+            std::cerr << "Failed to size machine feed " << name << ": " << strerror(errno) << std::endl;
+            ::close(fd);
+            shm_unlink(objectName.c_str());
+            fd = -1;
+            return false;
+        }
+    }
+    else {
+        fd = shm_open(objectName.c_str(), O_RDWR, 0);
+    }
+    if (fd < 0) {
+        if (creating || errno != ENOENT) {
+            std::cerr << "Failed to open machine feed " << name << ": " << strerror(errno) << std::endl;
+        }
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Ring)) {
+        // Exists but not sized yet
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    void* memory = mmap(nullptr, sizeof(Ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        std::cerr << "Failed to map machine feed " << name << ": " << strerror(errno) << std::endl;
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    ring = static_cast<Ring*>(memory);
+    sharedName = name;
+    return true;
+}
+
+void MachineFeed::close() {
+    if (ring) {
+        munmap(ring, sizeof(Ring));
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    if (owner) {
+        shm_unlink(("/" + sharedName).c_str());
+    }
+    ring = nullptr;
+    fd = -1;
+    owner = false;
+    sharedName.clear();
+}
+
+#endif
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Live position of one machine (one graph) as reported by the motion controller.
+// Plain data with fixed-size ids, so it can be copied in and out of shared memory.
+struct MachineSample {
+    static const size_t ID_SIZE = 32;
+
+    uint64_t timestampNs = 0;       // producer's steady clock
+    float progress = 0.0f;          // 0 at fromNode, 1 at toNode
+    char graph[ID_SIZE] = {};
+    char fromNode[ID_SIZE] = {};
+    char toNode[ID_SIZE] = {};      // empty while standing at fromNode
+
+    // Copy an id, truncated to fit
+    static void setId(char (&target)[ID_SIZE], const std::string& id) {
+        size_t size = std::min(id.size(), ID_SIZE - 1);
+        std::memcpy(target, id.data(), size);
+        target[size] = '\0';
+    }
+};
+
+// Lock-free single-producer/single-consumer ring of MachineSamples in named shared memory
+// (POSIX shm_open, or a named file mapping on Windows).
+//
+// The producer owns the head index and the consumer the tail; each only reads the other's
+// index, so neither side ever waits. When the consumer falls a full ring behind, new
+// samples are dropped and counted rather than overwriting ones it may be reading.
+class MachineFeed {
+public:
+    static const uint32_t CAPACITY = 4096;      // power of two; 4 s of one machine at 1 kHz
+
+    MachineFeed() = default;
+    ~MachineFeed();
+
+    MachineFeed(const MachineFeed&) = delete;
+    MachineFeed& operator=(const MachineFeed&) = delete;
+
+    // Producer: create the channel, replacing one left behind by an earlier producer
+    bool create(const std::string& name);
+
+    // Consumer: attach to a channel a producer created; fails quietly if there is none yet
+    bool open(const std::string& name);
+
+    void close();
+    bool isOpen() const { return ring != nullptr; }
+
+    // Producer: publish a sample; false if the ring is full and the sample was dropped
+    bool push(const MachineSample& sample);
+
+    // Consumer: visit every sample published since the last call, oldest first. Slots are
+    // read in place and released together afterwards, so nothing is copied or allocated.
+    template <typename Visitor>
+    size_t drain(Visitor&& visit) {
+        if (!ring) {
+            return 0;
+        }
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        for (uint64_t i = tail; i < head; ++i) {
+            visit(ring->samples[i & (CAPACITY - 1)]);
+        }
+        ring->tail.store(head, std::memory_order_release);
+        return static_cast<size_t>(head - tail);
+    }
+
+    uint64_t getDroppedCount() const { return ring ? ring->dropped.load(std::memory_order_relaxed) : 0; }
+
+private:
+    // Layout of the shared memory; the indices sit on their own cache lines
+    struct Ring {
+        std::atomic<uint32_t> magic;        // set last by the producer once the ring is ready
+        uint32_t version;
+        uint32_t capacity;
+        uint32_t sampleSize;
+        alignas(64) std::atomic<uint64_t> head;
+        alignas(64) std::atomic<uint64_t> tail;
+        alignas(64) std::atomic<uint64_t> dropped;
+        alignas(64) MachineSample samples[CAPACITY];
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring indices must be lock-free to be shared");
+
+    bool map(const std::string& name, bool creating);
+
+    Ring* ring = nullptr;
+    bool owner = false;
+    std::string sharedName;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+};
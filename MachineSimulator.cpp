@@ -0,0 +1,88 @@
+#include "MachineSimulator.h"
+#include <algorithm>
+#include <cmath>
+
+const double DWELL_SECONDS = 0.5;
+const double MOVE_SPEED = 300.0;        // units/s when the weights are not move times
+const double MIN_MOVE_SECONDS = 0.2;
+const double MAX_MOVE_SECONDS = 5.0;
+
+MachineSimulator::MachineSimulator(GraphModel& model, uint32_t seed) : rng(seed) {
+    std::vector<std::string> names = model.getGraphNames();
+    std::sort(names.begin(), names.end());
+    for (const auto& name : names) {
+        auto graph = model.getGraph(name);
+        if (!graph || graph->edges.empty()) {
+            continue;
+        }
+
+        Machine machine;
+        machine.graph = graph;
+        graph->updateGeometryIndex();
+        machine.outgoing.resize(graph->nodes.size());
+        for (size_t e = 0; e < graph->edges.size(); ++e) {
+            machine.outgoing[graph->edgeFromSlot[e]].push_back(static_cast<uint32_t>(e));
+        }
+
+        // Start where the controller would: at Home if there is one
+        auto home = graph->nodeIndex.find("Home");
+        machine.node = home != graph->nodeIndex.end() ? static_cast<uint32_t>(home->second) : 0;
+        machine.duration = DWELL_SECONDS;
+        MachineSample::setId(machine.sample.graph, name);
+        MachineSample::setId(machine.sample.fromNode, graph->nodes[machine.node]->id);
+        machines.push_back(std::move(machine));
+    }
+}
+
+void MachineSimulator::nextLeg(Machine& machine) {
+    const Graph& graph = *machine.graph;
+    if (machine.edge >= 0) {
+        // Arrived: dwell at the end node
+        machine.node = graph.edgeToSlot[machine.edge];
+        machine.edge = -1;
+        machine.duration = DWELL_SECONDS;
+        MachineSample::setId(machine.sample.fromNode, graph.nodes[machine.node]->id);
+        machine.sample.toNode[0] = '\0';
+        machine.sample.progress = 0.0f;
+        return;
+    }
+
+    const auto& choices = machine.outgoing[machine.node];
+    if (choices.empty()) {
+        // Dead end: stay put
+        machine.duration = DWELL_SECONDS;
+        return;
+    }
+
+    uint32_t edge = choices[rng() % choices.size()];
+    const Node& from = *graph.nodes[graph.edgeFromSlot[edge]];
+    const Node& to = *graph.nodes[graph.edgeToSlot[edge]];
+    double seconds = graph.weightModel.mode == WeightModel::Mode::MoveTime
+        ? graph.edges[edge]->weight
+        : std::hypot(to.x - from.x, to.y - from.y) / MOVE_SPEED;
+    machine.edge = edge;
+    machine.duration = std::max(MIN_MOVE_SECONDS, std::min(seconds, MAX_MOVE_SECONDS));
+    MachineSample::setId(machine.sample.toNode, to.id);
+}
+
+void MachineSimulator::advance(double seconds) {
+    for (auto& machine : machines) {
+        machine.elapsed += seconds;
+        while (machine.elapsed >= machine.duration) {
+            machine.elapsed -= machine.duration;
+            nextLeg(machine);
+        }
+        machine.sample.progress = machine.edge >= 0 ? static_cast<float>(machine.elapsed / machine.duration) : 0.0f;
+    }
+}
+
+size_t MachineSimulator::publish(MachineFeed& feed, uint64_t timestampNs) {
+    size_t dropped = 0;
+    for (auto& machine : machines) {
+        machine.sample.timestampNs = timestampNs;
+        if (!feed.push(machine.sample)) {
+            ++dropped;
+        }
+    }
+    return dropped;
+}
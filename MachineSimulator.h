@@ -0,0 +1,41 @@
+#pragma once
+
+#include "GraphModel.h"
+#include "MachineFeed.h"
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Stand-in for the motion controller, for testing the live overlay without hardware.
+//
+// Every graph with edges gets one machine that walks random outgoing edges, pausing at
+// each node. Moves take the edge weight in seconds under the move-time weight model and
+// the straight-line distance at a fixed speed otherwise.
+class MachineSimulator {
+public:
+    MachineSimulator(GraphModel& model, uint32_t seed);
+
+    void advance(double seconds);
+
+    // Publish the current state of every machine; returns the number of samples dropped
+    size_t publish(MachineFeed& feed, uint64_t timestampNs);
+
+    size_t getMachineCount() const { return machines.size(); }
+
+private:
+    struct Machine {
+        std::shared_ptr<Graph> graph;
+        std::vector<std::vector<uint32_t>> outgoing;    // edge slots by node slot
+        uint32_t node = 0;
+        int64_t edge = -1;          // edge in transit, -1 while dwelling at 'node'
+        double elapsed = 0.0;
+        double duration = 0.0;
+        MachineSample sample;
+    };
+
+    void nextLeg(Machine& machine);
+
+    std::vector<Machine> machines;
+    std::mt19937 rng;
+};
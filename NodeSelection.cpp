@@ -0,0 +1,104 @@
+#include "NodeSelection.h"
+#include <algorithm>
+
+NodeSelection::~NodeSelection() {
+    detach();
+}
+
+void NodeSelection::attach(const std::shared_ptr<Graph>& target) {
+    graph = target;
+    if (graph) {
+        listenerId = graph->addListener(
+            [this](GraphChange change, const std::string&, const std::string&) {
+            onGraphChanged(change);
+        });
+    }
+}
+
+void NodeSelection::detach() {
+    if (graph) {
+        graph->removeListener(listenerId);
+        graph = nullptr;
+    }
+    listenerId = 0;
+}
+
+void NodeSelection::update(const std::shared_ptr<Graph>& target) {
+    if (target != graph) {
+        detach();
+        clear();
+        attach(target);
+    }
+    if (graph && slotCount != graph->nodes.size()) {
+        resize(graph->nodes.size());
+    }
+}
+
+void NodeSelection::resize(size_t slots) {
+    // Bits past the old end are already zero, and a shrink only happens after clear()
+    words.resize((slots + 63) / 64, 0);
+    slotCount = slots;
+}
+
+void NodeSelection::add(size_t slot) {
+    if (slot < slotCount && !contains(slot)) {
+        words[slot >> 6] |= uint64_t(1) << (slot & 63);
+        ++count;
+    }
+}
+
+void NodeSelection::remove(size_t slot) {
+    if (contains(slot)) {
+        words[slot >> 6] &= ~(uint64_t(1) << (slot & 63));
+        --count;
+    }
+}
+
+void NodeSelection::toggle(size_t slot) {
+    if (contains(slot)) {
+        remove(slot);
+    }
+    else {
+        add(slot);
+    }
+}
+
+void NodeSelection::clear() {
+    std::fill(words.begin(), words.end(), 0);
+    count = 0;
+}
+
+void NodeSelection::getSlots(std::vector<uint32_t>& slots) const {
+    slots.clear();
+    slots.reserve(count);
+    for (size_t w = 0; w < words.size(); ++w) {
+        uint64_t bits = words[w];
+        for (uint32_t slot = static_cast<uint32_t>(w * 64); bits != 0; ++slot, bits >>= 1) {
+            if (bits & 1) {
+                slots.push_back(slot);
+            }
+        }
+    }
+}
+
+std::vector<std::string> NodeSelection::getIds() const {
+    std::vector<uint32_t> slots;
+    getSlots(slots);
+    std::vector<std::string> ids;
+    ids.reserve(slots.size());
+    for (uint32_t slot : slots) {
+        ids.push_back(graph->nodes[slot]->id);
+    }
+    return ids;
+}
+
+void NodeSelection::onGraphChanged(GraphChange change) {
+    if (change == GraphChange::NodeAdded) {
+        // Appended in the next slot
+        resize(slotCount + 1);
+    }
+    else if (change == GraphChange::NodeRemoved || change == GraphChange::Reset) {
+        clear();
+        resize(graph->nodes.size());
+    }
+}
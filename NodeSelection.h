@@ -0,0 +1,52 @@
+#pragma once
+
+#include "GraphModel.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Set of selected nodes of a graph, one bit per node slot.
+//
+// Membership tests and toggles are O(1); listing the selection skips empty 64-slot words.
+// Node additions grow the set, while node removals and bulk changes shift slots and clear
+// it.
+class NodeSelection {
+public:
+    NodeSelection() = default;
+    ~NodeSelection();
+
+    NodeSelection(const NodeSelection&) = delete;
+    NodeSelection& operator=(const NodeSelection&) = delete;
+
+    // Track the given graph; switching graphs clears the selection
+    void update(const std::shared_ptr<Graph>& target);
+
+    bool contains(size_t slot) const {
+        return slot < slotCount && (words[slot >> 6] >> (slot & 63)) & 1;
+    }
+    void add(size_t slot);
+    void remove(size_t slot);
+    void toggle(size_t slot);
+    void clear();
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // Selected slots in ascending order
+    void getSlots(std::vector<uint32_t>& slots) const;
+    std::vector<std::string> getIds() const;
+
+private:
+    void attach(const std::shared_ptr<Graph>& target);
+    void detach();
+    void onGraphChanged(GraphChange change);
+    void resize(size_t slots);
+
+    std::shared_ptr<Graph> graph;
+    size_t listenerId = 0;
+
+    std::vector<uint64_t> words;
+    size_t slotCount = 0;
+    size_t count = 0;
+};
@@ -0,0 +1,111 @@
+#include "ParallelDrawList.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstring>
+
+// A few chunks per thread, so one dense region does not leave the other threads idle
+const size_t CHUNKS_PER_THREAD = 4;
+
+void ParallelDrawList::build(ImDrawList* target, size_t count, const DrawRange& body) {
+    size_t chunkCount = std::min(count / std::max<size_t>(1, minChunkSize), pool.size() * CHUNKS_PER_THREAD);
+    if (pool.size() <= 1 || chunkCount <= 1) {
+        body(target, 0, count);
+        return;
+    }
+
+    while (chunks.size() < chunkCount) {
+        chunks.push_back(std::make_unique<Chunk>());
+    }
+
+    // Copy this frame's shared data (font, atlas UVs, tessellation settings), keeping each
+    // chunk's own scratch buffer
+    for (size_t c = 0; c < chunkCount; ++c) {
+        ImVector<ImVec2> scratch;
+        scratch.swap(chunks[c]->sharedData.TempBuffer);
+        chunks[c]->sharedData = *target->_Data;
+        chunks[c]->sharedData.TempBuffer.swap(scratch);
+    }
+
+    // Chunk lists start from the target's current state so their commands can be appended as is
+    ImVec4 clipRect = target->_CmdHeader.ClipRect;
+    ImTextureID texture = target->_CmdHeader.TextureId;
+    bool ran = pool.tryParallelFor(chunkCount, [&](size_t c) {
+        PROFILE_SCOPE("ParallelDrawList::chunk");
+        ImDrawList* list = &chunks[c]->drawList;
+        list->_ResetForNewFrame();
+        list->Flags = target->Flags;
+        list->PushClipRect(ImVec2(clipRect.x, clipRect.y), ImVec2(clipRect.z, clipRect.w));
+        list->PushTextureID(texture);
+        body(list, count * c / chunkCount, count * (c + 1) / chunkCount);
+    });
+
+    if (!ran) {
+        body(target, 0, count);
+        return;
+    }
+
+    PROFILE_SCOPE("ParallelDrawList::append");
+    for (size_t c = 0; c < chunkCount; ++c) {
+        append(target, chunks[c]->drawList);
+    }
+}
+
+void ParallelDrawList::append(ImDrawList* target, const ImDrawList& chunk) {
+    if (chunk.IdxBuffer.Size == 0) {
+        return;
+    }
+
+    // Both buffers are copied once. With vertex offsets every command keeps its indices and
+    // only its vertex window moves; without them the chunk is one window and its indices move.
+    bool moveIndices = !(target->Flags & ImDrawListFlags_AllowVtxOffset);
+    unsigned int vtxShift = moveIndices ? target->_CmdHeader.VtxOffset : static_cast<unsigned int>(target->VtxBuffer.Size);
+    ImDrawIdx idxShift = moveIndices ? static_cast<ImDrawIdx>(target->_VtxCurrentIdx) : 0;
+    unsigned int idxBase = static_cast<unsigned int>(target->IdxBuffer.Size);
+
+    int vtxBase = target->VtxBuffer.Size;
+    target->VtxBuffer.resize(vtxBase + chunk.VtxBuffer.Size);
+    memcpy(target->VtxBuffer.Data + vtxBase, chunk.VtxBuffer.Data, chunk.VtxBuffer.Size * sizeof(ImDrawVert));
+    target->IdxBuffer.resize(static_cast<int>(idxBase) + chunk.IdxBuffer.Size);
+    ImDrawIdx* indices = target->IdxBuffer.Data + idxBase;
+    if (idxShift == 0) {
+        memcpy(indices, chunk.IdxBuffer.Data, chunk.IdxBuffer.Size * sizeof(ImDrawIdx));
+    }
+    else {
+        for (int i = 0; i < chunk.IdxBuffer.Size; ++i) {
+            indices[i] = static_cast<ImDrawIdx>(chunk.IdxBuffer.Data[i] + idxShift);
+        }
+    }
+
+    // The target's open command is replaced by the chunk's, merged where they continue each other
+    if (target->CmdBuffer.back().ElemCount == 0 && target->CmdBuffer.back().UserCallback == nullptr) {
+        target->CmdBuffer.pop_back();
+    }
+    for (const ImDrawCmd& cmd : chunk.CmdBuffer) {
+        if (cmd.ElemCount == 0) {
+            continue;
+        }
+        ImDrawCmd moved = cmd;
+        moved.VtxOffset += vtxShift;
+        moved.IdxOffset += idxBase;
+        if (!target->CmdBuffer.empty()) {
+            ImDrawCmd& last = target->CmdBuffer.back();
+            if (last.UserCallback == nullptr && last.VtxOffset == moved.VtxOffset &&
+                last.TextureId == moved.TextureId && memcmp(&last.ClipRect, &moved.ClipRect, sizeof(ImVec4)) == 0 &&
+                last.IdxOffset + last.ElemCount == moved.IdxOffset) {
+                last.ElemCount += moved.ElemCount;
+                continue;
+            }
+        }
+        target->CmdBuffer.push_back(moved);
+    }
+
+    // Whatever the target draws next goes into a new command, in a new vertex window if
+    // the chunk's vertices were placed by offset
+    if (!moveIndices) {
+        target->_CmdHeader.VtxOffset = static_cast<unsigned int>(target->VtxBuffer.Size);
+    }
+    target->_VtxCurrentIdx = static_cast<unsigned int>(target->VtxBuffer.Size) - target->_CmdHeader.VtxOffset;
+    target->_VtxWritePtr = target->VtxBuffer.Data + target->VtxBuffer.Size;
+    target->_IdxWritePtr = target->IdxBuffer.Data + target->IdxBuffer.Size;
+    target->AddDrawCmd();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include "imgui.h"
+#include "imgui_internal.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Builds draw-list geometry for a large range of items on the thread pool.
+//
+// The range is cut into chunks; each chunk is drawn into its own ImDrawList by whichever
+// thread picks it up, and the chunks are then appended to the target list in chunk order,
+// so the result is the same as drawing the whole range on one thread. The chunk lists
+// keep their buffers between frames.
+//
+// The body must only touch the draw list it is given plus read-only state. Each chunk list
+// has its own copy of ImGui's shared draw data, whose scratch buffer is written while
+// drawing; fonts and the rest of the shared data are read-only during a frame.
+class ParallelDrawList {
+public:
+    using DrawRange = std::function<void(ImDrawList* drawList, size_t begin, size_t end)>;
+
+    explicit ParallelDrawList(ThreadPool& threadPool = ThreadPool::shared()) : pool(threadPool) {}
+
+    // Draw items [0, count) into target with the target's current clip rect and texture.
+    // Small ranges, a single-threaded pool or a busy pool draw straight into the target.
+    void build(ImDrawList* target, size_t count, const DrawRange& body);
+
+    // Smallest number of items worth a chunk of its own
+    void setMinChunkSize(size_t size) { minChunkSize = size; }
+
+private:
+    struct Chunk {
+        ImDrawListSharedData sharedData;
+        ImDrawList drawList;
+
+        Chunk() : drawList(&sharedData) {}
+    };
+
+    void append(ImDrawList* target, const ImDrawList& chunk);
+
+    ThreadPool& pool;
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    size_t minChunkSize = 2048;
+};
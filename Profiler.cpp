@@ -0,0 +1,206 @@
+#include "Profiler.h"
+#include "JsonWriter.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+const size_t RING_CAPACITY = 1 << 15;    // events kept per thread
+const double AVERAGE_WEIGHT = 0.05;
+
+// Written only by its owning thread; readers take a snapshot bounded by writeIndex
+struct ThreadBuffer {
+    std::vector<ProfileEvent> events = std::vector<ProfileEvent>(RING_CAPACITY);
+    std::atomic<uint64_t> writeIndex{ 0 };
+    uint64_t frameIndex = 0;
+    uint32_t threadId = 0;
+    std::string threadName;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;   // kept after their thread exits
+    std::atomic<bool> enabled{ true };
+    std::vector<Profiler::ZoneStats> frameStats;
+    double frameMs = 0.0;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+ThreadBuffer& threadBuffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        buffer = std::make_shared<ThreadBuffer>();
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        buffer->threadId = static_cast<uint32_t>(reg.buffers.size() + 1);
+        buffer->threadName = "Thread " + std::to_string(buffer->threadId);
+        reg.buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+// Copies events [from, writeIndex) that have not been overwritten by the time the copy is done
+void snapshot(const ThreadBuffer& buffer, uint64_t from, std::vector<ProfileEvent>& out) {
+    uint64_t end = buffer.writeIndex.load(std::memory_order_acquire);
+    uint64_t begin = std::max(from, end > RING_CAPACITY ? end - RING_CAPACITY : 0);
+    size_t first = out.size();
+    for (uint64_t i = begin; i < end; ++i) {
+        out.push_back(buffer.events[i % RING_CAPACITY]);
+    }
+
+    // The owner may have lapped the oldest slots while they were copied
+    uint64_t after = buffer.writeIndex.load(std::memory_order_acquire);
+    if (after > RING_CAPACITY && after - RING_CAPACITY >= begin) {
+        size_t lost = static_cast<size_t>(std::min(after - RING_CAPACITY + 1 - begin, end - begin));
+        out.erase(out.begin() + first, out.begin() + first + lost);
+    }
+}
+
+} // namespace
+
+uint64_t Profiler::now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Profiler::record(const char* name, uint64_t start, uint64_t end) {
+    ThreadBuffer& buffer = threadBuffer();
+    uint64_t index = buffer.writeIndex.load(std::memory_order_relaxed);
+    buffer.events[index % RING_CAPACITY] = { name, start, end };
+    buffer.writeIndex.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::setEnabled(bool enabled) {
+    registry().enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Profiler::isEnabled() {
+    return registry().enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::setThreadName(const std::string& name) {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    buffer.threadName = name;
+}
+
+void Profiler::endFrame() {
+    ThreadBuffer& buffer = threadBuffer();
+    std::vector<ProfileEvent> events;
+    snapshot(buffer, buffer.frameIndex, events);
+    buffer.frameIndex = buffer.writeIndex.load(std::memory_order_relaxed);
+
+    // Zones are keyed by their literal's address; the list stays small
+    Registry& reg = registry();
+    for (auto& zone : reg.frameStats) {
+        zone.calls = 0;
+        zone.lastMs = 0.0;
+    }
+
+    uint64_t frameStart = UINT64_MAX;
+    uint64_t frameEnd = 0;
+    for (const auto& event : events) {
+        auto it = std::find_if(reg.frameStats.begin(), reg.frameStats.end(),
+            [&event](const ZoneStats& zone) { return zone.name == event.name; });
+        if (it == reg.frameStats.end()) {
+            ZoneStats zone;
+            zone.name = event.name;
+            reg.frameStats.push_back(zone);
+            it = reg.frameStats.end() - 1;
+        }
+        it->calls++;
+        it->lastMs += (event.end - event.start) / 1e6;
+        frameStart = std::min(frameStart, event.start);
+        frameEnd = std::max(frameEnd, event.end);
+    }
+
+    for (auto& zone : reg.frameStats) {
+        zone.averageMs += (zone.lastMs - zone.averageMs) * AVERAGE_WEIGHT;
+    }
+    reg.frameMs = events.empty() ? 0.0 : (frameEnd - frameStart) / 1e6;
+}
+
+const std::vector<Profiler::ZoneStats>& Profiler::getFrameStats() {
+    return registry().frameStats;
+}
+
+double Profiler::getFrameMs() {
+    return registry().frameMs;
+}
+
+bool Profiler::writeChromeTrace(const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << filename << std::endl;
+        return false;
+    }
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        buffers = registry().buffers;
+    }
+
+    // Complete ("X") events in microseconds, plus one name record per thread
+    JsonWriter writer(file, false);
+    writer.beginObject();
+    writer.key("displayTimeUnit");
+    writer.value("ns");
+    writer.key("traceEvents");
+    writer.beginArray();
+
+    std::vector<ProfileEvent> events;
+    for (const auto& buffer : buffers) {
+        writer.beginObject();
+        writer.key("args");
+        writer.beginObject();
+        writer.key("name");
+        {
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            writer.value(buffer->threadName);
+        }
+        writer.endObject();
+        writer.key("name");
+        writer.value("thread_name");
+        writer.key("ph");
+        writer.value("M");
+        writer.key("pid");
+        writer.value(1.0);
+        writer.key("tid");
+        writer.value(static_cast<double>(buffer->threadId));
+        writer.endObject();
+
+        events.clear();
+        snapshot(*buffer, 0, events);
+        for (const auto& event : events) {
+            writer.beginObject();
+            writer.key("dur");
+            writer.value((event.end - event.start) / 1000.0);
+            writer.key("name");
+            writer.value(event.name);
+            writer.key("ph");
+            writer.value("X");
+            writer.key("pid");
+            writer.value(1.0);
+            writer.key("tid");
+            writer.value(static_cast<double>(buffer->threadId));
+            writer.key("ts");
+            writer.value(event.start / 1000.0);
+            writer.endObject();
+        }
+    }
+
+    writer.endArray();
+    writer.endObject();
+    writer.flush();
+    return file.good();
+}
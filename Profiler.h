@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scoped-timer instrumentation.
+//
+// PROFILE_SCOPE("name") times the enclosing scope. Each thread records into its own ring
+// buffer, so recording takes no locks; the buffers are only read when a trace is written
+// or the UI thread folds its last frame into per-zone statistics. Names must be string
+// literals (they are stored by pointer).
+//
+// Build with GRAPH_PROFILING=0 to compile every PROFILE_SCOPE out.
+#ifndef GRAPH_PROFILING
+#define GRAPH_PROFILING 1
+#endif
+
+// One completed zone, timestamps in nanoseconds on the steady clock
+struct ProfileEvent {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+class Profiler {
+public:
+    struct ZoneStats {
+        const char* name = nullptr;
+        uint32_t calls = 0;
+        double lastMs = 0.0;        // inclusive time in the last frame
+        double averageMs = 0.0;     // exponential moving average over frames
+    };
+
+    static uint64_t now();
+    static void record(const char* name, uint64_t start, uint64_t end);
+
+    // Runtime switch on top of the compile-time one
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    // Label for the calling thread in exported traces
+    static void setThreadName(const std::string& name);
+
+    // Fold the calling thread's zones since the previous call into the frame statistics
+    static void endFrame();
+    static const std::vector<ZoneStats>& getFrameStats();
+    static double getFrameMs();
+
+    // Everything still in the ring buffers, as Chrome trace-event JSON (chrome://tracing, Perfetto)
+    static bool writeChromeTrace(const std::string& filename);
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* zoneName)
+        : name(zoneName), start(Profiler::isEnabled() ? Profiler::now() : 0) {
+    }
+
+    ~ProfileScope() {
+        if (start != 0) {
+            Profiler::record(name, start, Profiler::now());
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    uint64_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if GRAPH_PROFILING
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
@@ -0,0 +1,260 @@
+#include "RouteProtocol.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace RouteProtocol {
+
+FrameWriter::FrameWriter(std::string& target, uint32_t id, uint8_t typeOrStatus)
+    : buffer(target), start(target.size()) {
+    u32(0);
+    u32(id);
+    u8(typeOrStatus);
+}
+
+void FrameWriter::u16(uint16_t value) {
+    buffer.push_back(static_cast<char>(value & 0xff));
+    buffer.push_back(static_cast<char>(value >> 8));
+}
+
+void FrameWriter::u32(uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        buffer.push_back(static_cast<char>((value >> shift) & 0xff));
+    }
+}
+
+void FrameWriter::f32(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    u32(bits);
+}
+
+void FrameWriter::str(const std::string& value) {
+    str(value.data(), value.size());
+}
+
+void FrameWriter::str(const char* data, size_t size) {
+    size = std::min<size_t>(size, UINT16_MAX);
+    u16(static_cast<uint16_t>(size));
+    buffer.append(data, size);
+}
+
+void FrameWriter::finish() {
+    uint32_t size = static_cast<uint32_t>(buffer.size() - start - 4);
+    for (int i = 0; i < 4; ++i) {
+        buffer[start + i] = static_cast<char>((size >> (8 * i)) & 0xff);
+    }
+}
+
+bool FrameReader::u8(uint8_t& value) {
+    if (end - cursor < 1) {
+        return false;
+    }
+    value = static_cast<uint8_t>(*cursor++);
+    return true;
+}
+
+bool FrameReader::u16(uint16_t& value) {
+    if (end - cursor < 2) {
+        return false;
+    }
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(cursor);
+    value = static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+    cursor += 2;
+    return true;
+}
+
+bool FrameReader::u32(uint32_t& value) {
+    if (end - cursor < 4) {
+        return false;
+    }
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(cursor);
+    value = static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+        (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+    cursor += 4;
+    return true;
+}
+
+bool FrameReader::f32(float& value) {
+    uint32_t bits;
+    if (!u32(bits)) {
+        return false;
+    }
+    std::memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+bool FrameReader::str(std::string& value) {
+    uint16_t size;
+    if (!u16(size) || end - cursor < size) {
+        return false;
+    }
+    value.assign(cursor, size);
+    cursor += size;
+    return true;
+}
+
+size_t completeFrameSize(const char* data, size_t size) {
+    if (size < 4) {
+        return 0;
+    }
+    uint32_t frameSize;
+    FrameReader(data, 4).u32(frameSize);
+    if (frameSize > MAX_FRAME_SIZE) {
+        return SIZE_MAX;
+    }
+    return size >= 4 + static_cast<size_t>(frameSize) ? 4 + frameSize : 0;
+}
+
+Client::~Client() {
+    close();
+}
+
+bool Client::connect(const std::string& socketPath) {
+    close();
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long: " << socketPath << std::endl;
+        return false;
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        std::cerr << "Failed to connect to " << socketPath << ": " << strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void Client::close() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    fd = -1;
+    pending.clear();
+    received.clear();
+    receivedOffset = 0;
+}
+
+uint32_t Client::queuePath(const std::string& graph, const std::string& from, const std::string& to, size_t k) {
+    FrameWriter frame(pending, nextId, static_cast<uint8_t>(RequestType::Path));
+    frame.str(graph);
+    frame.u8(static_cast<uint8_t>(std::min(k, MAX_ROUTES)));
+    frame.str(from);
+    frame.str(to);
+    frame.finish();
+    return nextId++;
+}
+
+uint32_t Client::queueNeighbors(const std::string& graph, const std::string& node) {
+    FrameWriter frame(pending, nextId, static_cast<uint8_t>(RequestType::Neighbors));
+    frame.str(graph);
+    frame.str(node);
+    frame.finish();
+    return nextId++;
+}
+
+uint32_t Client::queueVersion() {
+    FrameWriter frame(pending, nextId, static_cast<uint8_t>(RequestType::Version));
+    frame.finish();
+    return nextId++;
+}
+
+bool Client::flush() {
+    size_t written = 0;
+    while (written < pending.size()) {
+        ssize_t count = ::send(fd, pending.data() + written, pending.size() - written, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            std::cerr << "Failed to send route requests: " << strerror(errno) << std::endl;
+            return false;
+        }
+        written += static_cast<size_t>(count);
+    }
+    pending.clear();
+    return true;
+}
+
+bool Client::readResponse(RequestType type, Response& response) {
+    // Read until a whole frame is buffered
+    size_t frameSize;
+    while ((frameSize = completeFrameSize(received.data() + receivedOffset, received.size() - receivedOffset)) == 0) {
+        if (receivedOffset > 0) {
+            received.erase(0, receivedOffset);
+            receivedOffset = 0;
+        }
+        char chunk[65536];
+        ssize_t count = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            std::cerr << "Route service closed the connection" << std::endl;
+            return false;
+        }
+        received.append(chunk, static_cast<size_t>(count));
+    }
+    if (frameSize == SIZE_MAX) {
+        std::cerr << "Oversized response from route service" << std::endl;
+        return false;
+    }
+
+    FrameReader reader(received.data() + receivedOffset + 4, frameSize - 4);
+    receivedOffset += frameSize;
+
+    uint8_t status;
+    response = Response();
+    if (!reader.u32(response.id) || !reader.u8(status) || !reader.u32(response.version)) {
+        return false;
+    }
+    response.status = static_cast<Status>(status);
+    if (response.status != Status::Ok) {
+        return true;
+    }
+
+    uint16_t count;
+    if (type == RequestType::Path) {
+        if (!reader.u16(count)) {
+            return false;
+        }
+        response.routes.resize(count);
+        for (auto& route : response.routes) {
+            uint16_t nodeCount;
+            if (!reader.f32(route.cost) || !reader.u16(nodeCount)) {
+                return false;
+            }
+            route.nodes.resize(nodeCount);
+            for (auto& node : route.nodes) {
+                if (!reader.str(node)) {
+                    return false;
+                }
+            }
+        }
+    }
+    else if (type == RequestType::Neighbors) {
+        for (auto* edges : { &response.outEdges, &response.inEdges }) {
+            if (!reader.u16(count)) {
+                return false;
+            }
+            edges->resize(count);
+            for (auto& edge : *edges) {
+                if (!reader.str(edge.first) || !reader.f32(edge.second)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return reader.atEnd();
+}
+
+} // namespace RouteProtocol
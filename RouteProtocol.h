@@ -0,0 +1,119 @@
+#pragma once
+
+#include "GraphRouting.h"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Binary protocol of the route query service (RouteServer) on a local stream socket.
+//
+// Every message is a frame: u32 size of the rest of the frame, u32 request id, u8 type (requests)
+// or status (responses), then the body. Integers and floats are little-endian, strings are
+// a u16 length and the bytes. A client may write any number of requests before reading;
+// the server answers each connection's requests in order, echoing the request id.
+//
+//   PATH request       str graph, u8 k, str from, str to
+//   NEIGHBORS request  str graph, str node
+//   VERSION request    (empty)
+//
+// Responses start with u32 snapshot version (bumped by every reload), then:
+//   PATH       u16 routes, each f32 cost, u16 nodes, str node...
+//   NEIGHBORS  u16 out-edges, each str node, f32 weight; then the in-edges alike
+//   VERSION    (empty)
+namespace RouteProtocol {
+
+enum class RequestType : uint8_t {
+    Path = 1,
+    Neighbors = 2,
+    Version = 3
+};
+
+enum class Status : uint8_t {
+    Ok = 0,
+    UnknownGraph = 1,
+    UnknownNode = 2,
+    BadRequest = 3
+};
+
+const uint32_t MAX_FRAME_SIZE = 1 << 20;
+const size_t MAX_ROUTES = 64;
+
+// Appends fields to a frame; finish() fills in the size
+class FrameWriter {
+public:
+    FrameWriter(std::string& target, uint32_t id, uint8_t typeOrStatus);
+
+    void u8(uint8_t value) { buffer.push_back(static_cast<char>(value)); }
+    void u16(uint16_t value);
+    void u32(uint32_t value);
+    void f32(float value);
+    void str(const std::string& value);
+    void str(const char* data, size_t size);
+    void finish();
+
+private:
+    std::string& buffer;
+    size_t start;
+};
+
+// Reads fields of one frame body; every read fails once the body is exhausted
+class FrameReader {
+public:
+    FrameReader(const char* data, size_t size) : cursor(data), end(data + size) {}
+
+    bool u8(uint8_t& value);
+    bool u16(uint16_t& value);
+    bool u32(uint32_t& value);
+    bool f32(float& value);
+    bool str(std::string& value);
+    bool atEnd() const { return cursor == end; }
+
+private:
+    const char* cursor;
+    const char* end;
+};
+
+// Size of the complete frame at the start of data, 0 if more bytes are needed, or
+// SIZE_MAX if the frame is larger than MAX_FRAME_SIZE
+size_t completeFrameSize(const char* data, size_t size);
+
+// A decoded response
+struct Response {
+    uint32_t id = 0;
+    Status status = Status::BadRequest;
+    uint32_t version = 0;
+    std::vector<Route> routes;
+    std::vector<std::pair<std::string, float>> outEdges;
+    std::vector<std::pair<std::string, float>> inEdges;
+};
+
+// Blocking client for scripts and tools: queue requests, flush them in one write, then read
+// the responses in order
+class Client {
+public:
+    Client() = default;
+    ~Client();
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    bool connect(const std::string& socketPath);
+    void close();
+
+    uint32_t queuePath(const std::string& graph, const std::string& from, const std::string& to, size_t k);
+    uint32_t queueNeighbors(const std::string& graph, const std::string& node);
+    uint32_t queueVersion();
+
+    bool flush();
+    bool readResponse(RequestType type, Response& response);
+
+private:
+    int fd = -1;
+    uint32_t nextId = 1;
+    std::string pending;
+    std::string received;
+    size_t receivedOffset = 0;
+};
+
+} // namespace RouteProtocol
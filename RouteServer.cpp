@@ -0,0 +1,436 @@
+#include "RouteServer.h"
+#include "GraphRouting.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace RouteProtocol;
+
+namespace {
+
+const int MAX_EVENTS = 64;
+const int POLL_TIMEOUT_MS = 100;                // file changes are checked at least this often
+const size_t MAX_PENDING_OUTPUT = 4 << 20;      // stop answering a client this far behind
+const size_t READ_CHUNK = 64 << 10;
+
+void writeError(std::string& output, uint32_t id, Status status, uint32_t version) {
+    FrameWriter frame(output, id, static_cast<uint8_t>(status));
+    frame.u32(version);
+    frame.finish();
+}
+
+} // namespace
+
+RouteServer::~RouteServer() {
+    // A reload still running signals wakeFd when done, so it must finish before that closes
+    if (pendingSnapshot.valid()) {
+        pendingSnapshot.wait();
+    }
+    for (auto& pair : connections) {
+        close(pair.first);
+    }
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(socketPath.c_str());
+    }
+    if (epollFd >= 0) {
+        close(epollFd);
+    }
+    if (wakeFd >= 0) {
+        close(wakeFd);
+    }
+}
+
+std::shared_ptr<RouteServer::Snapshot> RouteServer::loadSnapshot(const std::string& filename, uint32_t version) {
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->version = version;
+    if (!snapshot->model.loadFromFile(filename)) {
+        return nullptr;
+    }
+
+    // Everything queries touch is built up front, so the snapshot is read-only once served
+    for (const auto& name : snapshot->model.getGraphNames()) {
+        auto graph = snapshot->model.getGraph(name);
+        if (graph) {
+            graph->updateGeometryIndex();
+            routeCacheOf(*graph).snapshot(*graph);
+            snapshot->graphs[name] = graph;
+        }
+    }
+    return snapshot;
+}
+
+bool RouteServer::start(const std::string& filename, const std::string& path) {
+    modelFile = filename;
+    socketPath = path;
+    current = loadSnapshot(modelFile, 1);
+    if (!current) {
+        return false;
+    }
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long: " << socketPath << std::endl;
+        return false;
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    // A socket file nobody accepts on is left over from a server that did not exit cleanly
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe >= 0 && connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+        close(probe);
+        std::cerr << "Another route service is already listening on " << socketPath << std::endl;
+        return false;
+    }
+    if (probe >= 0) {
+        close(probe);
+    }
+    unlink(socketPath.c_str());
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listenFd, SOMAXCONN) != 0) {
+        std::cerr << "Failed to listen on " << socketPath << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) {
+        std::cerr << "Failed to set up the event loop: " << strerror(errno) << std::endl;
+        return false;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+    event.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
+    fileWatcher.watch(modelFile);
+    return true;
+}
+
+void RouteServer::stop() {
+    // Only async-signal-safe calls: may run in a signal handler
+    stopping = true;
+    uint64_t one = 1;
+    if (wakeFd >= 0) {
+        ssize_t written = write(wakeFd, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+void RouteServer::run() {
+    epoll_event events[MAX_EVENTS];
+    while (!stopping) {
+        int count = epoll_wait(epollFd, events, MAX_EVENTS, POLL_TIMEOUT_MS);
+        if (count < 0 && errno != EINTR) {
+            std::cerr << "epoll_wait failed: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                acceptConnections();
+                continue;
+            }
+            if (fd == wakeFd) {
+                uint64_t value;
+                ssize_t got = read(wakeFd, &value, sizeof(value));
+                (void)got;
+                continue;
+            }
+
+            auto it = connections.find(fd);
+            if (it == connections.end()) {
+                continue;
+            }
+            Connection& connection = it->second;
+            bool open = true;
+            if (events[i].events & EPOLLOUT) {
+                open = writeConnection(connection);
+            }
+            if (open && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+                open = readConnection(connection);
+            }
+            if (!open) {
+                closeConnection(fd);
+            }
+        }
+
+        // A finished reload is swapped in between batches
+        if (fileWatcher.poll() && !pendingSnapshot.valid()) {
+            uint32_t version = current->version + 1;
+            std::string filename = modelFile;
+            int wake = wakeFd;
+            pendingSnapshot = std::async(std::launch::async, [filename, version, wake]() {
+                auto snapshot = loadSnapshot(filename, version);
+                uint64_t one = 1;
+                ssize_t written = write(wake, &one, sizeof(one));
+                (void)written;
+                return snapshot;
+            });
+        }
+        checkReload();
+    }
+}
+
+void RouteServer::checkReload() {
+    if (!pendingSnapshot.valid() ||
+        pendingSnapshot.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    auto snapshot = pendingSnapshot.get();
+    if (!snapshot) {
+        std::cerr << "Reload of " << modelFile << " failed, still serving version " << current->version << std::endl;
+        return;
+    }
+
+    // Connections keep no reference to a snapshot between batches, so the old one goes now
+    current = snapshot;
+    std::cerr << "Reloaded " << modelFile << " as version " << current->version << " (" << current->graphs.size()
+        << " graphs)" << std::endl;
+}
+
+void RouteServer::acceptConnections() {
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                std::cerr << "accept failed: " << strerror(errno) << std::endl;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+
+        Connection& connection = connections[fd];
+        connection.fd = fd;
+        connection.events = EPOLLIN;
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            closeConnection(fd);
+        }
+    }
+}
+
+bool RouteServer::readConnection(Connection& connection) {
+    while (connection.reading && !connection.finished) {
+        size_t size = connection.input.size();
+        connection.input.resize(size + READ_CHUNK);
+        ssize_t count = recv(connection.fd, &connection.input[size], READ_CHUNK, 0);
+        connection.input.resize(size + (count > 0 ? static_cast<size_t>(count) : 0));
+        if (count == 0) {
+            // Requests already received are still answered
+            connection.finished = true;
+            break;
+        }
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return false;
+        }
+    }
+    return answerRequests(connection) && writeConnection(connection);
+}
+
+bool RouteServer::answerRequests(Connection& connection) {
+    // One snapshot for the whole batch, even if a reload lands meanwhile
+    std::shared_ptr<const Snapshot> snapshot = current;
+
+    while (connection.output.size() - connection.outputOffset < MAX_PENDING_OUTPUT) {
+        const char* data = connection.input.data() + connection.inputOffset;
+        size_t frameSize = completeFrameSize(data, connection.input.size() - connection.inputOffset);
+        if (frameSize == 0) {
+            break;
+        }
+        if (frameSize == SIZE_MAX) {
+            std::cerr << "Closing connection after an oversized request" << std::endl;
+            return false;
+        }
+
+        FrameReader body(data + 4, frameSize - 4);
+        uint32_t id = 0;
+        uint8_t type = 0;
+        if (!body.u32(id) || !body.u8(type)) {
+            writeError(connection.output, id, Status::BadRequest, snapshot->version);
+        }
+        else {
+            answer(*snapshot, id, type, body, connection.output);
+        }
+        connection.inputOffset += frameSize;
+        ++requestCount;
+    }
+
+    // Consumed input is dropped in bulk rather than per request
+    if (connection.inputOffset == connection.input.size()) {
+        connection.input.clear();
+        connection.inputOffset = 0;
+    }
+    else if (connection.inputOffset > READ_CHUNK) {
+        connection.input.erase(0, connection.inputOffset);
+        connection.inputOffset = 0;
+    }
+
+    // A client that stops reading responses is not read from either
+    connection.reading = connection.output.size() - connection.outputOffset < MAX_PENDING_OUTPUT;
+    return true;
+}
+
+void RouteServer::answer(const Snapshot& snapshot, uint32_t id, uint8_t type, FrameReader& body,
+    std::string& output) {
+    std::string graphName;
+    if (static_cast<RequestType>(type) == RequestType::Version) {
+        FrameWriter frame(output, id, static_cast<uint8_t>(Status::Ok));
+        frame.u32(snapshot.version);
+        frame.finish();
+        return;
+    }
+    if (!body.str(graphName)) {
+        writeError(output, id, Status::BadRequest, snapshot.version);
+        return;
+    }
+    auto graphIt = snapshot.graphs.find(graphName);
+    if (graphIt == snapshot.graphs.end()) {
+        writeError(output, id, Status::UnknownGraph, snapshot.version);
+        return;
+    }
+    Graph& graph = *graphIt->second;
+
+    if (static_cast<RequestType>(type) == RequestType::Path) {
+        uint8_t k = 0;
+        std::string from;
+        std::string to;
+        if (!body.u8(k) || !body.str(from) || !body.str(to) || k == 0) {
+            writeError(output, id, Status::BadRequest, snapshot.version);
+            return;
+        }
+        if (graph.nodeIndex.find(from) == graph.nodeIndex.end() || graph.nodeIndex.find(to) == graph.nodeIndex.end()) {
+            writeError(output, id, Status::UnknownNode, snapshot.version);
+            return;
+        }
+
+        std::vector<Route> routes = findKShortestPaths(graph, from, to, std::min<size_t>(k, MAX_ROUTES));
+        FrameWriter frame(output, id, static_cast<uint8_t>(Status::Ok));
+        frame.u32(snapshot.version);
+        frame.u16(static_cast<uint16_t>(routes.size()));
+        for (const auto& route : routes) {
+            frame.f32(route.cost);
+            frame.u16(static_cast<uint16_t>(std::min<size_t>(route.nodes.size(), UINT16_MAX)));
+            for (size_t i = 0; i < route.nodes.size() && i < UINT16_MAX; ++i) {
+                frame.str(route.nodes[i]);
+            }
+        }
+        frame.finish();
+    }
+    else if (static_cast<RequestType>(type) == RequestType::Neighbors) {
+        std::string node;
+        if (!body.str(node)) {
+            writeError(output, id, Status::BadRequest, snapshot.version);
+            return;
+        }
+        auto nodeIt = graph.nodeIndex.find(node);
+        if (nodeIt == graph.nodeIndex.end()) {
+            writeError(output, id, Status::UnknownNode, snapshot.version);
+            return;
+        }
+
+        // Incident edges from the geometry index: out-edges first, then in-edges
+        const uint32_t slot = static_cast<uint32_t>(nodeIt->second);
+        const auto& incident = graph.incidentEdges[slot];
+        FrameWriter frame(output, id, static_cast<uint8_t>(Status::Ok));
+        frame.u32(snapshot.version);
+        for (int outgoing = 1; outgoing >= 0; --outgoing) {
+            const auto& ends = outgoing ? graph.edgeFromSlot : graph.edgeToSlot;
+            uint16_t count = 0;
+            for (uint32_t e : incident) {
+                count += ends[e] == slot && count < UINT16_MAX ? 1 : 0;
+            }
+            frame.u16(count);
+            uint16_t written = 0;
+            for (uint32_t e : incident) {
+                if (ends[e] == slot && written++ < count) {
+                    const Edge& edge = *graph.edges[e];
+                    frame.str(outgoing ? edge.to : edge.from);
+                    frame.f32(edge.weight);
+                }
+            }
+        }
+        frame.finish();
+    }
+    else {
+        writeError(output, id, Status::BadRequest, snapshot.version);
+    }
+}
+
+bool RouteServer::writeConnection(Connection& connection) {
+    while (connection.outputOffset < connection.output.size()) {
+        ssize_t count = send(connection.fd, connection.output.data() + connection.outputOffset,
+            connection.output.size() - connection.outputOffset, MSG_NOSIGNAL);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return false;
+        }
+        connection.outputOffset += static_cast<size_t>(count);
+    }
+    if (connection.outputOffset == connection.output.size()) {
+        connection.output.clear();
+        connection.outputOffset = 0;
+    }
+
+    // Requests held back while the client was behind can be answered now
+    if (!connection.reading && connection.output.size() - connection.outputOffset < MAX_PENDING_OUTPUT / 2) {
+        if (!answerRequests(connection)) {
+            return false;
+        }
+    }
+
+    // A client that is done sending is closed once every complete request is answered and sent
+    if (connection.finished && connection.reading && connection.output.empty()) {
+        return false;
+    }
+    updateEvents(connection);
+    return true;
+}
+
+void RouteServer::updateEvents(Connection& connection) {
+    uint32_t events = (connection.reading && !connection.finished ? static_cast<uint32_t>(EPOLLIN) : 0u) |
+        (connection.outputOffset < connection.output.size() ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+    if (events == connection.events) {
+        return;
+    }
+    connection.events = events;
+    epoll_event event = {};
+    event.events = events;
+    event.data.fd = connection.fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+}
+
+void RouteServer::closeConnection(int fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections.erase(fd);
+}
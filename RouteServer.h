@@ -0,0 +1,86 @@
+#pragma once
+
+#include "GraphModel.h"
+#include "FileWatcher.h"
+#include "RouteProtocol.h"
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Route query service: one GraphModel, loaded once, answering path and neighbor queries
+// from other processes over a Unix domain socket (see RouteProtocol.h). Linux only.
+//
+// A single thread runs an epoll loop over the listening socket and every connection.
+// All complete requests in a connection's input are answered in one pass and the responses
+// go out in as few writes as the socket allows, so pipelining clients get whole batches
+// per round trip.
+//
+// The served data is an immutable snapshot. When the model file changes, a new snapshot is
+// loaded on a worker thread while the old one keeps answering; the loop swaps it in between
+// batches, so no connection is dropped and no request sees a half-loaded model.
+class RouteServer {
+public:
+    RouteServer() = default;
+    ~RouteServer();
+
+    RouteServer(const RouteServer&) = delete;
+    RouteServer& operator=(const RouteServer&) = delete;
+
+    // Load the model file and listen on the socket path (replacing a stale socket file)
+    bool start(const std::string& modelFile, const std::string& socketPath);
+
+    // Serve until stop() is called (from a signal handler or another thread)
+    void run();
+    void stop();
+
+    uint64_t getRequestCount() const { return requestCount; }
+    uint32_t getReloadCount() const { return current ? current->version - 1 : 0; }
+
+private:
+    struct Snapshot {
+        uint32_t version = 0;
+        GraphModel model;
+        std::unordered_map<std::string, std::shared_ptr<Graph>> graphs;
+    };
+
+    struct Connection {
+        int fd = -1;
+        std::string input;
+        size_t inputOffset = 0;
+        std::string output;
+        size_t outputOffset = 0;
+        bool reading = true;        // false while the client is too far behind on responses
+        bool finished = false;      // the client shut down its side; closed once answered
+        uint32_t events = 0;        // epoll events registered
+    };
+
+    static std::shared_ptr<Snapshot> loadSnapshot(const std::string& filename, uint32_t version);
+
+    void acceptConnections();
+    bool readConnection(Connection& connection);
+    bool writeConnection(Connection& connection);
+    void updateEvents(Connection& connection);
+    void closeConnection(int fd);
+    bool answerRequests(Connection& connection);
+    void answer(const Snapshot& snapshot, uint32_t id, uint8_t type, RouteProtocol::FrameReader& body,
+        std::string& output);
+    void checkReload();
+
+    std::string modelFile;
+    std::string socketPath;
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;                // eventfd: stop() or a finished reload
+    std::atomic<bool> stopping{ false };
+
+    std::shared_ptr<const Snapshot> current;
+    std::future<std::shared_ptr<Snapshot>> pendingSnapshot;
+    FileWatcher fileWatcher;
+    std::unordered_map<int, Connection> connections;
+
+    uint64_t requestCount = 0;
+};
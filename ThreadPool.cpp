@@ -0,0 +1,112 @@
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    if (threadCount == 0) {
+        unsigned hardware = std::thread::hardware_concurrency();
+        threadCount = hardware > 1 ? hardware - 1 : 0;
+    }
+
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& loopBody) {
+    if (count == 0) {
+        return;
+    }
+
+    // Not worth waking anyone for a single item
+    if (workers.empty() || count == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            loopBody(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> loopLock(loopMutex);
+    runLoop(count, loopBody);
+}
+
+bool ThreadPool::tryParallelFor(size_t count, const std::function<void(size_t)>& loopBody) {
+    if (workers.empty() || count <= 1) {
+        parallelFor(count, loopBody);
+        return true;
+    }
+
+    std::unique_lock<std::mutex> loopLock(loopMutex, std::try_to_lock);
+    if (!loopLock.owns_lock()) {
+        return false;
+    }
+    runLoop(count, loopBody);
+    return true;
+}
+
+void ThreadPool::runLoop(size_t count, const std::function<void(size_t)>& loopBody) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        body = &loopBody;
+        itemCount = count;
+        nextItem.store(0);
+        busyWorkers = workers.size();
+        ++generation;
+    }
+    wake.notify_all();
+
+    runItems();
+
+    // Wait until every worker has left the loop before the body goes out of scope
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busyWorkers == 0; });
+    body = nullptr;
+}
+
+void ThreadPool::runItems() {
+    for (;;) {
+        size_t i = nextItem.fetch_add(1);
+        if (i >= itemCount) {
+            break;
+        }
+        (*body)(i);
+    }
+}
+
+void ThreadPool::workerLoop() {
+    Profiler::setThreadName("Pool worker");
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+
+        runItems();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0) {
+            done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small fixed-size worker pool for data-parallel loops.
+//
+// parallelFor() hands out indices one at a time from a shared counter, so a worker that
+// finishes early simply takes the next item instead of idling behind a static split.
+// The calling thread works on the loop too, and the call returns when every index is done.
+class ThreadPool {
+public:
+    // threadCount 0 uses one worker per hardware thread (minus the caller)
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of threads working on a loop, including the caller
+    size_t size() const { return workers.size() + 1; }
+
+    // Calls body(i) for every i in [0, count). body must not throw.
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    // Like parallelFor, but returns false without running anything when another loop is
+    // in progress, for callers (the UI thread) that would rather do the work themselves
+    bool tryParallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    // Process-wide pool, created on first use
+    static ThreadPool& shared();
+
+private:
+    void workerLoop();
+    void runItems();
+    void runLoop(size_t count, const std::function<void(size_t)>& loopBody);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::mutex loopMutex;   // one loop at a time
+
+    // Current loop
+    const std::function<void(size_t)>* body = nullptr;
+    size_t itemCount = 0;
+    std::atomic<size_t> nextItem{ 0 };
+    size_t busyWorkers = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+};
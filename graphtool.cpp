@@ -0,0 +1,783 @@
+// Headless command-line tool for batch checks and queries of graph files, for CI and
+// commissioning scripts, and the route query service for other processes on the cell
+// controller. Builds on Linux without the GUI, from this file and GraphModel, GraphArena,
+// GraphValidation, GraphAnalysis, GraphRouting, GraphExport, EdgeCurveCache, RouteServer,
+// RouteProtocol, ConflictSimulator, FileWatcher, MappedFile, JsonWriter, Profiler, ThreadPool
+// and ImGui's core (for the label font; no window or context is created):
+//
+//   g++ -std=c++17 -O2 -I. -Ivendor/ImGui -I<nlohmann/json include dir> -o graphtool graphtool.cpp
+//       GraphModel.cpp GraphArena.cpp GraphValidation.cpp GraphAnalysis.cpp GraphRouting.cpp
+//       GraphExport.cpp EdgeCurveCache.cpp RouteServer.cpp RouteProtocol.cpp ConflictSimulator.cpp
+//       FileWatcher.cpp MappedFile.cpp JsonWriter.cpp Profiler.cpp ThreadPool.cpp vendor/ImGui/imgui.cpp
+//       vendor/ImGui/imgui_draw.cpp vendor/ImGui/imgui_tables.cpp vendor/ImGui/imgui_widgets.cpp -lpthread
+//
+// Files (and route queries) are processed in parallel on a thread pool; results are
+// printed in input order, followed by throughput figures on stderr.
+
+#include "GraphModel.h"
+#include "GraphValidation.h"
+#include "GraphAnalysis.h"
+#include "GraphRouting.h"
+#include "GraphExport.h"
+#include "RouteServer.h"
+#include "RouteProtocol.h"
+#include "ConflictSimulator.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+struct Options {
+    size_t threads = 0;         // including the calling thread; 0: one per hardware thread
+    std::string root = "Home";
+    bool compact = false;       // convert
+    std::string outputDir;      // convert
+    size_t depth = 1024;        // ask: requests in flight per round trip
+    ExportOptions image;        // export
+    SimulationOptions simulation; // simulate
+    std::vector<std::string> inputs;
+};
+
+// Work done for one input file, printed once all files are done
+struct FileResult {
+    std::string output;
+    bool ok = true;
+    size_t bytes = 0;
+    size_t graphs = 0;
+    size_t nodes = 0;
+    size_t edges = 0;
+};
+
+struct Throughput {
+    size_t items = 0;
+    const char* itemName = "files";
+    size_t bytes = 0;
+    size_t graphs = 0;
+    size_t nodes = 0;
+    size_t edges = 0;
+};
+
+void printUsage() {
+    fprintf(stderr,
+        "Usage: graphtool <command> [options] <inputs>\n"
+        "  validate <file>...                  check structure, links and reachability\n"
+        "  convert <pretty|compact> <dir> <file>...\n"
+        "                                      rewrite each file into <dir> in the given format\n"
+        "  stats <file>...                     per-graph size, components, safety counts, memory\n"
+        "  route <queries file>                answer route queries, one per line:\n"
+        "                                      <graph file> <graph> <from> <to> [k]\n"
+        "  serve <file> <socket>               serve path and neighbor queries on a Unix socket,\n"
+        "                                      reloading the file when it changes\n"
+        "  ask <socket> <queries file>         send queries to a running service, one per line:\n"
+        "                                      path <graph> <from> <to> [k] | neighbors <graph> <node>\n"
+        "  export <svg|png> <file> <graph> <output>\n"
+        "                                      draw a graph as the editor does, at any size\n"
+        "  import <nodes.csv> <edges.csv|-> <graph> <file>\n"
+        "                                      add or replace a graph in <file> (created if\n"
+        "                                      missing) from id,x,y and from,to[,weight] rows\n"
+        "  simulate <file> <schedule.json>     run the agents' route requests and report where\n"
+        "                                      they would occupy the same node or edge at once\n"
+        "Options:\n"
+        "  -j <threads>                        worker threads (default: all hardware threads)\n"
+        "  --root <node>                       root node for reachability (default: Home)\n"
+        "  -d <requests>                       ask: requests per round trip (default: 1024)\n"
+        "  --scale <factor>                    export: pixels per graph unit (default: 1)\n"
+        "  --no-labels                         export: leave out node ids and edge weights\n"
+        "  --budget <MB>                       export: PNG pixel memory (default: 16)\n"
+        "  --replan                            simulate: wait or reroute around planned routes\n"
+        "  --clearance <seconds>               simulate: node hold after leaving (default: 0.25)\n");
+}
+
+std::string formatFloat(float value) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%g", value);
+    return buffer;
+}
+
+std::string fileName(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// body(i) for every i in [0, count) on the requested number of threads
+void forEachIndex(const Options& options, size_t count, const std::function<void(size_t)>& body) {
+    if (options.threads == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
+    ThreadPool pool(options.threads > 1 ? options.threads - 1 : 0);
+    pool.parallelFor(count, body);
+}
+
+// Runs 'process' for every input and prints the results in input order
+bool processFiles(const Options& options, const std::function<void(const std::string&, FileResult&)>& process,
+    Throughput& throughput) {
+    std::vector<FileResult> results(options.inputs.size());
+    forEachIndex(options, options.inputs.size(), [&](size_t i) {
+        try {
+            process(options.inputs[i], results[i]);
+        }
+        catch (const std::exception& e) {
+            results[i].output += options.inputs[i] + ": " + e.what() + "\n";
+            results[i].ok = false;
+        }
+    });
+
+    bool ok = true;
+    for (const auto& result : results) {
+        fputs(result.output.c_str(), stdout);
+        ok = ok && result.ok;
+        throughput.bytes += result.bytes;
+        throughput.graphs += result.graphs;
+        throughput.nodes += result.nodes;
+        throughput.edges += result.edges;
+    }
+    throughput.items = results.size();
+    return ok;
+}
+
+void validateFile(const Options& options, const std::string& path, FileResult& result) {
+    GraphFileIndex index;
+    if (!GraphFileIndex::read(path, index, false)) {
+        result.output = path + ": error: not a readable graph file\n";
+        result.ok = false;
+        return;
+    }
+    ValidationResult validation = validateGraphFile(index, options.root);
+
+    std::ostringstream out;
+    for (const auto& issue : validation.issues) {
+        out << path << ": " << (issue.error ? "error: " : "warning: ");
+        if (!issue.graph.empty()) {
+            out << issue.graph << ": ";
+        }
+        out << issue.message << "\n";
+    }
+    size_t errors = validation.errorCount();
+    out << path << ": " << (errors == 0 ? "ok" : "FAILED") << " (" << validation.graphCount << " graphs, "
+        << errors << " errors, " << validation.issues.size() - errors << " warnings)\n";
+
+    result.output = out.str();
+    result.ok = errors == 0;
+    result.bytes = index.text->size();
+    result.graphs = validation.graphCount;
+    result.nodes = validation.nodeCount;
+    result.edges = validation.edgeCount;
+}
+
+void convertFile(const Options& options, const std::string& path, FileResult& result) {
+    GraphModel model;
+    if (!model.loadFromFile(path, true)) {
+        result.output = path + ": error: not a readable graph file\n";
+        result.ok = false;
+        return;
+    }
+    std::string target = options.outputDir + "/" + fileName(path);
+    if (!model.saveToFile(target, options.compact)) {
+        result.output = path + ": error: failed to write " + target + "\n";
+        result.ok = false;
+        return;
+    }
+
+    std::ifstream written(target, std::ios::binary | std::ios::ate);
+    result.output = path + " -> " + target + "\n";
+    result.bytes = static_cast<size_t>(written.tellg());
+    result.graphs = model.getGraphNames().size();
+    for (const auto& name : model.getGraphNames()) {
+        auto graph = model.getGraph(name);
+        result.nodes += graph ? graph->nodes.size() : 0;
+        result.edges += graph ? graph->edges.size() : 0;
+    }
+}
+
+void statsFile(const Options& options, const std::string& path, FileResult& result) {
+    GraphModel model;
+    if (!model.loadFromFile(path, true)) {
+        result.output = path + ": error: not a readable graph file\n";
+        result.ok = false;
+        return;
+    }
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    result.bytes = static_cast<size_t>(file.tellg());
+
+    std::vector<std::string> names = model.getGraphNames();
+    std::sort(names.begin(), names.end());
+    std::ostringstream out;
+    out << path << ": " << names.size() << " graphs, " << model.getTransfers().size() << " transfers\n";
+    for (const auto& name : names) {
+        auto graph = model.getGraph(name);
+        if (!graph) {
+            out << "  " << name << ": failed to load\n";
+            result.ok = false;
+            continue;
+        }
+        size_t bidirectional = 0;
+        for (const auto& edge : graph->edges) {
+            bidirectional += edge->from < edge->to && graph->findEdge(edge->to, edge->from) ? 1 : 0;
+        }
+        graph->updateGeometryIndex();
+        size_t maxDegree = 0;
+        for (const auto& incident : graph->incidentEdges) {
+            maxDegree = std::max(maxDegree, incident.size());
+        }
+
+        GraphAnalysis analysis;
+        analysis.setRoot(options.root);
+        analysis.update(graph);
+        GraphMemoryUsage memory = graph->getMemoryUsage();
+        out << "  " << name << ": " << graph->nodes.size() << " nodes, " << graph->edges.size() << " edges ("
+            << bidirectional << " two-way pairs), max degree " << maxDegree << ", "
+            << analysis.getComponentCount() << " components, " << std::fixed << std::setprecision(2)
+            << memory.total() / 1e6 << " MB in memory";
+        if (analysis.hasRoot()) {
+            out << ", " << analysis.getUnreachableCount() << " unreachable from " << options.root << ", "
+                << analysis.getDeadEndCount() << " dead ends, " << analysis.getTrapEdgeCount() << " trap edges";
+        }
+        out << "\n";
+
+        result.graphs += 1;
+        result.nodes += graph->nodes.size();
+        result.edges += graph->edges.size();
+    }
+    result.output = out.str();
+}
+
+struct RouteQuery {
+    size_t line = 0;
+    size_t file = 0;
+    std::string graphName;
+    std::string from;
+    std::string to;
+    size_t k = 1;
+    Graph* graph = nullptr;
+    std::string output;
+};
+
+bool runRouteQueries(const Options& options, Throughput& throughput) {
+    if (options.inputs.size() != 1) {
+        printUsage();
+        return false;
+    }
+    std::ifstream input(options.inputs[0]);
+    if (!input.is_open()) {
+        std::cerr << "Failed to open query file: " << options.inputs[0] << std::endl;
+        return false;
+    }
+
+    // Queries, and the distinct files they use
+    std::vector<RouteQuery> queries;
+    std::vector<std::string> files;
+    std::unordered_map<std::string, size_t> fileIndex;
+    std::string line;
+    for (size_t lineNumber = 1; std::getline(input, line); ++lineNumber) {
+        std::istringstream fields(line);
+        std::string path;
+        RouteQuery query;
+        if (!(fields >> path) || path[0] == '#') {
+            continue;
+        }
+        if (!(fields >> query.graphName >> query.from >> query.to)) {
+            std::cerr << options.inputs[0] << ":" << lineNumber << ": expected <graph file> <graph> <from> <to> [k]" << std::endl;
+            return false;
+        }
+        if (!(fields >> query.k) || query.k == 0) {
+            query.k = 1;
+        }
+        query.line = lineNumber;
+        query.file = fileIndex.emplace(path, files.size()).first->second;
+        if (query.file == files.size()) {
+            files.push_back(path);
+        }
+        queries.push_back(std::move(query));
+    }
+
+    // Each file is loaded once and the queried graphs built with their routing snapshots,
+    // so the queries below only read shared state
+    std::vector<std::vector<size_t>> queriesOfFile(files.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        queriesOfFile[queries[i].file].push_back(i);
+    }
+    std::vector<std::unique_ptr<GraphModel>> models(files.size());
+    std::vector<FileResult> loads(files.size());
+    forEachIndex(options, files.size(), [&](size_t f) {
+        auto model = std::make_unique<GraphModel>();
+        if (!model->loadFromFile(files[f], true)) {
+            return;
+        }
+        std::ifstream file(files[f], std::ios::binary | std::ios::ate);
+        loads[f].bytes = static_cast<size_t>(file.tellg());
+        std::unordered_set<std::string> built;
+        for (size_t i : queriesOfFile[f]) {
+            RouteQuery& query = queries[i];
+            auto graph = model->getGraph(query.graphName);
+            if (graph) {
+                routeCacheOf(*graph).snapshot(*graph);
+                query.graph = graph.get();
+                if (built.insert(query.graphName).second) {
+                    loads[f].graphs += 1;
+                    loads[f].nodes += graph->nodes.size();
+                    loads[f].edges += graph->edges.size();
+                }
+            }
+        }
+        models[f] = std::move(model);
+    });
+    auto loaded = std::chrono::steady_clock::now();
+
+    forEachIndex(options, queries.size(), [&](size_t i) {
+        RouteQuery& query = queries[i];
+        std::ostringstream out;
+        out << query.line << ": " << query.graphName << " " << query.from << " -> " << query.to << ": ";
+        if (!models[query.file]) {
+            out << "error: cannot load " << files[query.file] << "\n";
+        }
+        else if (!query.graph) {
+            out << "error: no graph " << query.graphName << "\n";
+        }
+        else {
+            std::vector<Route> routes = findKShortestPaths(*query.graph, query.from, query.to, query.k);
+            if (routes.empty()) {
+                out << "no route\n";
+            }
+            for (size_t r = 0; r < routes.size(); ++r) {
+                out << (r > 0 ? "    " : "") << formatFloat(routes[r].cost) << " ";
+                for (size_t n = 0; n < routes[r].nodes.size(); ++n) {
+                    out << (n > 0 ? " > " : "") << routes[r].nodes[n];
+                }
+                out << "\n";
+            }
+        }
+        query.output = out.str();
+    });
+    double queryMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loaded).count();
+
+    bool ok = true;
+    for (const auto& query : queries) {
+        fputs(query.output.c_str(), stdout);
+        ok = ok && models[query.file] && query.graph;
+    }
+    for (const auto& load : loads) {
+        throughput.bytes += load.bytes;
+        throughput.graphs += load.graphs;
+        throughput.nodes += load.nodes;
+        throughput.edges += load.edges;
+    }
+    throughput.items = queries.size();
+    throughput.itemName = "queries";
+    fprintf(stderr, "%zu queries on %zu files: %.1f ms, %.0f queries/s\n", queries.size(), files.size(),
+        queryMs, queryMs > 0.0 ? queries.size() * 1000.0 / queryMs : 0.0);
+    return ok;
+}
+
+RouteServer* runningServer = nullptr;
+
+void stopServer(int) {
+    if (runningServer) {
+        runningServer->stop();
+    }
+}
+
+int serve(const Options& options) {
+    if (options.inputs.size() != 2) {
+        printUsage();
+        return 2;
+    }
+    RouteServer server;
+    if (!server.start(options.inputs[0], options.inputs[1])) {
+        return 1;
+    }
+    runningServer = &server;
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+    fprintf(stderr, "Serving %s on %s\n", options.inputs[0].c_str(), options.inputs[1].c_str());
+
+    server.run();
+    runningServer = nullptr;
+    fprintf(stderr, "Stopped after %llu requests and %u reloads\n",
+        static_cast<unsigned long long>(server.getRequestCount()), server.getReloadCount());
+    return 0;
+}
+
+struct ServiceQuery {
+    RouteProtocol::RequestType type = RouteProtocol::RequestType::Path;
+    std::string graph;
+    std::string from;       // the node, for neighbor queries
+    std::string to;
+    size_t k = 1;
+};
+
+void printResponse(const ServiceQuery& query, const RouteProtocol::Response& response) {
+    using RouteProtocol::Status;
+    if (query.type == RouteProtocol::RequestType::Path) {
+        printf("%s %s -> %s: ", query.graph.c_str(), query.from.c_str(), query.to.c_str());
+    }
+    else {
+        printf("%s %s: ", query.graph.c_str(), query.from.c_str());
+    }
+    if (response.status != Status::Ok) {
+        printf("%s\n", response.status == Status::UnknownGraph ? "unknown graph" :
+            response.status == Status::UnknownNode ? "unknown node" : "bad request");
+        return;
+    }
+    if (query.type == RouteProtocol::RequestType::Path) {
+        if (response.routes.empty()) {
+            printf("no route\n");
+        }
+        for (size_t r = 0; r < response.routes.size(); ++r) {
+            printf("%s%s ", r > 0 ? "    " : "", formatFloat(response.routes[r].cost).c_str());
+            for (size_t n = 0; n < response.routes[r].nodes.size(); ++n) {
+                printf("%s%s", n > 0 ? " > " : "", response.routes[r].nodes[n].c_str());
+            }
+            printf("\n");
+        }
+        return;
+    }
+    printf("out");
+    for (const auto& edge : response.outEdges) {
+        printf(" %s (%s)", edge.first.c_str(), formatFloat(edge.second).c_str());
+    }
+    printf(", in");
+    for (const auto& edge : response.inEdges) {
+        printf(" %s (%s)", edge.first.c_str(), formatFloat(edge.second).c_str());
+    }
+    printf("\n");
+}
+
+int ask(const Options& options) {
+    if (options.inputs.size() != 2) {
+        printUsage();
+        return 2;
+    }
+    std::ifstream input(options.inputs[1]);
+    if (!input.is_open()) {
+        std::cerr << "Failed to open query file: " << options.inputs[1] << std::endl;
+        return 1;
+    }
+    std::vector<ServiceQuery> queries;
+    std::string line;
+    for (size_t lineNumber = 1; std::getline(input, line); ++lineNumber) {
+        std::istringstream fields(line);
+        std::string kind;
+        ServiceQuery query;
+        if (!(fields >> kind) || kind[0] == '#') {
+            continue;
+        }
+        bool valid = false;
+        if (kind == "path") {
+            valid = static_cast<bool>(fields >> query.graph >> query.from >> query.to);
+            if (!(fields >> query.k) || query.k == 0) {
+                query.k = 1;
+            }
+        }
+        else if (kind == "neighbors") {
+            query.type = RouteProtocol::RequestType::Neighbors;
+            valid = static_cast<bool>(fields >> query.graph >> query.from);
+        }
+        if (!valid) {
+            std::cerr << options.inputs[1] << ":" << lineNumber
+                << ": expected path <graph> <from> <to> [k] or neighbors <graph> <node>" << std::endl;
+            return 2;
+        }
+        queries.push_back(std::move(query));
+    }
+
+    RouteProtocol::Client client;
+    if (!client.connect(options.inputs[0])) {
+        return 1;
+    }
+
+    // Up to 'depth' requests go out in one write, then their responses are read back
+    auto start = std::chrono::steady_clock::now();
+    size_t roundTrips = 0;
+    RouteProtocol::Response response;
+    for (size_t first = 0; first < queries.size(); first += options.depth) {
+        size_t last = std::min(queries.size(), first + options.depth);
+        for (size_t i = first; i < last; ++i) {
+            const ServiceQuery& query = queries[i];
+            if (query.type == RouteProtocol::RequestType::Path) {
+                client.queuePath(query.graph, query.from, query.to, query.k);
+            }
+            else {
+                client.queueNeighbors(query.graph, query.from);
+            }
+        }
+        if (!client.flush()) {
+            return 1;
+        }
+        for (size_t i = first; i < last; ++i) {
+            if (!client.readResponse(queries[i].type, response)) {
+                return 1;
+            }
+            printResponse(queries[i], response);
+        }
+        ++roundTrips;
+    }
+    fflush(stdout);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "%zu queries in %zu round trips, %.1f ms: %.0f queries/s (snapshot version %u)\n",
+        queries.size(), roundTrips, seconds * 1000.0, queries.size() / seconds, response.version);
+    return 0;
+}
+
+int exportImage(const Options& options) {
+    if (options.inputs.size() != 4 || (options.inputs[0] != "svg" && options.inputs[0] != "png")) {
+        printUsage();
+        return 2;
+    }
+    const std::string& path = options.inputs[1];
+    const std::string& name = options.inputs[2];
+    const std::string& output = options.inputs[3];
+
+    GraphModel model;
+    if (!model.loadFromFile(path, true)) {
+        std::cerr << path << ": error: not a readable graph file" << std::endl;
+        return 1;
+    }
+    auto graph = model.getGraph(name);
+    if (!graph) {
+        std::cerr << path << ": error: no graph named " << name << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    GraphExport image;
+    {
+        GraphAnalysis analysis;
+        analysis.setRoot(options.root);
+        analysis.update(graph);
+        image.capture(*graph, &analysis);
+    }
+    uint32_t width, height;
+    image.getImageSize(options.image, width, height);
+    bool ok = options.inputs[0] == "svg" ? image.writeSvg(output, options.image) :
+        image.writePng(output, options.image);
+    if (!ok) {
+        return 1;
+    }
+
+    std::ifstream written(output, std::ios::binary | std::ios::ate);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "%s: %u x %u, %zu nodes, %zu edges, %.1f MB in %.1f ms\n", output.c_str(), width, height,
+        image.getNodeCount(), image.getEdgeCount(), static_cast<double>(written.tellg()) / 1e6, seconds * 1000.0);
+    return 0;
+}
+
+int importCsv(const Options& options) {
+    if (options.inputs.size() != 4) {
+        printUsage();
+        return 2;
+    }
+    const std::string& nodesFile = options.inputs[0];
+    const std::string edgesFile = options.inputs[1] == "-" ? std::string() : options.inputs[1];
+    const std::string& name = options.inputs[2];
+    const std::string& path = options.inputs[3];
+
+    // The other graphs of an existing file are kept as they are
+    GraphModel model;
+    if (std::ifstream(path).good() && !model.loadFromFile(path, true)) {
+        std::cerr << path << ": error: not a readable graph file" << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (!model.importCsv(name, nodesFile, edgesFile)) {
+        return 1;
+    }
+    double importSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!model.saveToFile(path)) {
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t bytes = 0;
+    for (const std::string* file : { &nodesFile, &edgesFile }) {
+        std::ifstream input(*file, std::ios::binary | std::ios::ate);
+        bytes += input ? static_cast<size_t>(input.tellg()) : 0;
+    }
+    auto graph = model.getGraph(name);
+    fprintf(stderr, "%s: %zu nodes, %zu edges from %.1f MB of CSV in %.1f ms (%.1f MB/s), saved in %.1f ms\n",
+        name.c_str(), graph->nodes.size(), graph->edges.size(), bytes / 1e6, importSeconds * 1000.0,
+        bytes / 1e6 / importSeconds, (seconds - importSeconds) * 1000.0);
+    return 0;
+}
+
+int simulate(const Options& options) {
+    if (options.inputs.size() != 2) {
+        printUsage();
+        return 2;
+    }
+    const std::string& path = options.inputs[0];
+    GraphModel model;
+    if (!model.loadFromFile(path, true)) {
+        std::cerr << path << ": error: not a readable graph file" << std::endl;
+        return 1;
+    }
+    SimSchedule schedule;
+    if (!schedule.load(options.inputs[1])) {
+        return 1;
+    }
+
+    ConflictSimulator simulator;
+    SimulationResult result;
+    auto start = std::chrono::steady_clock::now();
+    if (!simulator.run(model, schedule, options.simulation, result)) {
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // The first conflicts in time order; the rest only count
+    const size_t shown = std::min<size_t>(result.conflicts.size(), 20);
+    for (size_t i = 0; i < shown; ++i) {
+        const SimConflict& conflict = result.conflicts[i];
+        printf("%.3f-%.3f", conflict.begin, conflict.end);
+        for (int side = 0; side < 2; ++side) {
+            uint32_t agent = conflict.agents[side];
+            auto graph = model.getGraph(result.agentGraphs[agent]);
+            const std::string& from = graph->nodes[conflict.from[side]]->id;
+            const std::string& to = graph->nodes[conflict.to[side]]->id;
+            printf("%s %s %s", side == 0 ? "" : " vs", result.agentNames[agent].c_str(),
+                from == to ? from.c_str() : (from + "->" + to).c_str());
+        }
+        printf("\n");
+    }
+    if (result.conflicts.size() > shown) {
+        printf("... %zu more\n", result.conflicts.size() - shown);
+    }
+    printf("%zu agents, %zu requests: %zu routed, %zu failed, %zu delayed, %zu rerouted, %zu unresolved, "
+        "%zu conflicts, makespan %.1f s\n", result.agentNames.size(), schedule.requests.size(), result.routed,
+        result.failed, result.delayed, result.rerouted, result.unresolved, result.conflicts.size(), result.makespan);
+    fflush(stdout);
+    fprintf(stderr, "%zu requests in %.1f ms: %.0f requests/s\n", schedule.requests.size(), seconds * 1000.0,
+        schedule.requests.size() / seconds);
+    return result.conflicts.empty() && result.failed == 0 ? 0 : 1;
+}
+
+bool parseOptions(int argc, char** argv, int first, Options& options) {
+    for (int i = first; i < argc; ++i) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            options.threads = static_cast<size_t>(std::max(1, atoi(argv[++i])));
+        }
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            options.depth = static_cast<size_t>(std::max(1, atoi(argv[++i])));
+        }
+        else if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+            options.root = argv[++i];
+        }
+        else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            options.image.scale = static_cast<float>(atof(argv[++i]));
+            if (options.image.scale <= 0.0f) {
+                std::cerr << "Scale must be positive" << std::endl;
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--no-labels") == 0) {
+            options.image.labels = false;
+        }
+        else if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc) {
+            options.image.memoryBudget = static_cast<size_t>(std::max(1, atoi(argv[++i]))) << 20;
+        }
+        else if (strcmp(argv[i], "--replan") == 0) {
+            options.simulation.replan = true;
+        }
+        else if (strcmp(argv[i], "--clearance") == 0 && i + 1 < argc) {
+            options.simulation.nodeClearance = std::max(0.0, atof(argv[++i]));
+        }
+        else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return false;
+        }
+        else {
+            options.inputs.push_back(argv[i]);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (argc < 3 || !parseOptions(argc, argv, 2, options)) {
+        printUsage();
+        return 2;
+    }
+
+    // Timing zones are only read by the editor's profiler window
+    Profiler::setEnabled(false);
+
+    std::string command = argv[1];
+    if (command == "serve") {
+        return serve(options);
+    }
+    if (command == "ask") {
+        return ask(options);
+    }
+    if (command == "export") {
+        return exportImage(options);
+    }
+    if (command == "import") {
+        return importCsv(options);
+    }
+    if (command == "simulate") {
+        return simulate(options);
+    }
+
+    Throughput throughput;
+    auto start = std::chrono::steady_clock::now();
+    bool ok = false;
+    if (command == "validate") {
+        ok = processFiles(options, [&](const std::string& path, FileResult& result) {
+            validateFile(options, path, result);
+        }, throughput);
+    }
+    else if (command == "convert") {
+        if (options.inputs.size() < 3 || (options.inputs[0] != "pretty" && options.inputs[0] != "compact")) {
+            printUsage();
+            return 2;
+        }
+        options.compact = options.inputs[0] == "compact";
+        options.outputDir = options.inputs[1];
+        options.inputs.erase(options.inputs.begin(), options.inputs.begin() + 2);
+        ok = processFiles(options, [&](const std::string& path, FileResult& result) {
+            convertFile(options, path, result);
+        }, throughput);
+    }
+    else if (command == "stats") {
+        ok = processFiles(options, [&](const std::string& path, FileResult& result) {
+            statsFile(options, path, result);
+        }, throughput);
+    }
+    else if (command == "route") {
+        ok = runRouteQueries(options, throughput);
+    }
+    else {
+        printUsage();
+        return 2;
+    }
+    fflush(stdout);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "%zu %s, %.1f MB, %zu graphs, %zu nodes, %zu edges in %.1f ms: %.0f %s/s, %.1f MB/s\n",
+        throughput.items, throughput.itemName, throughput.bytes / 1e6, throughput.graphs, throughput.nodes,
+        throughput.edges, seconds * 1000.0, throughput.items / seconds, throughput.itemName,
+        throughput.bytes / 1e6 / seconds);
+    return ok ? 0 : 1;
+}
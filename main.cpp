@@ -4,10 +4,22 @@
 #include <d3d9.h>
 #include <tchar.h>
 #include <memory>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <fstream>
 
 // Graph editor headers
 #include "GraphModel.h"
 #include "GraphEditor.h"
+#include "Profiler.h"
+#include "GraphGenerator.h"
+#include "InputRecording.h"
+#include "MachineFeed.h"
+#include "MachineSimulator.h"
+#include <thread>
+#include <algorithm>
 
 // Data
 static LPDIRECT3D9              g_pD3D = nullptr;
@@ -19,16 +31,29 @@ static D3DPRESENT_PARAMETERS    g_d3dpp = {};
 // Graph editor objects
 std::shared_ptr<GraphModel> g_GraphModel;
 GraphEditor g_GraphEditor;
+static const char* const MACHINE_FEED_NAME = "cppimgui_machines";
 
 // Forward declarations of helper functions
 bool CreateDeviceD3D(HWND hWnd);
 void CleanupDeviceD3D();
 void ResetDevice();
 LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
+int RunGenerator(int argc, char** argv);
+int RunReplay(int argc, char** argv);
+int RunMachineSimulator(int argc, char** argv);
+void BuildEditorFrame(GraphEditor& editor);
 
 // Main code
-int main(int, char**)
+int main(int argc, char** argv)
 {
+    // Command-line modes run without a window
+    if (argc > 1 && strcmp(argv[1], "--generate") == 0)
+        return RunGenerator(argc - 2, argv + 2);
+    if (argc > 1 && strcmp(argv[1], "--replay") == 0)
+        return RunReplay(argc - 2, argv + 2);
+    if (argc > 1 && strcmp(argv[1], "--simulate-machines") == 0)
+        return RunMachineSimulator(argc - 2, argv + 2);
+
     // Create application window
     //ImGui_ImplWin32_EnableDpiAwareness();
     WNDCLASSEXW wc = { sizeof(wc), CS_CLASSDC, WndProc, 0L, 0L, GetModuleHandle(nullptr), nullptr, nullptr, nullptr, nullptr, L"Graph Editor", nullptr };
@@ -63,11 +88,28 @@ int main(int, char**)
     ImGui_ImplDX9_Init(g_pd3dDevice);
 
     // Initialize graph model and editor
+    Profiler::setThreadName("UI");
     g_GraphModel = std::make_shared<GraphModel>();
     g_GraphEditor.setModel(g_GraphModel);
 
-    // Try to load the graph data
-    g_GraphModel->loadFromFile("C:/Users/komgr/source/repos/komcat/CppImGui/WorkingGraphs.json");
+    // Try to load the graph data (lazily, graphs are parsed when first shown)
+    const char* graphFile = "C:/Users/komgr/source/repos/komcat/CppImGui/WorkingGraphs.json";
+    bool graphFileLoaded = g_GraphModel->loadFromFile(graphFile, true);
+
+    // Pick up edits made by the calibration tools while the editor is open; the menu and the
+    // exit save use the same path, so they write the file that is watched
+    g_GraphEditor.watchFile(graphFile);
+    g_GraphEditor.setGraphFile(graphFile, graphFileLoaded);
+
+    // Unsaved work from a session that did not exit cleanly, then keep saving it every 30 s
+    const char* recoveryFile = "WorkingGraphs.recovery.json";
+    size_t recovered = g_GraphModel->loadRecovery(recoveryFile);
+    if (recovered > 0)
+        fprintf(stderr, "Restored %zu graph(s) with unsaved changes from %s\n", recovered, recoveryFile);
+    g_GraphEditor.setAutosave(recoveryFile, 30.0);
+
+    // Live machine positions, when the controller (or --simulate-machines) publishes them
+    g_GraphEditor.connectMachineFeed(MACHINE_FEED_NAME);
     // Our state
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
@@ -117,22 +159,7 @@ int main(int, char**)
         ImGui::NewFrame();
 
         // Create a full window for the graph editor
-        {
-            ImGui::SetNextWindowPos(ImVec2(0, 0));
-            ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
-            ImGui::Begin("Graph Editor", nullptr,
-                ImGuiWindowFlags_NoTitleBar |
-                ImGuiWindowFlags_NoResize |
-                ImGuiWindowFlags_NoMove |
-                ImGuiWindowFlags_NoCollapse |
-                ImGuiWindowFlags_MenuBar |
-                ImGuiWindowFlags_NoBringToFrontOnFocus);
-
-            // Render the graph editor
-            g_GraphEditor.render();
-
-            ImGui::End();
-        }
+        BuildEditorFrame(g_GraphEditor);
 
         // Rendering
         ImGui::EndFrame();
@@ -143,6 +170,7 @@ int main(int, char**)
         g_pd3dDevice->Clear(0, nullptr, D3DCLEAR_TARGET | D3DCLEAR_ZBUFFER, clear_col_dx, 1.0f, 0);
         if (g_pd3dDevice->BeginScene() >= 0)
         {
+            PROFILE_SCOPE("Frame::render");
             ImGui::Render();
             ImGui_ImplDX9_RenderDrawData(ImGui::GetDrawData());
             g_pd3dDevice->EndScene();
@@ -150,10 +178,16 @@ int main(int, char**)
         HRESULT result = g_pd3dDevice->Present(nullptr, nullptr, nullptr, nullptr);
         if (result == D3DERR_DEVICELOST)
             g_DeviceLost = true;
+
+        // Fold this frame's zones into the profiler overlay
+        Profiler::endFrame();
     }
 
-    // Save the graph data before exiting
-    g_GraphModel->saveToFile("WorkingGraphs.json");
+    // Save the graph data before exiting (skipped when nothing changed, or when the file did not
+    // load), then drop the recovery file, or keep what is still unsaved in it
+    if (g_GraphEditor.canSaveGraphFile())
+        g_GraphModel->saveToFile(graphFile);
+    g_GraphModel->saveRecovery(recoveryFile);
 
     // Cleanup
     ImGui_ImplDX9_Shutdown();
@@ -167,6 +201,184 @@ int main(int, char**)
     return 0;
 }
 
+// The editor as one full-window ImGui window, shared by the app and the replayer
+void BuildEditorFrame(GraphEditor& editor)
+{
+    PROFILE_SCOPE("Frame::build");
+    ImGui::SetNextWindowPos(ImVec2(0, 0));
+    ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+    ImGui::Begin("Graph Editor", nullptr,
+        ImGuiWindowFlags_NoTitleBar |
+        ImGuiWindowFlags_NoResize |
+        ImGuiWindowFlags_NoMove |
+        ImGuiWindowFlags_NoCollapse |
+        ImGuiWindowFlags_MenuBar |
+        ImGuiWindowFlags_NoBringToFrontOnFocus);
+
+    // Render the graph editor
+    editor.render();
+
+    ImGui::End();
+}
+
+// Replay recorded input against a graph file without a window and report frame times:
+//   --replay <recording> <graph file> [iterations]
+// Frame time is the CPU time to build and render the frame's draw data; no GPU work is done.
+int RunReplay(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: --replay <recording> <graph file> [iterations]\n");
+        return 1;
+    }
+    InputRecording recording;
+    if (!recording.load(argv[0]))
+        return 1;
+    int iterations = argc > 2 ? std::max(1, atoi(argv[2])) : 1;
+
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;                   // same layout as the app, but leave its settings alone
+    if (std::ifstream("imgui.ini").good())
+        ImGui::LoadIniSettingsFromDisk("imgui.ini");
+    io.ConfigInputTrickleEventQueue = false;    // each recorded frame is one input state
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+    unsigned char* pixels = nullptr;
+    int width = 0, height = 0;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    ImGui::StyleColorsDark();
+    Profiler::setThreadName("UI");
+
+    std::vector<double> frameMs;
+    std::shared_ptr<GraphModel> model;
+    for (int iteration = 0; iteration < iterations; iteration++)
+    {
+        // Every iteration starts from the file and the recorded view
+        model = std::make_shared<GraphModel>();
+        if (!model->loadFromFile(argv[1], true))
+            return 1;
+        GraphEditor editor;
+        editor.setModel(model);
+        editor.beginReplay(recording);
+
+        for (size_t i = 0; i < recording.frames.size(); i++)
+        {
+            applyInputFrame(recording.frames[i], i > 0 ? &recording.frames[i - 1] : nullptr);
+            auto start = std::chrono::steady_clock::now();
+            ImGui::NewFrame();
+            BuildEditorFrame(editor);
+            ImGui::Render();
+            frameMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            Profiler::endFrame();
+        }
+    }
+    ImGui::DestroyContext();
+
+    FrameTimeStats stats = summarizeFrameTimes(frameMs);
+    printf("%zu frames: mean %.2f ms, p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+        stats.frames, stats.mean, stats.p50, stats.p99, stats.max);
+
+    // Final model state, so runs can be checked for the same result
+    std::vector<std::string> names = model->getGraphNames();
+    std::sort(names.begin(), names.end());
+    for (const auto& name : names)
+    {
+        // Graphs the session never opened are left unparsed
+        if (!model->isDirty(name))
+        {
+            printf("  %s: unchanged\n", name.c_str());
+            continue;
+        }
+        auto graph = model->getGraph(name);
+        printf("  %s: %zu nodes, %zu edges, content hash %016llx\n", name.c_str(),
+            graph->nodes.size(), graph->edges.size(), (unsigned long long)graph->stateHash);
+    }
+    return 0;
+}
+
+// Publish simulated machine positions on the live feed, for testing the overlay:
+//   --simulate-machines <graph file> [seconds] [samples per second]
+// Runs until stopped when seconds is 0 (the default)
+int RunMachineSimulator(int argc, char** argv)
+{
+    if (argc < 1)
+    {
+        fprintf(stderr, "Usage: --simulate-machines <graph file> [seconds] [samples per second]\n");
+        return 1;
+    }
+    double seconds = argc > 1 ? atof(argv[1]) : 0.0;
+    double rate = argc > 2 ? std::max(1.0, atof(argv[2])) : 1000.0;
+
+    GraphModel model;
+    if (!model.loadFromFile(argv[0]))
+        return 1;
+    MachineSimulator simulator(model, 1);
+    if (simulator.getMachineCount() == 0)
+    {
+        fprintf(stderr, "No graph with edges in %s\n", argv[0]);
+        return 1;
+    }
+    MachineFeed feed;
+    if (!feed.create(MACHINE_FEED_NAME))
+        return 1;
+    printf("Publishing %zu machine(s) at %.0f samples/s on '%s'\n", simulator.getMachineCount(), rate, MACHINE_FEED_NAME);
+
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / rate));
+    auto start = std::chrono::steady_clock::now();
+    auto next = start;
+    size_t published = 0;
+    size_t dropped = 0;
+    while (seconds <= 0.0 || std::chrono::duration<double>(next - start).count() < seconds)
+    {
+        simulator.advance(std::chrono::duration<double>(period).count());
+        auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch());
+        dropped += simulator.publish(feed, (uint64_t)timestamp.count());
+        published += simulator.getMachineCount();
+        next += period;
+        std::this_thread::sleep_until(next);
+    }
+    printf("%zu samples published, %zu dropped while the ring was full\n", published, dropped);
+    feed.close();
+    return 0;
+}
+
+// Generate a synthetic graph into a model file:
+//   --generate <grid|geometric|scalefree|hub> <nodes> <file> [seed] [graph name]
+// An existing file is loaded first (lazily, so its other graphs are copied verbatim)
+int RunGenerator(int argc, char** argv)
+{
+    GeneratorOptions options;
+    if (argc < 3 || !parseGeneratorKind(argv[0], options.kind) || atoll(argv[1]) <= 0)
+    {
+        fprintf(stderr, "Usage: --generate <grid|geometric|scalefree|hub> <nodes> <file> [seed] [graph name]\n");
+        return 1;
+    }
+    options.nodeCount = (size_t)atoll(argv[1]);
+    const char* filename = argv[2];
+    options.seed = argc > 3 ? (uint32_t)strtoul(argv[3], nullptr, 10) : 1;
+    std::string graphName = argc > 4 ? argv[4] : std::string(generatorKindName(options.kind)) + "_" + argv[1];
+
+    GraphModel model;
+    if (std::ifstream(filename).good() && !model.loadFromFile(filename, true))
+        return 1;
+
+    auto start = std::chrono::steady_clock::now();
+    if (!generateGraph(model, graphName, options))
+        return 1;
+    auto generated = std::chrono::steady_clock::now();
+    if (!model.saveToFile(filename))
+        return 1;
+    auto saved = std::chrono::steady_clock::now();
+
+    auto graph = model.getGraph(graphName);
+    printf("%s: %zu nodes, %zu edges, generated in %.1f ms, saved in %.1f ms\n", graphName.c_str(),
+        graph->nodes.size(), graph->edges.size(),
+        std::chrono::duration<double, std::milli>(generated - start).count(),
+        std::chrono::duration<double, std::milli>(saved - generated).count());
+    return 0;
+}
+
 // Helper functions
 bool CreateDeviceD3D(HWND hWnd)
 {